@@ -0,0 +1,255 @@
+/*!
+    Benchmarks for the interpreter, run on the desktop console build.
+    Runs the terminating example programs and reports the cost of each
+    executed command, then compares the two ways the VM can dispatch
+    instructions on the same programs, and measures allocator contention
+    across threads.
+
+    Usage: bench_exec [max threads]
+*/
+#if !defined(ARDUINO)
+
+// Only warnings and above are compiled into the benchmark
+#define KTY_LOG_LEVEL KTY_LOG_LEVEL_WARNING
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+#include "ArduinoUnit.h"
+#include "ArduinoUnitMock.h"
+
+CppIOStream Serial;
+
+#include <kitty.hpp>
+#include <test/mock_arduino.hpp>
+#include <test/mock_arduino_log.hpp>
+MockArduinoLog Log;
+
+#include <kty/containers/allocator.hpp>
+#include <kty/containers/concurrent_allocator.hpp>
+#include <kty/containers/string.hpp>
+#include <kty/containers/stringpool.hpp>
+#include <kty/analyzer.hpp>
+#include <kty/interpreter.hpp>
+
+using namespace std;
+using namespace kty;
+
+Allocator<>         alloc;
+StringPool<>        stringPool;
+GetAllocInit<>      getAllocInit(alloc);
+GetStringPoolInit<> getStringPoolInit(stringPool);
+
+Analyzer<>          analyzer;
+
+/** Example programs which terminate on their own */
+char const * BENCH_PROGRAMS[] = {
+    "examples/prime.kitty",
+    "examples/fizz_buzz_1.kitty",
+    "examples/fizz_buzz_2.kitty",
+    "examples/fizz_buzz_3.kitty",
+};
+
+/*!
+    @brief  Runs every line of a program through a fresh interpreter.
+
+    @param  path
+            The path to the program.
+
+    @param  numCommands
+            Where to save the number of commands executed.
+
+    @param  isThreaded
+            Whether the VM dispatches with computed gotos or a switch.
+
+    @return The number of calls made to the allocator while running the program.
+*/
+long run_program(char const * path, long & numCommands, bool isThreaded = KTY_VM_THREADED) {
+    ifstream file(path);
+    Interpreter<> interpreter;
+    PoolString<> command;
+    string line;
+
+    interpreter.set_threaded_dispatch(isThreaded);
+    alloc.reset_stat();
+    while (getline(file, line)) {
+        command = line.c_str();
+        if (analyzer.analyze(command) != AnalysisResult::ERROR) {
+            interpreter.execute(command);
+        }
+    }
+    numCommands = interpreter.num_commands_executed();
+    // Gives the strings of the groups back, so programs can be run again
+    interpreter.reset();
+    return alloc.num_allocate_calls();
+}
+
+/** Number of times each program is run per dispatch mode, keeping the fastest */
+const int DISPATCH_RUNS = 5;
+
+/*!
+    @brief  Runs a program with its output discarded.
+
+    @param  path
+            The path to the program.
+
+    @param  isThreaded
+            Whether the VM dispatches with computed gotos or a switch.
+
+    @return The time taken per executed command, in us.
+*/
+double time_program(char const * path, bool const & isThreaded) {
+    long numCommands = 0;
+    // Programs print as they run, which is not part of the benchmark output
+    stringstream discarded;
+    streambuf * coutBuf = cout.rdbuf(discarded.rdbuf());
+    auto start = chrono::steady_clock::now();
+    run_program(path, numCommands, isThreaded);
+    auto end = chrono::steady_clock::now();
+    cout.rdbuf(coutBuf);
+    return chrono::duration<double, micro>(end - start).count() / numCommands;
+}
+
+/*!
+    @brief  Compares switch and computed goto dispatch of the VM on every
+            program. Both modes take turns, so that noise on the machine
+            affects them alike.
+*/
+void bench_dispatch() {
+    if (!KTY_VM_THREADED) {
+        cout << "Computed goto dispatch is not available in this build" << endl;
+        return;
+    }
+    cout << "program, us per command switch, us per command threaded" << endl;
+    for (char const * path : BENCH_PROGRAMS) {
+        double switchUs = 0;
+        double threadedUs = 0;
+        for (int i = 0; i < DISPATCH_RUNS; ++i) {
+            double us = time_program(path, false);
+            switchUs = i == 0 || us < switchUs ? us : switchUs;
+            us = time_program(path, true);
+            threadedUs = i == 0 || us < threadedUs ? us : threadedUs;
+        }
+        cout << path << ", " << switchUs << ", " << threadedUs << endl;
+    }
+}
+
+/** Number of blocks each thread holds at once in the contention benchmark */
+const int CONTENTION_BLOCKS_HELD = 4;
+/** Number of times each thread allocates and deallocates its blocks */
+const int CONTENTION_ROUNDS = 100000;
+
+/*!
+    @brief  Has every thread repeatedly allocate and deallocate a few blocks.
+
+    @param  numThreads
+            The number of threads to run.
+
+    @param  getAlloc
+            Returns the allocator to use on the calling thread.
+
+    @param  mutex
+            A mutex to hold around every allocator call, or nullptr for none.
+
+    @return The average time taken per allocate or deallocate call, in ns.
+*/
+template <typename GetAlloc>
+double run_contention(int const & numThreads, GetAlloc getAlloc, mutex * mutex) {
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&]() {
+            auto & threadAlloc = *getAlloc();
+            void * held[CONTENTION_BLOCKS_HELD];
+            for (int round = 0; round < CONTENTION_ROUNDS; ++round) {
+                for (int i = 0; i < CONTENTION_BLOCKS_HELD; ++i) {
+                    if (mutex != nullptr) {
+                        lock_guard<std::mutex> lock(*mutex);
+                        held[i] = threadAlloc.allocate();
+                    }
+                    else {
+                        held[i] = threadAlloc.allocate();
+                    }
+                }
+                for (int i = 0; i < CONTENTION_BLOCKS_HELD; ++i) {
+                    if (mutex != nullptr) {
+                        lock_guard<std::mutex> lock(*mutex);
+                        threadAlloc.deallocate(held[i]);
+                    }
+                    else {
+                        threadAlloc.deallocate(held[i]);
+                    }
+                }
+            }
+        });
+    }
+    for (thread & thread : threads) {
+        thread.join();
+    }
+    auto end = chrono::steady_clock::now();
+    double numCalls = 2.0 * numThreads * CONTENTION_ROUNDS * CONTENTION_BLOCKS_HELD;
+    return chrono::duration<double, nano>(end - start).count() / numCalls;
+}
+
+/*!
+    @brief  Compares a shared allocator behind a mutex, a shared lock-free
+            allocator and one allocator per thread, from 1 to maxThreads threads.
+
+    @param  maxThreads
+            The largest number of threads to run.
+*/
+void bench_contention(int const & maxThreads) {
+    static Allocator<>           sharedAlloc;
+    static ConcurrentAllocator<> concurrentAlloc;
+    mutex sharedMutex;
+
+    cout << "threads, ns per call mutex allocator, ns per call concurrent allocator, ns per call thread allocator" << endl;
+    for (int numThreads = 1; numThreads <= maxThreads; ++numThreads) {
+        double mutexNs = run_contention(numThreads, []() { return &sharedAlloc; }, &sharedMutex);
+        double concurrentNs = run_contention(numThreads, []() { return &concurrentAlloc; }, nullptr);
+        double threadNs = run_contention(numThreads, []() { return get_thread_alloc(); }, nullptr);
+        cout << numThreads << ", " << mutexNs << ", " << concurrentNs << ", " << threadNs << endl;
+    }
+}
+
+int main(int argc, char * argv[]) {
+    int maxThreads = argc > 1 ? atoi(argv[1]) : thread::hardware_concurrency();
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    cout << "program, commands, allocate calls, allocate calls per command, us per command" << endl;
+    for (char const * path : BENCH_PROGRAMS) {
+        long numCommands = 0;
+        // Programs print as they run, which is not part of the benchmark output
+        stringstream discarded;
+        streambuf * coutBuf = cout.rdbuf(discarded.rdbuf());
+        auto start = chrono::steady_clock::now();
+        long numAllocateCalls = run_program(path, numCommands);
+        auto end = chrono::steady_clock::now();
+        cout.rdbuf(coutBuf);
+
+        double us = chrono::duration<double, micro>(end - start).count();
+        cout << path << ", " << numCommands << ", " << numAllocateCalls << ", "
+             << (double)numAllocateCalls / numCommands << ", "
+             << us / numCommands << endl;
+    }
+
+    cout << endl;
+    bench_dispatch();
+
+    cout << endl;
+    bench_contention(maxThreads);
+    return 0;
+}
+
+#endif
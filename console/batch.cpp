@@ -0,0 +1,301 @@
+/*!
+    Batch runner for the desktop, in order to validate many scripts at once.
+    Every script runs in its own interpreter with its own memory, on a pool
+    of worker threads. The output of each script is captured and printed in
+    the order the scripts were given, followed by a throughput summary.
+    Waits run on a virtual clock, so a script with waits finishes as soon as
+    its commands have run, with the same output as in real time.
+
+    Scripts which keep running, e.g. by running a group forever, are cut
+    off once they reach their limits, and their output says so.
+
+    Usage: batch_exec [-j threads] [-n seeds] [-t ms] [-c commands] script.kitty...
+        -j  Number of worker threads, defaults to the number of cores.
+        -n  Runs every script once per seed 0 to n - 1. The seed is
+            available to the script as the number "seed".
+        -t  Virtual time after which a script is cut off,
+            defaults to 60000 ms.
+        -c  Number of commands after which a script is cut off,
+            defaults to 1000000.
+*/
+#if !defined(ARDUINO)
+
+// Scripts report their errors through Serial, which is captured per script
+#define KTY_LOG_LEVEL KTY_LOG_LEVEL_SILENT
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#define F(string) string
+
+#include <console/script_serial.hpp>
+
+ScriptSerial Serial;
+
+/** Virtual time of the script run by this thread */
+thread_local unsigned long scriptTimeMs = 0;
+
+/*!
+    @brief  Clock of the scripts, moved straight to the next deadline
+            whenever a script waits.
+
+    @return The virtual time of the script run by this thread.
+*/
+unsigned long millis() {
+    return scriptTimeMs;
+}
+
+#include <kitty.hpp>
+#include <test/mock_arduino.hpp>
+
+#include <kty/containers/allocator.hpp>
+#include <kty/containers/string.hpp>
+#include <kty/containers/stringpool.hpp>
+#include <kty/analyzer.hpp>
+#include <kty/interpreter.hpp>
+#include <kty/runtime.hpp>
+
+using namespace std;
+using namespace kty;
+
+/** A script to run, and the seed to run it with */
+struct Job {
+    /** Index of the script in the list of scripts */
+    int script;
+    /** The seed, or -1 if the script is run without one */
+    int seed;
+};
+
+/** How long a script may keep running */
+struct Limits {
+    /** Virtual time in milliseconds */
+    unsigned long timeMs;
+    /** Number of commands executed */
+    long numCommands;
+};
+
+/** The result of running a job */
+struct JobResult {
+    /** Everything the script printed */
+    string output;
+    /** The number of commands executed */
+    long numCommands;
+    /** The virtual time the script ran for */
+    unsigned long timeMs;
+    /** Whether the script was cut off by its limits */
+    bool isCutOff;
+};
+
+/*!
+    @brief  Runs the commands left over by the command budget, and
+            optionally the parked commands as well, skipping their waits
+            instead of sleeping through them.
+
+    @param  interpreter
+            The interpreter.
+
+    @param  isParkedToo
+            True to run until nothing is parked either,
+            false to run until nothing is ready to run.
+
+    @param  limits
+            How long the script may keep running.
+
+    @return False if the script reached its limits, true otherwise.
+*/
+bool run_left_over(Interpreter<> & interpreter, bool const & isParkedToo, Limits const & limits) {
+    while (isParkedToo ? interpreter.is_waiting() : interpreter.is_busy()) {
+        unsigned long timeLeft = interpreter.time_until_next_event();
+        if (scriptTimeMs + timeLeft > limits.timeMs ||
+            interpreter.num_commands_executed() >= limits.numCommands) {
+            return false;
+        }
+        scriptTimeMs += timeLeft;
+        interpreter.update();
+    }
+    return true;
+}
+
+/*!
+    @brief  Runs a script in a fresh interpreter, with its own memory.
+
+    @param  lines
+            The lines of the script.
+
+    @param  seed
+            The seed to define before running the script, or -1 for none.
+
+    @param  limits
+            How long the script may keep running.
+
+    @param  result
+            Where to save the output, number of commands executed,
+            and whether the script was cut off.
+*/
+void run_job(vector<string> const & lines, int const & seed, Limits const & limits, JobResult & result) {
+    unique_ptr<Allocator<>>  alloc(new Allocator<>());
+    unique_ptr<StringPool<>> stringPool(new StringPool<>());
+    Runtime<>     runtime(*alloc, *stringPool);
+    Analyzer<>    analyzer(runtime);
+    Interpreter<> interpreter(runtime);
+    PoolString<>  command(runtime.stringpool());
+    // Long running commands hand control back, so the limits can be checked
+    interpreter.set_command_budget(Sizes::command_budget);
+    scriptTimeMs = 0;
+
+    ostringstream output;
+    scriptOutput = &output;
+    if (seed >= 0) {
+        command = ("seed IsNumber(" + to_string(seed) + ")").c_str();
+        interpreter.execute(command);
+    }
+    // Every line runs until it is done or parked before the next one,
+    // as it would without a command budget
+    bool isWithinLimits = true;
+    for (size_t i = 0; i < lines.size() && isWithinLimits; ++i) {
+        command = lines[i].c_str();
+        if (analyzer.analyze(command) != AnalysisResult::ERROR) {
+            interpreter.execute(command);
+            isWithinLimits = run_left_over(interpreter, false, limits);
+        }
+    }
+    if (isWithinLimits) {
+        isWithinLimits = run_left_over(interpreter, true, limits);
+    }
+    if (!isWithinLimits) {
+        interpreter.abort();
+    }
+    scriptOutput = nullptr;
+
+    result.output = output.str();
+    result.numCommands = interpreter.num_commands_executed();
+    result.timeMs = scriptTimeMs;
+    result.isCutOff = !isWithinLimits;
+}
+
+/*!
+    @brief  Reads all the lines of a script.
+
+    @param  path
+            The path to the script.
+
+    @param  lines
+            Where to save the lines.
+
+    @return True if the script could be read, false otherwise.
+*/
+bool read_script(char const * path, vector<string> & lines) {
+    ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    string line;
+    while (getline(file, line)) {
+        lines.push_back(line);
+    }
+    return true;
+}
+
+int main(int argc, char * argv[]) {
+    int numThreads = thread::hardware_concurrency();
+    int numSeeds = 0;
+    Limits limits = {60000, 1000000};
+    vector<char const *> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            numSeeds = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            limits.timeMs = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            limits.numCommands = atol(argv[++i]);
+        }
+        else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        cerr << "Usage: " << argv[0] << " [-j threads] [-n seeds] [-t ms] [-c commands] script.kitty..." << endl;
+        return 1;
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+
+    vector<vector<string>> scripts(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!read_script(paths[i], scripts[i])) {
+            cerr << "Could not read " << paths[i] << endl;
+            return 1;
+        }
+    }
+    vector<Job> jobs;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (numSeeds > 0) {
+            for (int seed = 0; seed < numSeeds; ++seed) {
+                jobs.push_back(Job{(int)i, seed});
+            }
+        }
+        else {
+            jobs.push_back(Job{(int)i, -1});
+        }
+    }
+    vector<JobResult> results(jobs.size());
+
+    // Workers take the next job until there are none left
+    auto start = chrono::steady_clock::now();
+    atomic<size_t> nextJob(0);
+    vector<thread> workers;
+    for (int i = 0; i < numThreads; ++i) {
+        workers.emplace_back([&]() {
+            for (size_t job = nextJob++; job < jobs.size(); job = nextJob++) {
+                run_job(scripts[jobs[job].script], jobs[job].seed, limits, results[job]);
+            }
+        });
+    }
+    for (thread & worker : workers) {
+        worker.join();
+    }
+    auto end = chrono::steady_clock::now();
+
+    // Outputs are merged in the order the jobs were given
+    long numCommands = 0;
+    int numCutOff = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        cout << "=== " << paths[jobs[i].script];
+        if (jobs[i].seed >= 0) {
+            cout << " (seed " << jobs[i].seed << ")";
+        }
+        cout << " ===" << endl << results[i].output;
+        if (results[i].isCutOff) {
+            cout << "=== cut off after " << results[i].timeMs << " ms, "
+                 << results[i].numCommands << " commands ===" << endl;
+            ++numCutOff;
+        }
+        numCommands += results[i].numCommands;
+    }
+
+    double seconds = chrono::duration<double>(end - start).count();
+    cout << "=== " << jobs.size() << " scripts, " << numCutOff << " cut off, " << numCommands << " commands, "
+         << numThreads << " threads, " << seconds << " s, "
+         << jobs.size() / seconds << " scripts/s, "
+         << numCommands / seconds << " commands/s ===" << endl;
+    return 0;
+}
+
+#endif
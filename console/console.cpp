@@ -4,12 +4,18 @@
 */
 #if !defined(ARDUINO)
 
+// Verbose and trace logging is compiled out of this build
+#define KTY_LOG_LEVEL KTY_LOG_LEVEL_NOTICE
+
 #include <iostream>
 #include <string>
 
+#include <poll.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
 #include "ArduinoUnit.h"
 #include "ArduinoUnitMock.h"
 
@@ -42,6 +48,20 @@ string              strCommand;
 PoolString<>        command;
 PoolString<>        prefix;
 
+/** Set by the signal handler when Ctrl-C is pressed */
+volatile sig_atomic_t abortRequested = 0;
+
+/*!
+    @brief  Asks for everything that is running to stop on Ctrl-C,
+            instead of quitting the console.
+
+    @param  signal
+            The signal received.
+*/
+void handle_abort(int signal) {
+    abortRequested = 1;
+}
+
 int main(void) {
     Log.to_log_notice(true);
     Log.to_log_warning(true);
@@ -49,15 +69,54 @@ int main(void) {
     
     alloc.dump_addresses();
     stringPool.dump_addresses();
+    signal(SIGINT, handle_abort);
+    interpreter.set_command_budget(Sizes::command_budget);
 
-    while (1) {
-        prefix = interpreter.get_prompt_prefix();
-        cout << prefix.c_str() << ">>> ";
-        getline(cin, strCommand);
-        command = strCommand.c_str();
-        analysisResult = analyzer.analyze(command);
-        if (analysisResult != AnalysisResult::ERROR) {
-            interpreter.execute(command);
+    prefix = interpreter.get_prompt_prefix();
+    cout << prefix.c_str() << ">>> " << flush;
+    // Sleeps until a line is typed or parked commands are due,
+    // and runs until the input is closed and nothing is left to run.
+    // Long running commands hand control back after every command budget,
+    // so Ctrl-C can stop them. Lines typed in the meantime run straight away,
+    // taking turns with what is running, while lines of a script piped in
+    // run once the ones before them are done.
+    bool isTyped = isatty(STDIN_FILENO);
+    string input;
+    bool inputClosed = false;
+    while (!inputClosed || interpreter.is_waiting()) {
+        pollfd stdinPoll = {STDIN_FILENO, POLLIN, 0};
+        poll(&stdinPoll, inputClosed ? 0 : 1, interpreter.time_until_next_event());
+        if (abortRequested) {
+            abortRequested = 0;
+            interpreter.abort();
+            input.clear();
+            prefix = interpreter.get_prompt_prefix();
+            cout << endl << prefix.c_str() << ">>> " << flush;
+            continue;
+        }
+        interpreter.update();
+        if (stdinPoll.revents & (POLLIN | POLLHUP)) {
+            char buffer[256];
+            ssize_t numRead = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (numRead > 0) {
+                input.append(buffer, numRead);
+            }
+            else {
+                inputClosed = true;
+                input += '\n';
+            }
+        }
+        size_t lineEnd;
+        while ((isTyped || !interpreter.is_busy()) && (lineEnd = input.find('\n')) != string::npos) {
+            strCommand = input.substr(0, lineEnd);
+            input.erase(0, lineEnd + 1);
+            command = strCommand.c_str();
+            analysisResult = analyzer.analyze(command);
+            if (analysisResult != AnalysisResult::ERROR) {
+                interpreter.execute(command);
+            }
+            prefix = interpreter.get_prompt_prefix();
+            cout << prefix.c_str() << ">>> " << flush;
         }
     }
 
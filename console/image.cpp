@@ -0,0 +1,122 @@
+/*!
+    Makes a precompiled image of a script, which the preloaded interpreter
+    and preloaded console load at startup instead of entering the commands
+    of the script one by one.
+
+    Usage: image_exec [-c] script.kitty output
+        -c  Writes the image as C source for preloaded_interpreter.ino,
+            an array called SCRIPT_IMAGE kept in program memory, instead of
+            as a binary file.
+*/
+#if !defined(ARDUINO)
+
+// Errors in the script are reported through Serial
+#define KTY_LOG_LEVEL KTY_LOG_LEVEL_SILENT
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ArduinoUnit.h"
+#include "ArduinoUnitMock.h"
+
+CppIOStream Serial;
+
+#include <kitty.hpp>
+#include <test/mock_arduino.hpp>
+#include <test/mock_arduino_log.hpp>
+MockArduinoLog Log;
+
+#include <kty/containers/allocator.hpp>
+#include <kty/containers/string.hpp>
+#include <kty/containers/stringpool.hpp>
+#include <kty/analyzer.hpp>
+#include <kty/image_builder.hpp>
+
+using namespace std;
+using namespace kty;
+
+Allocator<>         alloc;
+StringPool<>        stringPool;
+GetAllocInit<>      getAllocInit(alloc);
+GetStringPoolInit<> getStringPoolInit(stringPool);
+
+/*!
+    @brief  Keeps the bytes of an image in memory.
+*/
+struct ImageBytes {
+    vector<unsigned char> bytes;
+
+    void write(unsigned char const & byte) {
+        bytes.push_back(byte);
+    }
+};
+
+/*!
+    @brief  Writes an image as C source, for pasting into a sketch.
+
+    @param  file
+            Where to write the source.
+
+    @param  bytes
+            The image.
+
+    @param  scriptPath
+            The path to the script the image was made from.
+*/
+void write_source(ofstream & file, vector<unsigned char> const & bytes, char const * scriptPath) {
+    file << "// Made from " << scriptPath << " by image_exec, do not edit\n";
+    file << "const unsigned char SCRIPT_IMAGE[] PROGMEM = {";
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        char hex[8];
+        snprintf(hex, sizeof(hex), "0x%02x,", bytes[i]);
+        file << (i % 12 == 0 ? "\n    " : " ") << hex;
+    }
+    file << "\n};\n";
+}
+
+int main(int argc, char * argv[]) {
+    bool isSource = argc == 4 && strcmp(argv[1], "-c") == 0;
+    if (argc != 3 && !isSource) {
+        cerr << "Usage: " << argv[0] << " [-c] script.kitty output" << endl;
+        return 1;
+    }
+    char const * scriptPath = argv[argc - 2];
+    char const * outputPath = argv[argc - 1];
+
+    ifstream script(scriptPath);
+    if (!script) {
+        cerr << "Unable to read " << scriptPath << endl;
+        return 1;
+    }
+    Analyzer<>     analyzer;
+    ImageBuilder<> builder;
+    PoolString<>   command;
+    string         line;
+    while (getline(script, line)) {
+        command = line.c_str();
+        if (analyzer.analyze(command) != AnalysisResult::ERROR) {
+            builder.add(command);
+        }
+    }
+    ImageBytes image;
+    builder.write(image);
+
+    ofstream output(outputPath, ios::binary);
+    if (isSource) {
+        write_source(output, image.bytes, scriptPath);
+    }
+    else {
+        output.write(reinterpret_cast<char const *>(image.bytes.data()), image.bytes.size());
+    }
+    if (!output) {
+        cerr << "Unable to write " << outputPath << endl;
+        return 1;
+    }
+    cout << "Wrote " << image.bytes.size() << " bytes of image to " << outputPath << endl;
+    return 0;
+}
+
+#endif
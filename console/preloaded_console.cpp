@@ -1,6 +1,10 @@
 /*!
     Console version of live interpreter, in order to run commands
     manually without worry of running out of memory.
+
+    Usage: preloaded_console_exec [image]
+        Runs the commands below at startup, or instead loads an image made
+        by image_exec, which is mapped into memory rather than read.
 */
 #if !defined(ARDUINO)
 
@@ -40,12 +44,21 @@ num_times IsNumber(10)
 loop_nums RunGroup(num_times)
 )";
 
+// Verbose and trace logging is compiled out of this build
+#define KTY_LOG_LEVEL KTY_LOG_LEVEL_NOTICE
+
 #include <iostream>
 #include <string>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
 #include "ArduinoUnit.h"
 #include "ArduinoUnitMock.h"
 
@@ -60,6 +73,7 @@ MockArduinoLog Log;
 #include <kty/containers/string.hpp>
 #include <kty/containers/stringpool.hpp>
 #include <kty/analyzer.hpp>
+#include <kty/image.hpp>
 #include <kty/interpreter.hpp>
 
 using namespace std;
@@ -78,6 +92,20 @@ string              strCommand;
 PoolString<>        command;
 PoolString<>        prefix;
 
+/** Set by the signal handler when Ctrl-C is pressed */
+volatile sig_atomic_t abortRequested = 0;
+
+/*!
+    @brief  Asks for everything that is running to stop on Ctrl-C,
+            instead of quitting the console.
+
+    @param  signal
+            The signal received.
+*/
+void handle_abort(int signal) {
+    abortRequested = 1;
+}
+
 /*! 
     @brief  Reads characters from the buffer until it has a full command, 
             then saves it in the variable command.
@@ -110,33 +138,125 @@ int get_next_command(char const * buffer, int const & startIdx, PoolString<declt
     return i;
 }
 
-int main(void) {
+/*!
+    @brief  Loads an image of a script, and runs the commands which follow
+            its declarations.
+
+    @param  path
+            The path to the image.
+
+    @return True if successful, false otherwise.
+*/
+bool run_image(char const * path) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+        cerr << "Unable to read " << path << endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    void * data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        cerr << "Unable to map " << path << endl;
+        return false;
+    }
+    ImageReader image(static_cast<unsigned char const *>(data), info.st_size);
+    bool isLoaded = interpreter.load_image(image);
+    if (!isLoaded) {
+        cerr << path << " is not an image of version " << (int)imageVersion << ", or is corrupt" << endl;
+    }
+    char buffer[Sizes::string_length + 1];
+    while (isLoaded && !image.is_end()) {
+        prefix = interpreter.get_prompt_prefix();
+        image.read_str(buffer, sizeof(buffer));
+        command = buffer;
+        cout << prefix.c_str() << ">>> " << command.c_str() << endl;
+        // Each preloaded command runs once the one before it is done
+        while (interpreter.is_busy() && !abortRequested) {
+            interpreter.update();
+        }
+        interpreter.execute(command);
+    }
+    munmap(data, info.st_size);
+    return isLoaded;
+}
+
+int main(int argc, char * argv[]) {
     Log.to_log_notice(true);
     Log.to_log_warning(true);
     Log.to_log_error(true);
 
     alloc.dump_addresses();
     stringPool.dump_addresses();
+    signal(SIGINT, handle_abort);
+    interpreter.set_command_budget(Sizes::command_budget);
 
+    if (argc > 1 && !run_image(argv[1])) {
+        return 1;
+    }
     int startIdx = 0;
-    while (COMMANDS[startIdx] != '\0') {
+    while (argc == 1 && COMMANDS[startIdx] != '\0') {
         prefix = interpreter.get_prompt_prefix();
         startIdx = get_next_command(COMMANDS, startIdx, command);
         analysisResult = analyzer.analyze(command);
         if (analysisResult != AnalysisResult::ERROR) {
             cout << prefix.c_str() << ">>> " << command.c_str() << endl;
+            // Each preloaded command runs once the one before it is done
+            while (interpreter.is_busy() && !abortRequested) {
+                interpreter.update();
+            }
             interpreter.execute(command);
         }
     }
 
-    while (1) {
-        prefix = interpreter.get_prompt_prefix();
-        cout << prefix.c_str() << ">>> ";
-        getline(cin, strCommand);
-        command = strCommand.c_str();
-        analysisResult = analyzer.analyze(command);
-        if (analysisResult != AnalysisResult::ERROR) {
-            interpreter.execute(command);
+    prefix = interpreter.get_prompt_prefix();
+    cout << prefix.c_str() << ">>> " << flush;
+    // Sleeps until a line is typed or parked commands are due,
+    // and runs until the input is closed and nothing is left to run.
+    // Long running commands hand control back after every command budget,
+    // so Ctrl-C can stop them. Lines typed in the meantime run straight away,
+    // taking turns with what is running, while lines of a script piped in
+    // run once the ones before them are done.
+    bool isTyped = isatty(STDIN_FILENO);
+    string input;
+    bool inputClosed = false;
+    while (!inputClosed || interpreter.is_waiting()) {
+        pollfd stdinPoll = {STDIN_FILENO, POLLIN, 0};
+        poll(&stdinPoll, inputClosed ? 0 : 1, interpreter.time_until_next_event());
+        if (abortRequested) {
+            abortRequested = 0;
+            interpreter.abort();
+            input.clear();
+            prefix = interpreter.get_prompt_prefix();
+            cout << endl << prefix.c_str() << ">>> " << flush;
+            continue;
+        }
+        interpreter.update();
+        if (stdinPoll.revents & (POLLIN | POLLHUP)) {
+            char buffer[256];
+            ssize_t numRead = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (numRead > 0) {
+                input.append(buffer, numRead);
+            }
+            else {
+                inputClosed = true;
+                input += '\n';
+            }
+        }
+        size_t lineEnd;
+        while ((isTyped || !interpreter.is_busy()) && (lineEnd = input.find('\n')) != string::npos) {
+            strCommand = input.substr(0, lineEnd);
+            input.erase(0, lineEnd + 1);
+            command = strCommand.c_str();
+            analysisResult = analyzer.analyze(command);
+            if (analysisResult != AnalysisResult::ERROR) {
+                interpreter.execute(command);
+            }
+            prefix = interpreter.get_prompt_prefix();
+            cout << prefix.c_str() << ">>> " << flush;
         }
     }
 
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <sstream>
+
+/** The output of the script running on the current thread */
+thread_local std::ostringstream * scriptOutput = nullptr;
+
+/*!
+    @brief  Replacement for the Arduino Serial object, which writes to the
+            output of the script running on the calling thread.
+            Set scriptOutput before running a script to capture its output.
+*/
+class ScriptSerial {
+
+public:
+    /*!
+        @brief  Prints a value.
+
+        @param  value
+                The value to print.
+    */
+    template <typename T>
+    void print(T const & value) {
+        *scriptOutput << value;
+    }
+
+    /*!
+        @brief  Prints a value followed by a newline.
+
+        @param  value
+                The value to print.
+    */
+    template <typename T>
+    void println(T const & value) {
+        *scriptOutput << value << '\n';
+    }
+
+};
@@ -0,0 +1,436 @@
+/*!
+    Daemon version of the console, in order to run many short scripts without
+    paying for process startup and pool construction on each one.
+    Keeps a pool of warm interpreters, each with its own memory, and serves
+    clients over a Unix domain socket, multiplexed with epoll.
+
+    Every client gets an interpreter for as long as it stays connected.
+    Each line the client sends is run as a command, and its output is sent
+    back as soon as it has run. Commands parked by waits continue in real
+    time, and their output is sent as well. A whole script can be sent at
+    once, and the connection is closed once the client has closed its side,
+    nothing is parked any more and all output is sent. The interpreter is
+    reset before it goes back into the pool.
+    Commands which run for long, e.g. a group run forever, share the time
+    with the other clients, a command budget at a time.
+
+    Usage: server_exec [-n interpreters] socket_path
+        -n  Number of warm interpreters, which is also the maximum number
+            of clients served at once. Further clients wait for a free
+            interpreter. Defaults to 4.
+
+    Example client: socat - UNIX-CONNECT:socket_path < script.kitty
+*/
+#if !defined(ARDUINO)
+
+// Scripts report their errors through Serial, which is captured per client
+#define KTY_LOG_LEVEL KTY_LOG_LEVEL_SILENT
+
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define F(string) string
+
+#include <console/script_serial.hpp>
+
+ScriptSerial Serial;
+
+/*!
+    @brief  Clock of the interpreters.
+
+    @return The number of milliseconds since the server started.
+*/
+unsigned long millis() {
+    static std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+#include <kitty.hpp>
+#include <test/mock_arduino.hpp>
+
+#include <kty/containers/allocator.hpp>
+#include <kty/containers/string.hpp>
+#include <kty/containers/stringpool.hpp>
+#include <kty/analyzer.hpp>
+#include <kty/interpreter.hpp>
+#include <kty/runtime.hpp>
+
+using namespace std;
+using namespace kty;
+
+/** Maximum number of events handled per call to epoll_wait */
+const int MAX_EVENTS = 64;
+/** Size of the buffer used to read from clients */
+const int READ_BUFFER_SIZE = 4096;
+
+/** Set by the signal handler when the server should stop */
+volatile sig_atomic_t stopRequested = 0;
+
+/*!
+    @brief  A warm interpreter, together with its own memory.
+            Constructed once when the server starts.
+*/
+struct Slot {
+    Allocator<>   alloc;
+    StringPool<>  stringPool;
+    Runtime<>     runtime;
+    Analyzer<>    analyzer;
+    Interpreter<> interpreter;
+    PoolString<>  command;
+
+    Slot()
+        : runtime(alloc, stringPool), analyzer(runtime), interpreter(runtime),
+          command(runtime.stringpool()) {
+        // Long running commands hand control back after every command budget,
+        // so the other clients get their turn in between
+        interpreter.set_command_budget(Sizes::command_budget);
+    }
+};
+
+/** A connected client */
+struct Client {
+    /** The interpreter serving this client */
+    Slot * slot;
+    /** Received characters which do not make up a complete line yet */
+    string input;
+    /** Output which could not be sent yet */
+    string output;
+    /** Whether the client has closed its side of the connection */
+    bool closing;
+    /** Whether the connection has failed */
+    bool failed;
+    /** The events the client socket is registered for */
+    uint32_t events;
+};
+
+/*!
+    @brief  Stops the server on SIGINT or SIGTERM.
+
+    @param  signal
+            The signal received.
+*/
+void handle_stop(int signal) {
+    stopRequested = 1;
+}
+
+/*!
+    @brief  Sets a file descriptor to non-blocking mode.
+
+    @param  fd
+            The file descriptor.
+
+    @return True if successful, false otherwise.
+*/
+bool set_non_blocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+/*!
+    @brief  Runs a single line in the interpreter of a client,
+            and queues its output to be sent.
+
+    @param  client
+            The client which sent the line.
+
+    @param  line
+            The line to run.
+*/
+void run_line(Client & client, string const & line) {
+    Slot & slot = *client.slot;
+    ostringstream output;
+    scriptOutput = &output;
+    slot.command = line.c_str();
+    if (slot.analyzer.analyze(slot.command) != AnalysisResult::ERROR) {
+        slot.interpreter.execute(slot.command);
+    }
+    scriptOutput = nullptr;
+    client.output += output.str();
+}
+
+/*!
+    @brief  Continues the parked commands of a client which are due,
+            and queues their output to be sent.
+
+    @param  client
+            The client.
+*/
+void run_due(Client & client) {
+    ostringstream output;
+    scriptOutput = &output;
+    client.slot->interpreter.update();
+    scriptOutput = nullptr;
+    client.output += output.str();
+}
+
+/*!
+    @brief  Checks if everything has been done for a client which closed its
+            side of the connection.
+
+    @param  client
+            The client.
+
+    @return True if the connection can be closed, false otherwise.
+*/
+bool is_done(Client const & client) {
+    return client.closing && client.output.empty() && !client.slot->interpreter.is_waiting();
+}
+
+/*!
+    @brief  Sends as much queued output to a client as the socket accepts.
+
+    @param  fd
+            The client socket.
+
+    @param  client
+            The client.
+
+    @return False if the connection failed, true otherwise.
+*/
+bool send_output(int fd, Client & client) {
+    while (!client.output.empty()) {
+        ssize_t sent = send(fd, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+        if (sent < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        client.output.erase(0, sent);
+    }
+    return true;
+}
+
+/*!
+    @brief  Reads everything available from a client and runs each complete line.
+
+    @param  fd
+            The client socket.
+
+    @param  client
+            The client.
+
+    @return False if the connection failed, true otherwise.
+*/
+bool receive_input(int fd, Client & client) {
+    char buffer[READ_BUFFER_SIZE];
+    while (true) {
+        ssize_t received = read(fd, buffer, sizeof(buffer));
+        if (received > 0) {
+            client.input.append(buffer, received);
+            continue;
+        }
+        if (received == 0) {
+            client.closing = true;
+        }
+        else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            return false;
+        }
+        break;
+    }
+    size_t lineEnd;
+    while ((lineEnd = client.input.find('\n')) != string::npos) {
+        run_line(client, client.input.substr(0, lineEnd));
+        client.input.erase(0, lineEnd + 1);
+    }
+    // The last line of a script may not end with a newline
+    if (client.closing && !client.input.empty()) {
+        run_line(client, client.input);
+        client.input.clear();
+    }
+    return true;
+}
+
+/*!
+    @brief  Hands free interpreters to the clients which have waited longest.
+
+    @param  epollFd
+            The epoll instance to register the clients with.
+
+    @param  waitingClients
+            The client sockets waiting for an interpreter.
+
+    @param  freeSlots
+            The free interpreters.
+
+    @param  clients
+            The clients being served.
+*/
+void serve_waiting_clients(int epollFd, deque<int> & waitingClients, vector<Slot *> & freeSlots, map<int, Client> & clients) {
+    while (!waitingClients.empty() && !freeSlots.empty()) {
+        int fd = waitingClients.front();
+        waitingClients.pop_front();
+        clients[fd] = Client{freeSlots.back(), "", "", false, false, EPOLLIN};
+        freeSlots.pop_back();
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+/*!
+    @brief  Creates the listening Unix domain socket.
+
+    @param  path
+            The path of the socket.
+
+    @return The socket, or -1 if it could not be created.
+*/
+int create_server_socket(char const * path) {
+    sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        cerr << "Socket path is too long" << endl;
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        perror("socket");
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+    if (bind(fd, (sockaddr *)&address, sizeof(address)) == -1 ||
+        listen(fd, SOMAXCONN) == -1 ||
+        !set_non_blocking(fd)) {
+        perror("bind");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char * argv[]) {
+    int numSlots = 4;
+    char const * path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            numSlots = atoi(argv[++i]);
+        }
+        else {
+            path = argv[i];
+        }
+    }
+    if (path == nullptr || numSlots < 1) {
+        cerr << "Usage: " << argv[0] << " [-n interpreters] socket_path" << endl;
+        return 1;
+    }
+
+    // All pools are constructed here, once, instead of once per script
+    vector<unique_ptr<Slot>> slots;
+    vector<Slot *> freeSlots;
+    for (int i = 0; i < numSlots; ++i) {
+        slots.emplace_back(new Slot());
+        freeSlots.push_back(slots.back().get());
+    }
+
+    int serverFd = create_server_socket(path);
+    if (serverFd == -1) {
+        return 1;
+    }
+    int epollFd = epoll_create1(0);
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = serverFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, serverFd, &event);
+
+    signal(SIGINT, handle_stop);
+    signal(SIGTERM, handle_stop);
+    cout << "Serving " << numSlots << " interpreters on " << path << endl;
+
+    map<int, Client> clients;
+    deque<int> waitingClients;
+    epoll_event events[MAX_EVENTS];
+    while (!stopRequested) {
+        // Wake up in time for the next parked commands of any client
+        long timeout = -1;
+        for (auto & client : clients) {
+            long timeLeft = client.second.slot->interpreter.time_until_next_event();
+            if (timeLeft != -1 && (timeout == -1 || timeLeft < timeout)) {
+                timeout = timeLeft;
+            }
+        }
+        int numEvents = epoll_wait(epollFd, events, MAX_EVENTS, timeout);
+        for (int i = 0; i < numEvents; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == serverFd) {
+                int clientFd;
+                while ((clientFd = accept(serverFd, nullptr, nullptr)) != -1) {
+                    if (!set_non_blocking(clientFd)) {
+                        close(clientFd);
+                        continue;
+                    }
+                    waitingClients.push_back(clientFd);
+                }
+                serve_waiting_clients(epollFd, waitingClients, freeSlots, clients);
+                continue;
+            }
+
+            Client & client = clients[fd];
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                client.failed = !receive_input(fd, client);
+            }
+            // Nobody is left to send the output of parked commands to
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                client.failed = true;
+            }
+        }
+
+        for (auto it = clients.begin(); it != clients.end(); ) {
+            int fd = it->first;
+            Client & client = it->second;
+            if (!client.failed) {
+                run_due(client);
+                client.failed = !send_output(fd, client);
+            }
+            if (client.failed || is_done(client)) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                close(fd);
+                client.slot->interpreter.reset();
+                freeSlots.push_back(client.slot);
+                it = clients.erase(it);
+                continue;
+            }
+            // Only wait for the socket to become writable while output is pending
+            uint32_t events = (client.closing ? 0 : EPOLLIN) | (client.output.empty() ? 0 : EPOLLOUT);
+            if (events != client.events) {
+                client.events = events;
+                event.events = events;
+                event.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+            }
+            ++it;
+        }
+        serve_waiting_clients(epollFd, waitingClients, freeSlots, clients);
+    }
+
+    for (auto & client : clients) {
+        close(client.first);
+    }
+    for (int fd : waitingClients) {
+        close(fd);
+    }
+    close(epollFd);
+    close(serverFd);
+    unlink(path);
+    return 0;
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <kty/containers/deque.hpp>
 #include <kty/containers/string.hpp>
 #include <kty/containers/stringpool.hpp>
+#include <kty/runtime.hpp>
 #include <kty/string_utils.hpp>
 #include <kty/types.hpp>
 
@@ -19,26 +20,28 @@ enum AnalysisResult {
 /*!
     @brief  Class that performs static analysis on commands.
 */
-template <typename GetAllocFunc = decltype(get_alloc), typename GetPoolFunc = decltype(get_stringpool), typename PoolString = PoolString<>>
+template <typename Runtime = Runtime<>, typename PoolString = PoolString<>>
 class Analyzer {
 
 public:
     /*!
         @brief Analyzer constructor.
 
-        @param  getAllocFunc
-                A function that returns a allocator pointer when called.
-
-        @param  getPoolFunc
-                A function that returns a pointer to a string pool when called.
+        @param  runtime
+                The runtime to allocate from.
+                If not provided, the globals returned by get_alloc and
+                get_stringpool are used.
     */
-    explicit Analyzer(GetAllocFunc & getAllocFunc = get_alloc, GetPoolFunc & getPoolFunc = get_stringpool) 
-        : getAllocFunc_(&getAllocFunc), getPoolFunc_(&getPoolFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+    explicit Analyzer(Runtime const & runtime = Runtime()) 
+        : runtime_(runtime) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
     }
 
     /*!
         @brief  Performs full analysis on a command.
+                Comments are removed, multiple consecutive whitespace is
+                reduced to a single ' ' and brackets are checked for matching,
+                all in a single pass which rewrites the command in place.
 
         @param  command
                 The command to analyse
@@ -46,14 +49,37 @@ public:
         @return The result of the analysis.
     */
     AnalysisResult analyze(PoolString & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
-        AnalysisResult result = AnalysisResult::OKAY, tempResult;
-
-        tempResult = preprocess(command);
-        result = result > tempResult ? result : tempResult;
-
-        tempResult = check_bracket_matching(command);
-        result = result > tempResult ? result : tempResult;
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
+        char * chars = command.c_str();
+        int len = 0;
+        int numOpen = 0;
+        bool isMatching = true;
+        int i = 0;
+        while (chars[i] != '\0' && chars[i] != ';') {
+            if (isspace(chars[i])) {
+                chars[len++] = ' ';
+                while (isspace(chars[i])) {
+                    ++i;
+                }
+                continue;
+            }
+            if (chars[i] == '(') {
+                ++numOpen;
+            }
+            else if (chars[i] == ')') {
+                // No matching '('
+                isMatching = isMatching && numOpen > 0;
+                --numOpen;
+            }
+            chars[len++] = chars[i++];
+        }
+        chars[len] = '\0';
+        // Too many '('
+        if (!isMatching || numOpen != 0) {
+            KTY_LOG_WARNING(F("%s: brackets don't match\n"), PRINT_FUNC);        
+            return AnalysisResult::WARNING;
+        }
+        return AnalysisResult::OKAY;
     }
 
     /*!
@@ -67,7 +93,7 @@ public:
         @return The result of the preprocessing.
     */
     AnalysisResult preprocess(PoolString & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
         AnalysisResult result = AnalysisResult::OKAY, tempResult;
         
         tempResult = remove_comments(command);
@@ -88,11 +114,10 @@ public:
         @return The result of removing the comments.
     */
     AnalysisResult remove_comments(PoolString & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
         int commentStartIdx = command.find(';');
         if (commentStartIdx >= 0) {
-            PoolString result(command.substr_ii(0, commentStartIdx));
-            command = result;
+            command[commentStartIdx] = '\0';
         }
         return AnalysisResult::OKAY;
     }
@@ -106,33 +131,33 @@ public:
         @return The result of checking the brackets.
     */
     AnalysisResult check_bracket_matching(PoolString const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
-        Deque<char> bracketStack;
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
+        // Only one kind of bracket, so counting them is enough
+        int numOpen = 0;
         int len = command.strlen();
         for (int i = 0; i < len; ++i) {
             if (command[i] == '(') {
-                bracketStack.push_back(')');
+                ++numOpen;
             }
             else if (command[i] == ')') {
                 // No matching '('
-                if (bracketStack.is_empty()) {
-                    Log.warning(F("%s: brackets don't match\n"), PRINT_FUNC);        
+                if (numOpen == 0) {
+                    KTY_LOG_WARNING(F("%s: brackets don't match\n"), PRINT_FUNC);        
                     return AnalysisResult::WARNING;
                 }
-                bracketStack.pop_back();
+                --numOpen;
             }
         }
         // Too many '('
-        if (!bracketStack.is_empty()) {
-            Log.warning(F("%s: brackets don't match\n"), PRINT_FUNC);        
+        if (numOpen != 0) {
+            KTY_LOG_WARNING(F("%s: brackets don't match\n"), PRINT_FUNC);        
             return AnalysisResult::WARNING;
         }
         return AnalysisResult::OKAY;
     }
 
 private:
-    GetAllocFunc * getAllocFunc_;
-    GetPoolFunc * getPoolFunc_;
+    Runtime runtime_;
 
 };
 
@@ -18,35 +18,47 @@ public:
         @brief  Constructor for the allocator.
     */
     Allocator() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         memset(reinterpret_cast<void *>(pool_), 0, N * B);
         memset(reinterpret_cast<void *>(refCount_), false, N * sizeof(int));
         numTaken_ = 0;
         maxNumTaken_ = 0;
+        numAllocateCalls_ = 0;
     }
 
     /*!
         @brief  Prints stats about the allocator.
     */
     void stat() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        Log.notice(F("%s: num taken = %d, max num taken = %d\n"), PRINT_FUNC, numTaken_, maxNumTaken_);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_NOTICE(F("%s: num taken = %d, max num taken = %d, num allocate calls = %ld\n"), PRINT_FUNC, numTaken_, maxNumTaken_, numAllocateCalls_);
     }
 
     /*!
         @brief  Resets the stats about the allocator.
     */
     void reset_stat() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         maxNumTaken_ = numTaken_;
+        numAllocateCalls_ = 0;
+    }
+
+    /*!
+        @brief  Gets the number of calls made to allocate() since construction
+                or the last reset_stat().
+
+        @return The number of calls made to allocate().
+    */
+    long num_allocate_calls() const {
+        return numAllocateCalls_;
     }
 
     /*!
         @brief  Prints the addresses used by the allocator
     */
     void dump_addresses() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        Log.notice(F("%s: Pool addresses = %d to %d\n"), PRINT_FUNC, (intptr_t)pool_, (intptr_t)(pool_ + N * B - 1));
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_NOTICE(F("%s: Pool addresses = %d to %d\n"), PRINT_FUNC, (intptr_t)pool_, (intptr_t)(pool_ + N * B - 1));
     }
 
     /*!
@@ -59,7 +71,7 @@ public:
     */
     template <typename T>
     bool owns(T * addr) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         char* addr_ = (char *)addr;
         return addr_ - pool_ >= 0 && addr_ - pool_ < N * B;
     }
@@ -70,7 +82,7 @@ public:
         @return The number of available blocks left in the pool.
     */
     int available() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         return N - numTaken_;
     }
 
@@ -83,7 +95,7 @@ public:
         @return The address of the memory at that index.
     */
     void * get_addr(int const & idx) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         return (void *)(pool_ + (B * idx));
     }
 
@@ -97,7 +109,7 @@ public:
     */
     template <typename T>
     int get_idx(T * addr) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         return ((char *)addr - pool_) / B;
     }
 
@@ -112,10 +124,10 @@ public:
     */
     template <typename T>
     int ref_count(T * addr) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         char * addr_ = (char *)addr;
         if (!owns(addr_)) {
-            Log.warning(F("%s: idx %d is not valid\n"), PRINT_FUNC, get_idx(addr));
+            KTY_LOG_WARNING(F("%s: idx %d is not valid\n"), PRINT_FUNC, get_idx(addr));
             return -1;
         }
         int idx = get_idx(addr);
@@ -133,10 +145,10 @@ public:
     */
     template <typename T>
     int inc_ref_count(T * addr) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         char * addr_ = (char *)addr;
         if (!owns(addr_)) {
-            Log.warning(F("%s: idx %d is not valid\n"), PRINT_FUNC, get_idx(addr));
+            KTY_LOG_WARNING(F("%s: idx %d is not valid\n"), PRINT_FUNC, get_idx(addr));
             return -1;
         }
         int idx = get_idx(addr);
@@ -159,10 +171,10 @@ public:
     */
     template <typename T>
     int dec_ref_count(T * addr) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         char * addr_ = (char *)addr;
         if (!owns(addr_)) {
-            Log.warning(F("%s: idx %d is not valid\n"), PRINT_FUNC, get_idx(addr));
+            KTY_LOG_WARNING(F("%s: idx %d is not valid\n"), PRINT_FUNC, get_idx(addr));
             return -1;
         }
         int idx = get_idx(addr);
@@ -178,9 +190,10 @@ public:
                 If no memory is available, nullptr is returned.
     */
     void* allocate() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        ++numAllocateCalls_;
         if (numTaken_ == N) {
-            Log.warning(F("%s: Could not allocate new block from pool\n"), PRINT_FUNC);
+            KTY_LOG_WARNING(F("%s: Could not allocate new block from pool\n"), PRINT_FUNC);
             return nullptr;
         }
         void * addr = nullptr;
@@ -188,10 +201,10 @@ public:
             if (refCount_[i] == 0) {
                 ++refCount_[i];
                 ++numTaken_;
-                Log.verbose(F("%s: Allocating %d\n"), PRINT_FUNC, i);
+                KTY_LOG_VERBOSE(F("%s: Allocating %d\n"), PRINT_FUNC, i);
                 if (numTaken_ > maxNumTaken_) {
                     maxNumTaken_ = numTaken_;
-                    Log.verbose(F("%s: new maxNumTaken %d\n"), PRINT_FUNC, maxNumTaken_);
+                    KTY_LOG_VERBOSE(F("%s: new maxNumTaken %d\n"), PRINT_FUNC, maxNumTaken_);
                 }
                 addr = get_addr(i);
                 memset(addr, 0, B);
@@ -214,27 +227,27 @@ public:
     */
     template <typename T>
     bool deallocate(T * addr) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         char * addr_ = (char *)addr;
         int idx = get_idx(addr_);
         if (!owns(addr_)) {
-            Log.warning(F("%s: index %d given to deallocate did not come from pool\n"), PRINT_FUNC, idx);
+            KTY_LOG_WARNING(F("%s: index %d given to deallocate did not come from pool\n"), PRINT_FUNC, idx);
             return false;
         }
         if (refCount_[idx] > 0) {
             --refCount_[idx];
         }
         else {
-            Log.warning(F("%s: idx %d given to deallocate has already been previously deallocated\n"), PRINT_FUNC, idx);
+            KTY_LOG_WARNING(F("%s: idx %d given to deallocate has already been previously deallocated\n"), PRINT_FUNC, idx);
             return false;
         }
         if (refCount_[idx] == 0) {
-            Log.verbose(F("%s: deallocated idx %d successfully\n"), PRINT_FUNC, idx);
+            KTY_LOG_VERBOSE(F("%s: deallocated idx %d successfully\n"), PRINT_FUNC, idx);
             --numTaken_;
             return true;
         }
         else {
-            Log.verbose(F("%s: idx %d is not the last reference, not deallocating\n"), PRINT_FUNC, idx);
+            KTY_LOG_VERBOSE(F("%s: idx %d is not the last reference, not deallocating\n"), PRINT_FUNC, idx);
             return true;
         }
     }
@@ -244,6 +257,7 @@ private:
     int refCount_[N];
     int numTaken_;
     int maxNumTaken_;
+    long numAllocateCalls_;
 
 };
 
@@ -264,6 +278,31 @@ Allocator<Sizes::alloc_size, Sizes::alloc_block_size> * get_alloc(Allocator<Size
     return alloc;
 }
 
+#if !defined(ARDUINO)
+
+/*!
+    @brief  Returns a pointer to the allocator of the calling thread.
+            Every thread gets its own allocator, so threads never contend
+            for memory. Has the same signature as get_alloc, so it can be
+            used in its place, e.g. Runtime<>(get_thread_alloc, get_thread_stringpool).
+
+    @param  ptr
+            Used to set the address to return for subsequent calls
+            from the calling thread.
+
+    @return A pointer to the allocator of the calling thread.
+*/
+Allocator<Sizes::alloc_size, Sizes::alloc_block_size> * get_thread_alloc(Allocator<Sizes::alloc_size, Sizes::alloc_block_size> * ptr = nullptr) {
+    static thread_local Allocator<Sizes::alloc_size, Sizes::alloc_block_size> threadAlloc;
+    static thread_local Allocator<Sizes::alloc_size, Sizes::alloc_block_size> * alloc = &threadAlloc;
+    if (ptr != nullptr) {
+        alloc = ptr;
+    }
+    return alloc;
+}
+
+#endif
+
 /*!
     @brief  Class to perform setup of the get_alloc function at the global scope.
 */
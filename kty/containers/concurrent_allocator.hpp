@@ -0,0 +1,257 @@
+#pragma once
+
+#if !defined(ARDUINO)
+
+#include <atomic>
+
+#include <kty/containers/free_list.hpp>
+#include <kty/sizes.hpp>
+#include <kty/types.hpp>
+
+namespace kty {
+
+/*!
+    @brief  Thread-safe version of Allocator, for data shared between threads.
+            Free blocks are kept on a lock-free free list, so allocation and
+            deallocation take constant time and never block.
+            Holds enough memory to allocate N instances of B bytes.
+            Interpreter threads which do not share data should rather each
+            use their own Allocator, see get_thread_alloc().
+*/
+template <int N = Sizes::alloc_size, int B = Sizes::alloc_block_size>
+class ConcurrentAllocator {
+
+public:
+    /*!
+        @brief  Constructor for the allocator.
+    */
+    ConcurrentAllocator() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        memset(reinterpret_cast<void *>(pool_), 0, N * B);
+        for (int i = 0; i < N; ++i) {
+            refCount_[i].store(0, std::memory_order_relaxed);
+        }
+        numTaken_.store(0);
+        maxNumTaken_.store(0);
+        numAllocateCalls_.store(0);
+    }
+
+    /*!
+        @brief  Prints stats about the allocator.
+    */
+    void stat() const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_NOTICE(F("%s: num taken = %d, max num taken = %d, num allocate calls = %ld\n"), PRINT_FUNC, numTaken_.load(), maxNumTaken_.load(), numAllocateCalls_.load());
+    }
+
+    /*!
+        @brief  Resets the stats about the allocator.
+    */
+    void reset_stat() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        maxNumTaken_.store(numTaken_.load());
+        numAllocateCalls_.store(0);
+    }
+
+    /*!
+        @brief  Gets the number of calls made to allocate() since construction
+                or the last reset_stat().
+
+        @return The number of calls made to allocate().
+    */
+    long num_allocate_calls() const {
+        return numAllocateCalls_.load(std::memory_order_relaxed);
+    }
+
+    /*!
+        @brief  Prints the addresses used by the allocator
+    */
+    void dump_addresses() const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_NOTICE(F("%s: Pool addresses = %d to %d\n"), PRINT_FUNC, (intptr_t)pool_, (intptr_t)(pool_ + N * B - 1));
+    }
+
+    /*!
+        @brief  Checks if an address is owned by this allocator.
+
+        @param  addr
+                The address to check.
+
+        @return True if the address is owned by this allocator, false otherwise.
+    */
+    template <typename T>
+    bool owns(T * addr) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        char const * addr_ = (char const *)addr;
+        return addr_ - pool_ >= 0 && addr_ - pool_ < N * B;
+    }
+
+    /*!
+        @brief  Check the number of available blocks left in the pool.
+
+        @return The number of available blocks left in the pool.
+    */
+    int available() const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return N - numTaken_.load();
+    }
+
+    /*!
+        @brief  Gets the address of the memory at an index.
+
+        @param  idx
+                The index of the memory in the pool.
+
+        @return The address of the memory at that index.
+    */
+    void * get_addr(int const & idx) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return (void *)(pool_ + (B * idx));
+    }
+
+    /*!
+        @brief  Gets the index in the pool of a memory address.
+
+        @param  addr
+                The address to look up.
+
+        @return The index of the memory address in the pool.
+    */
+    template <typename T>
+    int get_idx(T * addr) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return ((char *)addr - pool_) / B;
+    }
+
+    /*!
+        @brief  Gets the reference count of a memory address.
+
+        @param  addr
+                The address to look up.
+
+        @return The number of references to that address.
+                If the address is invalid, -1 is returned.
+    */
+    template <typename T>
+    int ref_count(T * addr) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (!owns(addr)) {
+            KTY_LOG_WARNING(F("%s: idx %d is not valid\n"), PRINT_FUNC, get_idx(addr));
+            return -1;
+        }
+        return refCount_[get_idx(addr)].load();
+    }
+
+    /*!
+        @brief  Increases reference count of a memory address.
+
+        @param  addr
+                The address to look up.
+
+        @return The new reference count of the memory address.
+                If the address is invalid, -1 is returned.
+    */
+    template <typename T>
+    int inc_ref_count(T * addr) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (!owns(addr)) {
+            KTY_LOG_WARNING(F("%s: idx %d is not valid\n"), PRINT_FUNC, get_idx(addr));
+            return -1;
+        }
+        return refCount_[get_idx(addr)].fetch_add(1) + 1;
+    }
+
+    /*!
+        @brief  Decreases the reference count of a memory address.
+                If this operation decreases the reference count to 0,
+                it is not deallocated.
+                To ensure that a decrease to 0 deallocates the address,
+                call deallocate().
+
+        @param  addr
+                The address to look up.
+
+        @return The new reference count of the memory address.
+                If the address is invalid, -1 is returned.
+    */
+    template <typename T>
+    int dec_ref_count(T * addr) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (!owns(addr)) {
+            KTY_LOG_WARNING(F("%s: idx %d is not valid\n"), PRINT_FUNC, get_idx(addr));
+            return -1;
+        }
+        return refCount_[get_idx(addr)].fetch_sub(1) - 1;
+    }
+
+    /*!
+        @brief  Allocates a single block of memory from the pool.
+                Zeroes out memory before handing it out.
+
+        @return A pointer to a block of memory.
+                If no memory is available, nullptr is returned.
+    */
+    void* allocate() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        numAllocateCalls_.fetch_add(1, std::memory_order_relaxed);
+        int idx = freeList_.pop();
+        if (idx == -1) {
+            KTY_LOG_WARNING(F("%s: Could not allocate new block from pool\n"), PRINT_FUNC);
+            return nullptr;
+        }
+        refCount_[idx].store(1);
+        int numTaken = numTaken_.fetch_add(1) + 1;
+        int maxNumTaken = maxNumTaken_.load();
+        while (numTaken > maxNumTaken && !maxNumTaken_.compare_exchange_weak(maxNumTaken, numTaken));
+        void * addr = get_addr(idx);
+        memset(addr, 0, B);
+        return addr;
+    }
+
+    /*!
+        @brief  Returns a single block of memory to the pool.
+                This does not call the destructor on the data stored at the block.
+                The destructor for the particular data type stored at the memory location
+                should be called before deallocating the memory.
+
+        @param  addr
+                A pointer to a block of memory to be returned to the pool.
+
+        @return True if the deallocation was successful, false otherwise.
+    */
+    template <typename T>
+    bool deallocate(T * addr) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        int idx = get_idx(addr);
+        if (!owns(addr)) {
+            KTY_LOG_WARNING(F("%s: index %d given to deallocate did not come from pool\n"), PRINT_FUNC, idx);
+            return false;
+        }
+        int refCount = refCount_[idx].load();
+        do {
+            if (refCount <= 0) {
+                KTY_LOG_WARNING(F("%s: idx %d given to deallocate has already been previously deallocated\n"), PRINT_FUNC, idx);
+                return false;
+            }
+        } while (!refCount_[idx].compare_exchange_weak(refCount, refCount - 1));
+        if (refCount == 1) {
+            KTY_LOG_VERBOSE(F("%s: deallocated idx %d successfully\n"), PRINT_FUNC, idx);
+            numTaken_.fetch_sub(1);
+            freeList_.push(idx);
+        }
+        return true;
+    }
+
+private:
+    char pool_[N * B];
+    std::atomic<int> refCount_[N];
+    FreeList<N> freeList_;
+    std::atomic<int> numTaken_;
+    std::atomic<int> maxNumTaken_;
+    std::atomic<long> numAllocateCalls_;
+
+};
+
+} // namespace kty
+
+#endif
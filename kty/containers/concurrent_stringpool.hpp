@@ -0,0 +1,188 @@
+#pragma once
+
+#if !defined(ARDUINO)
+
+#include <atomic>
+
+#include <kty/containers/free_list.hpp>
+#include <kty/containers/stringpool.hpp>
+#include <kty/sizes.hpp>
+#include <kty/types.hpp>
+
+namespace kty {
+
+/*!
+    @brief  Thread-safe version of StringPool, for strings shared between threads.
+            Free indices are kept on a lock-free free list, so allocation and
+            deallocation take constant time and never block.
+            Allocation and reference counting are thread-safe, but a single
+            string should only be written by one thread at a time.
+            Holds enough memory to allocate N strings of at most length S.
+            Interpreter threads which do not share strings should rather each
+            use their own StringPool, see get_thread_stringpool().
+            The strings themselves are kept the same way as in StringPool.
+*/
+template <int N = Sizes::stringpool_size, int S = Sizes::string_length>
+class ConcurrentStringPool : public StringStorage<N, S> {
+
+public:
+    using StringStorage<N, S>::owns;
+    using StringStorage<N, S>::c_str;
+
+    /*!
+        @brief  Constructor for the string pool
+    */
+    ConcurrentStringPool() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        for (int i = 0; i < N; ++i) {
+            refCount_[i].store(0, std::memory_order_relaxed);
+        }
+        numTaken_.store(0);
+        maxNumTaken_.store(0);
+    }
+
+    /*!
+        @brief  Prints stats about the string pool.
+    */
+    void stat() const {
+        KTY_LOG_NOTICE(F("%s: num taken = %d, max num taken = %d\n"), PRINT_FUNC, numTaken_.load(), maxNumTaken_.load());
+    }
+
+    /*!
+        @brief  Resets the stats about the string pool.
+    */
+    void reset_stat() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        maxNumTaken_.store(numTaken_.load());
+    }
+
+    /*!
+        @brief  Check the number of available blocks left in the pool.
+
+        @return The number of available blocks left in the pool.
+    */
+    int available() const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return N - numTaken_.load();
+    }
+
+    /*!
+        @brief  Returns the reference count for an index.
+
+        @param  idx
+                The index to get the reference count for.
+
+        @return The reference count for the index.
+                If the index is invalid, -1 is returned.
+    */
+    int ref_count(int const & idx) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (owns(idx)) {
+            return refCount_[idx].load();
+        }
+        KTY_LOG_WARNING(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
+        return -1;
+    }
+
+    /*!
+        @brief  Increases the reference count for an index.
+
+        @param  idx
+                The index to increase the reference count for.
+
+        @return The new reference count of the index.
+                If the address is invalid, -1 is returned.
+    */
+    int inc_ref_count(int const & idx) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (owns(idx)) {
+            return refCount_[idx].fetch_add(1) + 1;
+        }
+        KTY_LOG_WARNING(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
+        return -1;
+    }
+
+    /*!
+        @brief  Decreases the reference count for an index.
+                If this operation decreases the reference count to 0,
+                it is not deallocated.
+                To ensure that a decrease to 0 deallocates the index,
+                call deallocate_idx().
+
+        @param  idx
+                The index to decrease the reference count for.
+
+        @return The new reference count of the index.
+                If the address is invalid, -1 is returned.
+    */
+    int dec_ref_count(int const & idx) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (owns(idx)) {
+            return refCount_[idx].fetch_sub(1) - 1;
+        }
+        KTY_LOG_WARNING(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
+        return -1;
+    }
+
+    /*!
+        @brief  Gets the next free index for a string.
+
+        @return An index into the pool if there is space,
+                -1 otherwise.
+    */
+    int allocate_idx() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        int idx = freeList_.pop();
+        if (idx == -1) {
+            KTY_LOG_WARNING(F("%s: No more string indices to allocate\n"), PRINT_FUNC);
+            return -1;
+        }
+        refCount_[idx].store(1);
+        int numTaken = numTaken_.fetch_add(1) + 1;
+        int maxNumTaken = maxNumTaken_.load();
+        while (numTaken > maxNumTaken && !maxNumTaken_.compare_exchange_weak(maxNumTaken, numTaken));
+        KTY_LOG_TRACE(F("%s: Allocating index %d\n"), PRINT_FUNC, idx);
+        memset((void*)c_str(idx), '\0', S + 1);
+        return idx;
+    }
+
+    /*!
+        @brief  Returns a string index to the pool
+
+        @param  idx
+                The index to return to the pool
+
+        @return True if the deallocation was successful, false otherwise.
+    */
+    bool deallocate_idx(int const & idx) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (!owns(idx)) {
+            KTY_LOG_WARNING(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
+            return false;
+        }
+        int refCount = refCount_[idx].load();
+        do {
+            if (refCount <= 0) {
+                KTY_LOG_WARNING(F("%s: Index %d has already been previously deallocated\n"), PRINT_FUNC, idx);
+                return false;
+            }
+        } while (!refCount_[idx].compare_exchange_weak(refCount, refCount - 1));
+        if (refCount == 1) {
+            numTaken_.fetch_sub(1);
+            freeList_.push(idx);
+            KTY_LOG_TRACE(F("%s: Index %d deallocated successfully\n"), PRINT_FUNC, idx);
+        }
+        return true;
+    }
+
+private:
+    std::atomic<int> refCount_[N];
+    FreeList<N> freeList_;
+    std::atomic<int> numTaken_;
+    std::atomic<int> maxNumTaken_;
+
+};
+
+} // namespace kty
+
+#endif
@@ -11,6 +11,8 @@ namespace kty {
             Provides quick insertion and deletion at both ends,
             but at the expense of slow random access. 
             Implemented as a circular doubly linked list with a dummy head node.
+            The head node is only allocated on the first push, so an empty
+            deque does not take any memory from the allocator.
 */
 template <typename T, typename Alloc = Allocator<Sizes::alloc_size, Sizes::alloc_block_size>, typename GetAllocFunc = decltype(get_alloc)>
 class Deque {
@@ -264,29 +266,27 @@ public:
     */
     explicit Deque(Alloc & allocator)
         : allocator_(&allocator) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         static_assert(sizeof(Node) <= Sizes::alloc_block_size, "Size of Deque<T, Alloc>::Node can be no larger than kty::Sizes::alloc_block_size, due to fixed allocator memory block size.");
         size_ = 0;
-        head_ = alloc();
-        head_->next = head_;
-        head_->prev = head_;
+        head_ = empty_head();
     }
 
     /*!
         @brief  Constructor for the deque.
-                This constructor sets up the deque to use allocating functions.
+                This constructor sets up the deque to use the allocator
+                returned by an allocating function.
+                The function is only called once, here.
 
         @param  getAllocFunc
                 A function that returns a allocator pointer when called.
     */
     explicit Deque(GetAllocFunc & getAllocFunc = get_alloc) 
-        : getAllocFunc_(&getAllocFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : allocator_(getAllocFunc(nullptr)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         static_assert(sizeof(Node) <= Sizes::alloc_block_size, "Size of Deque<T, Alloc>::Node can be no larger than kty::Sizes::alloc_block_size, due to fixed allocator memory block size.");
         size_ = 0;
-        head_ = alloc();
-        head_->next = head_;
-        head_->prev = head_;
+        head_ = empty_head();
     }
 
     /*!
@@ -296,13 +296,11 @@ public:
                 The deque to copy from.
     */
     Deque(Deque<value_t, Alloc> const & other) 
-        : allocator_(other.allocator_), getAllocFunc_(other.getAllocFunc_) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : allocator_(other.allocator_) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         static_assert(sizeof(Node) <= Sizes::alloc_block_size, "Size of Deque<T, Alloc>::Node can be no larger than kty::Sizes::alloc_block_size, due to fixed allocator memory block size.");
         size_ = 0;
-        head_ = alloc();
-        head_->next = head_;
-        head_->prev = head_;
+        head_ = empty_head();
         // Copy over nodes from other deque
         for (ConstIterator it = other.begin(); it != other.end(); ++it) {
             push_back(*it);
@@ -318,17 +316,11 @@ public:
         @return A reference to this deque after the copy.
     */
     Deque<value_t, Alloc> & operator=(Deque<value_t, Alloc> const & other) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        // Clear our own nodes
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        // Clear our own nodes, which also returns the head node
         clear();
-        dalloc(head_);
         // Restart our deque
         allocator_ = other.allocator_;
-        getAllocFunc_ = other.getAllocFunc_;
-        size_ = 0;
-        head_ = alloc();
-        head_->next = head_;
-        head_->prev = head_;
         // Copy over nodes from other deque
         for (ConstIterator it = other.begin(); it != other.end(); ++it) {
             push_back(*it);
@@ -340,34 +332,22 @@ public:
         @brief  Destructor for the deque.
     */
     virtual ~Deque() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         clear();
-        dalloc(head_);
     }
 
     /*!
-        @brief  Performs the correct allocation depending on whether
-                an allocator object is given, or if a function to get
-                an allocator object is given.
+        @brief  Allocates a node from the allocator of this deque.
         
         @return A pointer to the allocated node.
     */
     Node * alloc() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        if (allocator_ != nullptr) {
-            Log.verbose(F("%s: allocator\n"), PRINT_FUNC);
-            return static_cast<Node *>(allocator_->allocate());
-        }
-        else {
-            Log.verbose(F("%s: getAllocFunc\n"), PRINT_FUNC);
-            return static_cast<Node *>((*getAllocFunc_)(nullptr)->allocate());
-        }
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return static_cast<Node *>(allocator_->allocate());
     }
 
     /*!
-        @brief  Performs the correct deallocation depending on whether
-                an allocator object is given, or if a function to get
-                an allocator object is given.
+        @brief  Returns a node to the allocator of this deque.
         
         @param  ptr
                 The pointer to deallocate.
@@ -375,14 +355,56 @@ public:
         @return True if the deallocation was successful, false otherwise.
     */
     bool dalloc(Node * ptr) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        if (allocator_ != nullptr) {
-            Log.verbose(F("%s: allocator\n"), PRINT_FUNC);
-            return allocator_->deallocate(ptr);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return allocator_->deallocate(ptr);
+    }
+
+    /*!
+        @brief  Gets the allocator used by this deque.
+
+        @return A reference to the allocator.
+    */
+    Alloc & allocator() const {
+        return *allocator_;
+    }
+
+    /*!
+        @brief  Checks if this deque has allocated its own head node.
+
+        @return True if the head node has been allocated, false if the deque
+                is still using the shared empty head node.
+    */
+    bool has_head() const {
+        return head_ != empty_head();
+    }
+
+    /*!
+        @brief  Allocates the head node if the deque is still using the
+                shared empty head node.
+
+        @return True if the deque has a head node, false if the allocation failed.
+    */
+    bool ensure_head() {
+        if (has_head()) {
+            return true;
         }
-        else {
-            Log.verbose(F("%s: getAllocFunc\n"), PRINT_FUNC);
-            return (*getAllocFunc_)(nullptr)->deallocate(ptr);
+        Node * head = alloc();
+        if (head == nullptr) {
+            KTY_LOG_WARNING(F("%s: Unable to allocate head node\n"), PRINT_FUNC);
+            return false;
+        }
+        head_ = link_to_self(head);
+        return true;
+    }
+
+    /*!
+        @brief  Returns the head node to the allocator, if it was allocated.
+                The deque must be empty.
+    */
+    void release_head() {
+        if (has_head()) {
+            dalloc(head_);
+            head_ = empty_head();
         }
     }
 
@@ -406,12 +428,32 @@ public:
 
     /*!
         @brief  Clears all elements in the deque, leaving it empty.
+                The head node is returned to the allocator as well.
     */
     virtual void clear() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         while (!is_empty()) {
             pop_front();
         }
+        release_head();
+    }
+
+    /*!
+        @brief  Swaps the contents of this deque with another deque,
+                without copying any of the elements.
+                Both deques must use the same allocator.
+
+        @param  other
+                The deque to swap with.
+    */
+    void swap(Deque<value_t, Alloc> & other) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        Node * head = head_;
+        head_ = other.head_;
+        other.head_ = head;
+        int size = size_;
+        size_ = other.size_;
+        other.size_ = size;
     }
 
     /*!
@@ -423,11 +465,14 @@ public:
         @return True if the push was successful, false otherwise.
     */
     virtual bool push_front(value_t const & value) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (!ensure_head()) {
+            return false;
+        }
         // Allocate new node
         Node* toInsert = alloc();
         if (toInsert == nullptr) {
-            Log.warning(F("%s: Unable to push back due to invalid allocated address\n"), PRINT_FUNC);
+            KTY_LOG_WARNING(F("%s: Unable to push back due to invalid allocated address\n"), PRINT_FUNC);
             return false;
         }
         toInsert->value = value;
@@ -438,7 +483,7 @@ public:
         next->prev = toInsert;
         head_->next = toInsert;
         ++size_;
-        Log.verbose(F("%s: done\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s: done\n"), PRINT_FUNC);
         return true;
     }
 
@@ -449,7 +494,7 @@ public:
         @return True if the push was successful, false otherwise.
     */
     virtual bool pop_front() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (is_empty()) {
             return false;
         }
@@ -462,7 +507,7 @@ public:
         toRemove->value.~value_t();
         bool result = dalloc(toRemove);
         --size_;
-        Log.verbose(F("%s: done\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s: done\n"), PRINT_FUNC);
         return result;
     }
 
@@ -476,11 +521,14 @@ public:
         @return True if the push was successful, false otherwise.
     */
     virtual bool push_back(value_t const & value) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (!ensure_head()) {
+            return false;
+        }
         // Allocate new node
         Node* toInsert = alloc();
         if (toInsert == nullptr) {
-            Log.warning(F("%s: Unable to push back due to invalid allocated address\n"), PRINT_FUNC);
+            KTY_LOG_WARNING(F("%s: Unable to push back due to invalid allocated address\n"), PRINT_FUNC);
             return false;
         }
         toInsert->value = value_t(value);
@@ -491,7 +539,7 @@ public:
         prev->next = toInsert;
         head_->prev = toInsert;
         ++size_;
-        Log.verbose(F("%s: done\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s: done\n"), PRINT_FUNC);
         return true;
     }
 
@@ -502,7 +550,7 @@ public:
         @return True if the push was successful, false otherwise.
     */
     virtual bool pop_back() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (is_empty()) {
             return false;
         }
@@ -515,7 +563,7 @@ public:
         toRemove->value.~value_t();
         bool result = dalloc(toRemove);
         --size_;
-        Log.verbose(F("%s: done\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s: done\n"), PRINT_FUNC);
         return result;
     }
 
@@ -526,9 +574,9 @@ public:
         @return A reference to the element.
     */
     virtual value_t & front() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (size() == 0) {
-            Log.warning(F("%s: size = 0 (undefined behaviour)\n"), PRINT_FUNC);
+            KTY_LOG_WARNING(F("%s: size = 0 (undefined behaviour)\n"), PRINT_FUNC);
         }
         return head_->next->value;
     }
@@ -540,9 +588,9 @@ public:
         @return A reference to the element.
     */
     virtual value_t const & front() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (size() == 0) {
-            Log.warning(F("%s: size = 0 (undefined behaviour)\n"), PRINT_FUNC);
+            KTY_LOG_WARNING(F("%s: size = 0 (undefined behaviour)\n"), PRINT_FUNC);
         }
         return head_->next->value;
     }
@@ -554,9 +602,9 @@ public:
         @return A reference to the element.
     */
     virtual value_t & back() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (size() == 0) {
-            Log.warning(F("%s: size = 0 (undefined behaviour)\n"), PRINT_FUNC);
+            KTY_LOG_WARNING(F("%s: size = 0 (undefined behaviour)\n"), PRINT_FUNC);
         }        
         return head_->prev->value;
     }
@@ -568,9 +616,9 @@ public:
         @return A reference to the element.
     */
     virtual value_t const & back() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (size() == 0) {
-            Log.warning(F("%s: size = 0 (undefined behaviour)\n"), PRINT_FUNC);
+            KTY_LOG_WARNING(F("%s: size = 0 (undefined behaviour)\n"), PRINT_FUNC);
         }        
         return head_->prev->value;
     }
@@ -645,7 +693,7 @@ public:
     */
     virtual bool erase(int const & idx) {
         if (idx >= size_) {
-            Log.warning(F("%s: invalid idx %d to erase, size is %d\n"), PRINT_FUNC, idx, size_);
+            KTY_LOG_WARNING(F("%s: invalid idx %d to erase, size is %d\n"), PRINT_FUNC, idx, size_);
             return false;
         }
         Node* toRemove = head_->next;
@@ -696,15 +744,15 @@ public:
         @return A reference to the element.
     */
     virtual value_t & operator[](int const & i) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (i < 0 || i >= size_) {
-            Log.warning(F("%s: accessing index %d when size is %d (undefined behaviour)\n"), PRINT_FUNC, i, i, size_);
+            KTY_LOG_WARNING(F("%s: accessing index %d when size is %d (undefined behaviour)\n"), PRINT_FUNC, i, i, size_);
         }
         Node* curr = head_->next;
         for (int j = 0; j < i; ++j) {
             curr = curr->next;
         }
-        Log.verbose(F("%s: returning\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s: returning\n"), PRINT_FUNC);
         return curr->value;
     }
 
@@ -718,19 +766,49 @@ public:
         @return A reference to the element.
     */
     virtual value_t const & operator[](int const & i) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (i < 0 || i >= size_) {
-            Log.warning(F("%s: accessing index %d when size is %d (undefined behaviour)\n"), PRINT_FUNC, i, i, size_);
+            KTY_LOG_WARNING(F("%s: accessing index %d when size is %d (undefined behaviour)\n"), PRINT_FUNC, i, i, size_);
         }
         Node* curr = head_->next;
         for (int j = 0; j < i; ++j) {
             curr = curr->next;
         }
-        Log.verbose(F("%s: returning\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s: returning\n"), PRINT_FUNC);
         return curr->value;
     }
 
 protected:
+    /*!
+        @brief  Returns the head node shared by all deques of this type which
+                have not allocated their own head node yet.
+                Its value is zeroed, just like a freshly allocated head node,
+                and it is never linked to any other node.
+
+        @return A pointer to the shared empty head node.
+    */
+    static Node * empty_head() {
+        static Node * head = link_to_self(reinterpret_cast<Node *>(emptyHeadStorage_));
+        return head;
+    }
+
+    /*!
+        @brief  Points a node's next and previous pointers back at itself.
+
+        @param  node
+                The node to link.
+
+        @return The linked node.
+    */
+    static Node * link_to_self(Node * node) {
+        node->next = node;
+        node->prev = node;
+        return node;
+    }
+
+    /** Zeroed storage for the shared empty head node */
+    alignas(Node) static char emptyHeadStorage_[sizeof(Node)];
+
     /** Pointer to the head node of the internal linked list */
     Node* head_ = nullptr;
     /** Current size of the linked list */
@@ -738,9 +816,10 @@ protected:
 
     /** Pointer to the allocator used to allocate new nodes */
     Alloc * allocator_ = nullptr;
-    /** Pointer to the function to get the allocator */
-    GetAllocFunc * getAllocFunc_ = nullptr;
 
 };
 
+template <typename T, typename Alloc, typename GetAllocFunc>
+alignas(typename Deque<T, Alloc, GetAllocFunc>::Node) char Deque<T, Alloc, GetAllocFunc>::emptyHeadStorage_[sizeof(typename Deque<T, Alloc, GetAllocFunc>::Node)];
+
 } // namespace kty
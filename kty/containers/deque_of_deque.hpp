@@ -25,8 +25,22 @@ public:
                 A function that returns a pointer to a string pool when called.
     */
     DequeDequePoolString(GetAllocFunc & getAllocFunc = get_alloc, GetPoolFunc & getPoolFunc = get_stringpool) 
-        : getAllocFunc_(&getAllocFunc), getPoolFunc_(&getPoolFunc), strings_(getAllocFunc), sizes_(getAllocFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : stringPool_(getPoolFunc(nullptr)), strings_(getAllocFunc), sizes_(getAllocFunc) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+    }
+
+    /*!
+        @brief  Constructor for the deque.
+
+        @param  alloc
+                The allocator for the deque nodes.
+
+        @param  stringPool
+                The string pool for the strings.
+    */
+    DequeDequePoolString(Allocator<Sizes::alloc_size, Sizes::alloc_block_size> & alloc, StringPool & stringPool) 
+        : stringPool_(&stringPool), strings_(alloc), sizes_(alloc) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
     }
 
     /*!
@@ -35,9 +49,9 @@ public:
         @return True if successful, false otherwise.
     */
     bool push_front() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         bool result;
-        result = strings_.push_front(PoolString<StringPool>(*getPoolFunc_));
+        result = strings_.push_front(PoolString<StringPool>(*stringPool_));
         result = sizes_.push_front(0) && result;
         return result;
     }
@@ -48,7 +62,7 @@ public:
         @return The number of deques.
     */
     int size() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         return strings_.size();
     }
 
@@ -62,9 +76,9 @@ public:
                 Returns -1 if i is invalid.
     */
     int size(int const & i) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (i < 0 || i >= size()) {
-            Log.warning(F("%s: accessing index i = %d when size is %d\n"), PRINT_FUNC, i, size());
+            KTY_LOG_WARNING(F("%s: accessing index i = %d when size is %d\n"), PRINT_FUNC, i, size());
             return -1;
         }
         return sizes_[i];
@@ -76,7 +90,7 @@ public:
         @return True if the clear was successful, false otherwise.
     */
     bool clear() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         bool result = true;
         for (int i = 0; i < size(); ++i) {
             result = clear(i) && result;
@@ -95,16 +109,16 @@ public:
         @return True if the clear was successful, false otherwise.
     */
     bool clear(int const & i) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (i < 0 || i >= size()) {
-            Log.warning(F("%s: accessing index i = %d when size is %d\n"), PRINT_FUNC, i, size());
+            KTY_LOG_WARNING(F("%s: accessing index i = %d when size is %d\n"), PRINT_FUNC, i, size());
             return false;
         }
         char* stringPoolIndices = strings_[i].c_str();
         int len = sizes_[i];
         for (int i = 0; i < len; ++i) {
             int stringPoolIdx = stringPoolIndices[i];
-            (*getPoolFunc_)(nullptr)->deallocate_idx(stringPoolIdx);
+            stringPool_->deallocate_idx(stringPoolIdx);
         }
         strings_[i] = "";
         sizes_[i] = 0;
@@ -125,19 +139,19 @@ public:
                 An empty sting is returned if i or j are invalid.
     */
     PoolString<StringPool> get_str(int const & i, int const & j) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        PoolString<StringPool> str(*getPoolFunc_);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        PoolString<StringPool> str(*stringPool_);
         if (i < 0 || i >= size()) {
-            Log.warning(F("%s: accessing index i = %d when size is %d\n"), PRINT_FUNC, i, size());
+            KTY_LOG_WARNING(F("%s: accessing index i = %d when size is %d\n"), PRINT_FUNC, i, size());
             return str;
         }
         if (j < 0 || j >= size(i)) {
-            Log.warning(F("%s: accessing index j = %d when size[%d] is %d\n"), PRINT_FUNC, j, i, size(i));            
+            KTY_LOG_WARNING(F("%s: accessing index j = %d when size[%d] is %d\n"), PRINT_FUNC, j, i, size(i));            
             return str;
         }
         int stringPoolIdx = (int)(strings_[i].c_str()[j]);
-        str = (*getPoolFunc_)(nullptr)->c_str(stringPoolIdx);
-        Log.verbose(F("%s: string returned is %s\n"), PRINT_FUNC, str.c_str());
+        str = stringPool_->c_str(stringPoolIdx);
+        KTY_LOG_VERBOSE(F("%s: string returned is %s\n"), PRINT_FUNC, str.c_str());
         return str;
     }
 
@@ -154,17 +168,17 @@ public:
                 -1 is returned if i or j are invalid.
     */
     int get_str_idx(int const & i, int const & j) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (i < 0 || i >= size()) {
-            Log.warning(F("%s: accessing index i = %d when size is %d\n"), PRINT_FUNC, i, size());
+            KTY_LOG_WARNING(F("%s: accessing index i = %d when size is %d\n"), PRINT_FUNC, i, size());
             return -1;
         }
         if (j < 0 || j >= size(i)) {
-            Log.warning(F("%s: accessing index j = %d when size[%d] is %d\n"), PRINT_FUNC, j, i, size(i));            
+            KTY_LOG_WARNING(F("%s: accessing index j = %d when size[%d] is %d\n"), PRINT_FUNC, j, i, size(i));            
             return -1;
         }
         int stringPoolIdx = (int)(strings_[i].c_str()[j]);
-        Log.verbose(F("%s: idx is %d\n"), PRINT_FUNC, stringPoolIdx);
+        KTY_LOG_VERBOSE(F("%s: idx is %d\n"), PRINT_FUNC, stringPoolIdx);
         return stringPoolIdx;
     }
 
@@ -180,24 +194,23 @@ public:
         @return True if successful, false otherwise.
     */
     bool push_back(int const & i, PoolString<StringPool> const & str) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (i < 0 || i >= size()) {
-            Log.warning(F("DequeDequePoolString::push_back accessing index i = %d when size is %d\n"), i, size());
+            KTY_LOG_WARNING(F("DequeDequePoolString::push_back accessing index i = %d when size is %d\n"), i, size());
             return false;
         }
-        int stringPoolIdx = (*getPoolFunc_)(nullptr)->allocate_idx();
-        (*getPoolFunc_)(nullptr)->strcpy(stringPoolIdx, str.c_str());
+        int stringPoolIdx = stringPool_->allocate_idx();
+        stringPool_->strcpy(stringPoolIdx, str.c_str());
         char str_[2] = " ";
         str_[0] = char(stringPoolIdx);
         strings_[i] += str_;
         sizes_[i] += 1;
-        Log.verbose(F("%s: %s given stringPoolIdx %d\n"), PRINT_FUNC, str.c_str(), stringPoolIdx);
+        KTY_LOG_VERBOSE(F("%s: %s given stringPoolIdx %d\n"), PRINT_FUNC, str.c_str(), stringPoolIdx);
         return true;
     }
 
 private:
-    GetAllocFunc * getAllocFunc_ = nullptr;
-    GetPoolFunc * getPoolFunc_ = nullptr;
+    StringPool * stringPool_ = nullptr;
 
     Deque<PoolString<StringPool>> strings_;
     Deque<int>          sizes_;
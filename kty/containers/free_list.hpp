@@ -0,0 +1,118 @@
+#pragma once
+
+#if !defined(ARDUINO)
+
+#include <atomic>
+#include <cstdint>
+
+#include <kty/types.hpp>
+
+namespace kty {
+
+/*!
+    @brief  Lock-free stack of the free indices 0 to N - 1 of a pool.
+            Any number of threads can push and pop at the same time.
+            The head of the stack is tagged with a counter that changes
+            on every update, so an index that is popped and pushed back
+            between the read and the update of another thread is detected.
+*/
+template <int N>
+class FreeList {
+
+public:
+    /*!
+        @brief  Constructor for the free list.
+                All indices start out free, and are popped in increasing order.
+    */
+    FreeList() {
+        for (int i = 0; i < N; ++i) {
+            next_[i].store(i + 1 < N ? i + 1 : -1, std::memory_order_relaxed);
+        }
+        head_.store(pack(N > 0 ? 0 : -1, 0), std::memory_order_release);
+    }
+
+    /*!
+        @brief  Takes a free index off the list.
+
+        @return The free index, or -1 if there are none left.
+    */
+    int pop() {
+        uint64_t oldHead = head_.load(std::memory_order_acquire);
+        uint64_t newHead;
+        int idx;
+        do {
+            idx = index(oldHead);
+            if (idx == -1) {
+                return -1;
+            }
+            newHead = pack(next_[idx].load(std::memory_order_relaxed), tag(oldHead) + 1);
+        } while (!head_.compare_exchange_weak(oldHead, newHead, std::memory_order_acq_rel, std::memory_order_acquire));
+        return idx;
+    }
+
+    /*!
+        @brief  Puts an index back on the list.
+                The index must not already be on the list.
+
+        @param  idx
+                The index to put back.
+    */
+    void push(int const & idx) {
+        uint64_t oldHead = head_.load(std::memory_order_relaxed);
+        uint64_t newHead;
+        do {
+            next_[idx].store(index(oldHead), std::memory_order_relaxed);
+            newHead = pack(idx, tag(oldHead) + 1);
+        } while (!head_.compare_exchange_weak(oldHead, newHead, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+private:
+    /*!
+        @brief  Packs an index and a tag into a value for the head.
+
+        @param  idx
+                The index at the top of the stack.
+
+        @param  tag
+                The update counter.
+
+        @return The packed value.
+    */
+    static uint64_t pack(int const & idx, uint32_t const & tag) {
+        return (static_cast<uint64_t>(tag) << 32) | static_cast<uint32_t>(idx);
+    }
+
+    /*!
+        @brief  Unpacks the index from a value of the head.
+
+        @param  head
+                The packed value.
+
+        @return The index at the top of the stack.
+    */
+    static int index(uint64_t const & head) {
+        return static_cast<int>(static_cast<uint32_t>(head));
+    }
+
+    /*!
+        @brief  Unpacks the tag from a value of the head.
+
+        @param  head
+                The packed value.
+
+        @return The update counter.
+    */
+    static uint32_t tag(uint64_t const & head) {
+        return static_cast<uint32_t>(head >> 32);
+    }
+
+    /** The index at the top of the stack, and the update counter */
+    std::atomic<uint64_t> head_;
+    /** The index below each index on the stack */
+    std::atomic<int> next_[N];
+
+};
+
+} // namespace kty
+
+#endif
@@ -29,7 +29,7 @@ public:
     */
     PoolString(Pool & pool, int const & idx = -1) 
         : pool_(&pool) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (idx == -1) {
             poolIdx_ = alloc();
             operator=("");
@@ -52,9 +52,9 @@ public:
     */
     PoolString(Pool & pool, char const * str) 
         : pool_(&pool) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (::strlen(str) > pool_->max_str_len()) {
-            Log.warning(F("%s: length of str %d is above maximum of %d, will be truncated\n"), PRINT_FUNC, ::strlen(str), pool_->max_str_len());
+            KTY_LOG_WARNING(F("%s: length of str %d is above maximum of %d, will be truncated\n"), PRINT_FUNC, ::strlen(str), pool_->max_str_len());
         }
         poolIdx_ = alloc();
         operator=(str);
@@ -64,8 +64,8 @@ public:
         @brief  Constructor for a pool string.
     */
     PoolString() 
-        : getPoolFunc_(&get_stringpool) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : pool_(get_stringpool(nullptr)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         poolIdx_ = alloc();
         operator=("");
     }
@@ -81,15 +81,15 @@ public:
                 If not provided, a new one will be allocated from the pool.
     */
     PoolString(GetPoolFunc & getPoolFunc, int const & idx = -1) 
-        : getPoolFunc_(&getPoolFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : pool_(getPoolFunc(nullptr)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (idx == -1) {
             poolIdx_ = alloc();
             operator=("");
         }
         else {
             poolIdx_ = idx;
-            (*getPoolFunc_)(nullptr)->inc_ref_count(poolIdx_);
+            pool_->inc_ref_count(poolIdx_);
         }
     }
 
@@ -104,15 +104,15 @@ public:
                 A function that returns a pointer to a string pool when called.
     */
     PoolString(int const & idx, GetPoolFunc & getPoolFunc = get_stringpool) 
-        : getPoolFunc_(&getPoolFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : pool_(getPoolFunc(nullptr)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (idx == -1) {
             poolIdx_ = alloc();
             operator=("");
         }
         else {
             poolIdx_ = idx;
-            (*getPoolFunc_)(nullptr)->inc_ref_count(poolIdx_);
+            pool_->inc_ref_count(poolIdx_);
         }
     }
 
@@ -127,10 +127,10 @@ public:
                 The initial string to store.
     */
     PoolString(GetPoolFunc & getPoolFunc, char const * str) 
-        : getPoolFunc_(&getPoolFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : pool_(getPoolFunc(nullptr)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (::strlen(str) > pool_->max_str_len()) {
-            Log.warning(F("%s: length of str %d is above maximum of %d, will be truncated\n"), PRINT_FUNC, ::strlen(str), pool_->max_str_len());
+            KTY_LOG_WARNING(F("%s: length of str %d is above maximum of %d, will be truncated\n"), PRINT_FUNC, ::strlen(str), pool_->max_str_len());
         }
         poolIdx_ = alloc();
         operator=(str);
@@ -147,10 +147,10 @@ public:
                 when called.
     */
     PoolString(char const * str, GetPoolFunc & getPoolFunc = get_stringpool) 
-        : getPoolFunc_(&getPoolFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : pool_(getPoolFunc(nullptr)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (::strlen(str) > pool_->max_str_len()) {
-            Log.warning(F("%s: length of str %d is above maximum of %d, will be truncated\n"), PRINT_FUNC, ::strlen(str), pool_->max_str_len());
+            KTY_LOG_WARNING(F("%s: length of str %d is above maximum of %d, will be truncated\n"), PRINT_FUNC, ::strlen(str), pool_->max_str_len());
         }
         poolIdx_ = alloc();
         operator=(str);
@@ -179,15 +179,8 @@ public:
                 has been performed.
     */
     PoolString& operator=(char const * str) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        if (pool_ != nullptr) {
-            Log.verbose(F("%s: pool\n"), PRINT_FUNC);
-            pool_->strcpy(poolIdx_, str);
-        }
-        else {
-            Log.verbose(F("%s: getPoolFunc\n"), PRINT_FUNC);
-            (*getPoolFunc_)(nullptr)->strcpy(poolIdx_, str);
-        }
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        pool_->strcpy(poolIdx_, str);
         return *this;
     }
 
@@ -201,17 +194,12 @@ public:
                 has been performed.
     */
     PoolString& operator=(PoolString const & str) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (pool_ != nullptr && pool_->owns(poolIdx_)) {
-            Log.verbose(F("%s: properly initialised pool string\n"), PRINT_FUNC);
+            KTY_LOG_VERBOSE(F("%s: properly initialised pool string\n"), PRINT_FUNC);
             pool_->deallocate_idx(poolIdx_);
         }
-        else if (getPoolFunc_ != nullptr && (*getPoolFunc_)(nullptr)->owns(poolIdx_)) {
-            Log.verbose(F("%s: properly initialised getPoolFunc string\n"), PRINT_FUNC);
-            (*getPoolFunc_)(nullptr)->deallocate_idx(poolIdx_);
-        }
         pool_ = str.pool_;
-        getPoolFunc_ = str.getPoolFunc_;
         poolIdx_ = alloc();
         operator=(str.c_str());
         return *this;
@@ -224,39 +212,20 @@ public:
         if (poolIdx_ >= 0) {
             dalloc(poolIdx_);
         }
-        /*if (pool_ != nullptr && pool_->owns(poolIdx_)) {
-            Log.verbose(F("%s: returning %d: \"%s\" using pool\n"), PRINT_FUNC, poolIdx_, c_str());
-            pool_->deallocate_idx(poolIdx_);
-        }
-        else if (getPoolFunc_ != nullptr && (*getPoolFunc_)(nullptr)->owns(poolIdx_)) {
-            Log.verbose(F("%s: returning %d: \"%s\" using getPoolFunc\n"), PRINT_FUNC, poolIdx_, c_str());
-            (*getPoolFunc_)(nullptr)->deallocate_idx(poolIdx_);
-        }*/
     }
 
     /*!
-        @brief  Performs the correct allocation depending on whether
-                a string pool object is given, or if a function to get
-                a string pool object is given.
+        @brief  Allocates an index from the string pool of this string.
 
         @return The allocated index.
     */
     int alloc() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        if (pool_ != nullptr) {
-            Log.verbose(F("%s: pool\n"), PRINT_FUNC);
-            return pool_->allocate_idx();
-        }
-        else {
-            Log.verbose(F("%s: getPoolFunc\n"), PRINT_FUNC);
-            return (*getPoolFunc_)(nullptr)->allocate_idx();
-        }
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return pool_->allocate_idx();
     }
 
     /*!
-        @brief  Performs the correct deallocation depending on whether
-                a string pool object is given, or if a function to get
-                a string pool object is given.
+        @brief  Returns an index to the string pool of this string.
 
         @param  idx
                 The index to deallocate.
@@ -264,15 +233,17 @@ public:
         @return True if the deallocation was successful, false otherwise.
     */
     bool dalloc(int const & idx) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        if (pool_ != nullptr) {
-            Log.verbose(F("%s: pool\n"), PRINT_FUNC);
-            return pool_->deallocate_idx(idx);
-        }
-        else {
-            Log.verbose(F("%s: getPoolFunc\n"), PRINT_FUNC);
-            return (*getPoolFunc_)(nullptr)->deallocate_idx(idx);
-        }
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return pool_->deallocate_idx(idx);
+    }
+
+    /*!
+        @brief  Gets the string pool used by this string.
+
+        @return A reference to the string pool.
+    */
+    Pool & pool() const {
+        return *pool_;
     }
 
     /*!
@@ -291,12 +262,7 @@ public:
         @return A pointer to the first character in the string.
     */
     char* c_str() const {
-        if (pool_ != nullptr) {
-            return pool_->c_str(poolIdx_);
-        }
-        else {
-            return (*getPoolFunc_)(nullptr)->c_str(poolIdx_);
-        }
+        return pool_->c_str(poolIdx_);
     }
 
     /*!
@@ -306,12 +272,7 @@ public:
                 The string to copy from.
     */
     void strcpy(char const * str) {
-        if (pool_ != nullptr) {
-            pool_->strcpy(poolIdx_, str);
-        }
-        else {
-            (*getPoolFunc_)(nullptr)->strcpy(poolIdx_, str);
-        }
+        pool_->strcpy(poolIdx_, str);
     }
 
     /*!
@@ -321,12 +282,7 @@ public:
                 The string to concatenate onto this string.
     */
     void strcat(char const * str) {
-        if (pool_ != nullptr) {
-            pool_->strcat(poolIdx_, str);
-        }
-        else {
-            (*getPoolFunc_)(nullptr)->strcat(poolIdx_, str);
-        }
+        pool_->strcat(poolIdx_, str);
     }
 
     /*!
@@ -387,7 +343,7 @@ public:
         @return The resulting string after appending the given string.
     */
     PoolString operator+(char const * str) const {
-        PoolString result(c_str());
+        PoolString result(*pool_, c_str());
         result += str;
         return result;
     }
@@ -403,8 +359,7 @@ public:
         @return The resulting string after appending the given string.
     */
     PoolString operator+(PoolString const & str) const {
-        PoolString result(c_str());
-        result = c_str();
+        PoolString result(*pool_, c_str());
         result += str;
         return result;
     }
@@ -589,7 +544,7 @@ public:
         int lenToCopy = length < maxStrLen ? length : maxStrLen;
         ::strncpy(buffer, c_str() + begin, lenToCopy);
         buffer[lenToCopy] = '\0';
-        PoolString substring(buffer);
+        PoolString substring(*pool_, buffer);
         return substring;
     }
 
@@ -610,7 +565,7 @@ public:
         if (end == -1) {
             end = strlen();
         }
-        PoolString substring;
+        PoolString substring(*pool_);
         char str_[2] = " ";
         for (int i = begin; i < end; ++i) {
             str_[0] = c_str()[i];
@@ -624,8 +579,6 @@ private:
     int poolIdx_ = -1;
     /** A pointer to the pool for this string. */
     Pool * pool_ = nullptr;
-    /** A pointer to a function that returns a pointer to a pool. */
-    GetPoolFunc * getPoolFunc_ = nullptr;
 
 };
 
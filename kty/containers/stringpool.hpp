@@ -6,45 +6,27 @@
 namespace kty {
 
 /*!
-    @brief  Class that maintains all the strings in the program.
-            The memory pool is created on the stack to avoid heap fragmentation.
-            Holds enough memory to allocate N strings of at most length S.            
+    @brief  Class that holds the characters of N strings of at most length S,
+            without keeping track of which are taken.
+            Shared by StringPool and ConcurrentStringPool, which differ only
+            in how they keep track of the strings taken.
 */
 template <int N = Sizes::stringpool_size, int S = Sizes::string_length>
-class StringPool {
+class StringStorage {
 
 public:
     /*!
-        @brief  Constructor for the string pool
+        @brief  Constructor for the string storage, with all strings empty.
     */
-    StringPool() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+    StringStorage() {
         memset((void*)pool_, '\0', N * (S + 1));
-        memset((void*)refCount_, 0, N * sizeof(int));
-        numTaken_ = 0;
-        maxNumTaken_ = 0;
-    }
-
-    /*!
-        @brief  Prints stats about the string pool.
-    */
-    void stat() const {
-        Log.notice(F("%s: num taken = %d, max num taken = %d\n"), PRINT_FUNC, numTaken_, maxNumTaken_);
-    }
-
-    /*!
-        @brief  Resets the stats about the string pool.
-    */
-    void reset_stat() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        maxNumTaken_ = numTaken_;
     }
 
     /*!
         @brief  Prints the addresses used by the string database
     */
     void dump_addresses() const {
-        Log.notice(F("%s: Pool addresses = %d to %d\n"), PRINT_FUNC, (intptr_t)pool_, (intptr_t)(pool_ + N * (S + 1) - 1));
+        KTY_LOG_NOTICE(F("%s: Pool addresses = %d to %d\n"), PRINT_FUNC, (intptr_t)pool_, (intptr_t)(pool_ + N * (S + 1) - 1));
     }
 
     /*!
@@ -53,7 +35,7 @@ public:
         @return The maximum possible string length.
     */
     int max_str_len() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         return S;
     }
 
@@ -66,17 +48,126 @@ public:
         @return True if the index is owned by this pool, false otherwise.
     */
     bool owns(int const & idx) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         return idx >= 0 && idx < N;
     }
 
+    /*!
+        @brief  Returns the string at a given index.
+
+        @param  idx
+                The database index for the string.
+
+        @return str
+                The stored string.
+    */
+    char * c_str(int const & idx) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (idx >= 0 && idx < N) {
+            return const_cast<char *>(pool_) + (idx * (S + 1));
+        }
+        KTY_LOG_WARNING(F("%s: Index %d is invalid, index range is [0, %d]\n"), PRINT_FUNC, idx, N - 1);
+        return nullptr;
+    }
+
+    /*!
+        @brief  Sets a string in the database, with an optional
+                index to start from.
+
+        @param  idx
+                The database index for the string.
+
+        @param  str
+                The incoming string.
+        
+        @param  i
+                The optional starting index within the string to
+                start copying from.
+                Default is index 0.
+    */
+    void strcpy(int const & idx, char const * str, int const & i = 0) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        int copyStrLen = ::strlen(str);
+        int lenToCopy = (S < copyStrLen ? S : copyStrLen) - i;
+        ::strncpy(c_str(idx) + i, str, lenToCopy);
+        *(c_str(idx) + i + lenToCopy) = '\0';
+    }
+
+    /*!
+        @brief  Concatenates another string to the end of a string
+                in the pool.
+
+        @param  idx
+                The database index for the string.
+
+        @param  str
+                The incoming string which will be concatenated onto the end.
+    */
+    void strcat(int const & idx, char const * str) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        int currLen = ::strlen(c_str(idx));
+        int catStrLen = ::strlen(str);
+        // Length to cat is minimum of remaining space and length of string to cat
+        int lenToCat = ((S - currLen) < catStrLen ? (S - currLen) : catStrLen);
+        KTY_LOG_VERBOSE(F("%s: length to cat %d\n"), PRINT_FUNC, lenToCat);
+        strncpy(c_str(idx) + currLen, str, lenToCat);
+        *(c_str(idx) + currLen + lenToCat) = '\0';
+    }
+
+protected:
+    char pool_[N * (S + 1)];
+
+};
+
+/*!
+    @brief  Class that maintains all the strings in the program.
+            The memory pool is created on the stack to avoid heap fragmentation.
+            Holds enough memory to allocate N strings of at most length S.            
+*/
+template <int N = Sizes::stringpool_size, int S = Sizes::string_length>
+class StringPool : public StringStorage<N, S> {
+
+public:
+    using StringStorage<N, S>::owns;
+    using StringStorage<N, S>::c_str;
+    using StringStorage<N, S>::strcpy;
+
+    /*!
+        @brief  Constructor for the string pool
+    */
+    StringPool() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        memset((void*)refCount_, 0, N * sizeof(int));
+        memset((void*)isInterned_, 0, sizeof(isInterned_));
+        for (int i = 0; i < NUM_INTERN_BUCKETS; ++i) {
+            internBuckets_[i] = -1;
+        }
+        numTaken_ = 0;
+        maxNumTaken_ = 0;
+    }
+
+    /*!
+        @brief  Prints stats about the string pool.
+    */
+    void stat() const {
+        KTY_LOG_NOTICE(F("%s: num taken = %d, max num taken = %d\n"), PRINT_FUNC, numTaken_, maxNumTaken_);
+    }
+
+    /*!
+        @brief  Resets the stats about the string pool.
+    */
+    void reset_stat() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        maxNumTaken_ = numTaken_;
+    }
+
     /*!
         @brief  Check the number of available blocks left in the pool.
 
         @return The number of available blocks left in the pool.
     */
     int available() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         return N - numTaken_;
     }
 
@@ -90,11 +181,11 @@ public:
                 If the index is invalid, -1 is returned.
     */
     int ref_count(int const & idx) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (idx >=0 && idx < N) {
             return refCount_[idx];
         }
-        Log.warning(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
+        KTY_LOG_WARNING(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
         return -1;
     }
 
@@ -108,12 +199,12 @@ public:
                 If the address is invalid, -1 is returned.
     */
     int inc_ref_count(int const & idx) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (idx >=0 && idx < N) {
             ++refCount_[idx];
             return refCount_[idx];
         }
-        Log.warning(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
+        KTY_LOG_WARNING(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
         return -1;
     }
 
@@ -131,12 +222,12 @@ public:
                 If the address is invalid, -1 is returned.
     */
     int dec_ref_count(int const & idx) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (idx >=0 && idx < N) {
             --refCount_[idx];
             return refCount_[idx];
         }
-        Log.warning(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
+        KTY_LOG_WARNING(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
         return -1;
     }
 
@@ -147,21 +238,24 @@ public:
                 -1 otherwise.
     */
     int allocate_idx() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         for (int i = 0; i < N; ++i) {
             if (refCount_[i] == 0) {
                 ++refCount_[i];
                 ++numTaken_;
-                Log.trace(F("%s: Allocating index %d\n"), PRINT_FUNC, i);
+                KTY_LOG_TRACE(F("%s: Allocating index %d\n"), PRINT_FUNC, i);
+                // Strings left at no references by dec_ref_count() may
+                // still be interned
+                forget_interned(i);
                 memset((void*)(pool_ + (i * (S + 1))), '\0', S + 1);
                 if (numTaken_ > maxNumTaken_) {
                     maxNumTaken_ = numTaken_;
-                    Log.trace(F("%s: new maxNumTaken %d\n"), PRINT_FUNC, maxNumTaken_);
+                    KTY_LOG_TRACE(F("%s: new maxNumTaken %d\n"), PRINT_FUNC, maxNumTaken_);
                 }
                 return i;
             }
         }
-        Log.warning(F("%s: No more string indices to allocate\n"), PRINT_FUNC);
+        KTY_LOG_WARNING(F("%s: No more string indices to allocate\n"), PRINT_FUNC);
         return -1;
     }
 
@@ -174,94 +268,142 @@ public:
         @return True if the deallocation was successful, false otherwise.
     */
     bool deallocate_idx(int const & idx) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (idx < 0 || idx >= N) {
-            Log.warning(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
+            KTY_LOG_WARNING(F("%s: Index %d did not come from pool\n"), PRINT_FUNC, idx);
             return false;
         }
         if (refCount_[idx] > 0) {
             --refCount_[idx];
         }
         else {
-            Log.warning(F("%s: Index %d has already been previously deallocated\n"), PRINT_FUNC, idx);
+            KTY_LOG_WARNING(F("%s: Index %d has already been previously deallocated\n"), PRINT_FUNC, idx);
             return false;
         }
         if (refCount_[idx] == 0) {
             --numTaken_;
-            Log.trace(F("%s: Index %d deallocated successfully\n"), PRINT_FUNC, idx);                
+            forget_interned(idx);
+            KTY_LOG_TRACE(F("%s: Index %d deallocated successfully\n"), PRINT_FUNC, idx);                
             return true;
         }
         else {
-            Log.trace(F("%s: Index %d is not the last reference\n"), PRINT_FUNC, idx);
+            KTY_LOG_TRACE(F("%s: Index %d is not the last reference\n"), PRINT_FUNC, idx);
             return true;
         }
     }
 
     /*!
-        @brief  Returns the string at a given index.
+        @brief  Gets the index of the interned string equal to a given string,
+                interning it first if there is none yet.
+                Equal strings interned in this pool always share one index,
+                so they can be told apart by their index alone.
+                The caller takes a reference to the index, and lets go of it
+                with deallocate_idx() like any other.
 
-        @param  idx
-                The database index for the string.
+        @param  str
+                The string to intern.
 
-        @return str
-                The stored string.
+        @return The index of the interned string,
+                or -1 if the pool is out of strings.
     */
-    char * c_str(int const & idx) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        if (idx >= 0 && idx < N) {
-            return const_cast<char *>(pool_) + (idx * (S + 1));
+    int intern(char const * str) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        int idx = find_interned(str);
+        if (idx >= 0) {
+            ++refCount_[idx];
+            return idx;
         }
-        Log.warning(F("%s: Index %d is invalid, index range is [0, %d]\n"), PRINT_FUNC, idx, N - 1);
-        return nullptr;
+        idx = allocate_idx();
+        if (idx >= 0) {
+            strcpy(idx, str);
+            int bucket = intern_bucket(c_str(idx));
+            internNext_[idx] = internBuckets_[bucket];
+            internBuckets_[bucket] = idx;
+            isInterned_[idx / 8] |= (1 << (idx % 8));
+        }
+        return idx;
     }
 
     /*!
-        @brief  Sets a string in the database, with an optional
-                index to start from.
-
-        @param  idx
-                The database index for the string.
+        @brief  Gets the index of the interned string equal to a given string,
+                without interning it or taking a reference.
 
         @param  str
-                The incoming string.
-        
-        @param  i
-                The optional starting index within the string to
-                start copying from.
-                Default is index 0.
+                The string to look for.
+
+        @return The index of the interned string,
+                or -1 if the string is not interned.
     */
-    void strcpy(int const & idx, char const * str, int const & i = 0) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        int copyStrLen = ::strlen(str);
-        int lenToCopy = (S < copyStrLen ? S : copyStrLen) - i;
-        ::strncpy(c_str(idx) + i, str, lenToCopy);
-        *(c_str(idx) + i + lenToCopy) = '\0';
+    int find_interned(char const * str) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        for (int i = internBuckets_[intern_bucket(str)]; i >= 0; i = internNext_[i]) {
+            if (::strncmp(pool_ + (i * (S + 1)), str, S) == 0) {
+                return i;
+            }
+        }
+        return -1;
     }
 
     /*!
-        @brief  Concatenates another string to the end of a string
-                in the pool.
+        @brief  Checks if the string at an index is interned.
 
         @param  idx
-                The database index for the string.
+                The index to check.
 
-        @param  str
-                The incoming string which will be concatenated onto the end.
+        @return True if the string is interned, false otherwise.
     */
-    void strcat(int const & idx, char const * str) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        int currLen = ::strlen(c_str(idx));
-        int catStrLen = ::strlen(str);
-        // Length to cat is minimum of remaining space and length of string to cat
-        int lenToCat = ((S - currLen) < catStrLen ? (S - currLen) : catStrLen);
-        Log.verbose(F("%s: length to cat %d\n"), PRINT_FUNC, lenToCat);
-        strncpy(c_str(idx) + currLen, str, lenToCat);
-        *(c_str(idx) + currLen + lenToCat) = '\0';
+    bool is_interned(int const & idx) const {
+        return idx >= 0 && idx < N && (isInterned_[idx / 8] & (1 << (idx % 8))) != 0;
     }
 
 private:
-    char pool_[N * (S + 1)];
+    /** The number of hash buckets that interned strings are spread over */
+    static const int NUM_INTERN_BUCKETS = N / 4 + 1;
+
+    /*!
+        @brief  Gets the hash bucket of a string, for interning.
+                Only the characters that fit in the pool count.
+
+        @param  str
+                The string.
+
+        @return The index of the bucket.
+    */
+    static int intern_bucket(char const * str) {
+        unsigned int hash = 0;
+        for (int i = 0; i < S && str[i] != '\0'; ++i) {
+            hash = hash * 31 + (unsigned char)str[i];
+        }
+        return hash % NUM_INTERN_BUCKETS;
+    }
+
+    /*!
+        @brief  Stops the string at an index from being interned, if it is.
+
+        @param  idx
+                The index of the string.
+    */
+    void forget_interned(int const & idx) {
+        if (!is_interned(idx)) {
+            return;
+        }
+        isInterned_[idx / 8] &= ~(1 << (idx % 8));
+        int * link = &internBuckets_[intern_bucket(c_str(idx))];
+        while (*link != idx) {
+            link = &internNext_[*link];
+        }
+        *link = internNext_[idx];
+    }
+
+    using StringStorage<N, S>::pool_;
+
     int refCount_[N];
+    /** One bit per string, set if the string is interned */
+    unsigned char isInterned_[(N + 7) / 8];
+    /** The first interned string of each hash bucket, or -1 if none */
+    int internBuckets_[NUM_INTERN_BUCKETS];
+    /** The next interned string in the same bucket, or -1 if none */
+    int internNext_[N];
     int numTaken_;
     int maxNumTaken_;
 
@@ -276,7 +418,7 @@ private:
 
     @return A pointer to a stringpool.
 */
-StringPool<Sizes::stringpool_size, Sizes::string_length> * get_stringpool(StringPool<Sizes::stringpool_size, Sizes::string_length> * ptr) {
+StringPool<Sizes::stringpool_size, Sizes::string_length> * get_stringpool(StringPool<Sizes::stringpool_size, Sizes::string_length> * ptr = nullptr) {
     static StringPool<Sizes::stringpool_size, Sizes::string_length> * stringPool;
     if (ptr != nullptr) {
         stringPool = ptr;
@@ -284,6 +426,31 @@ StringPool<Sizes::stringpool_size, Sizes::string_length> * get_stringpool(String
     return stringPool;
 }
 
+#if !defined(ARDUINO)
+
+/*!
+    @brief  Returns a pointer to the stringpool of the calling thread.
+            Every thread gets its own stringpool, so threads never contend
+            for strings. Has the same signature as get_stringpool, so it can
+            be used in its place.
+
+    @param  ptr
+            Used to set the address to return for subsequent calls
+            from the calling thread.
+
+    @return A pointer to the stringpool of the calling thread.
+*/
+StringPool<Sizes::stringpool_size, Sizes::string_length> * get_thread_stringpool(StringPool<Sizes::stringpool_size, Sizes::string_length> * ptr = nullptr) {
+    static thread_local StringPool<Sizes::stringpool_size, Sizes::string_length> threadStringPool;
+    static thread_local StringPool<Sizes::stringpool_size, Sizes::string_length> * stringPool = &threadStringPool;
+    if (ptr != nullptr) {
+        stringPool = ptr;
+    }
+    return stringPool;
+}
+
+#endif
+
 /*!
     @brief  Class to perform setup of the get_stringpool function at the global scope.
 */
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <kty/containers/allocator.hpp>
+#include <kty/containers/deque.hpp>
+#include <kty/containers/string.hpp>
+#include <kty/containers/stringpool.hpp>
+#include <kty/machine_state.hpp>
+#include <kty/runtime.hpp>
+#include <kty/sizes.hpp>
+#include <kty/symbol.hpp>
+#include <kty/types.hpp>
+
+namespace kty {
+
+/** The ways of moving between the start and end of a fade */
+enum FadeCurve {
+    LINEAR = 0,
+    GAMMA,
+};
+
+/*!
+    @brief  Class that fades LEDs from one brightness to another over time.
+            The PWM outputs of all fading LEDs are updated together on a fixed
+            tick of Sizes::fade_tick_ms milliseconds. The output on each tick
+            is worked out from the time since the fade started, so a late
+            tick never slows a fade down.
+            Fades are either linear in the PWM output, or gamma-corrected,
+            which looks more even to the eye since it perceives changes at
+            low brightness more strongly.
+*/
+template <typename Runtime = Runtime<>, typename PoolString = PoolString<>>
+class Fader {
+
+public:
+    /** The type of symbol that LEDs are named by */
+    typedef Symbol<typename Runtime::stringpool_t> symbol_t;
+
+    /*!
+        @brief  Constructor for the fader.
+
+        @param  runtime
+                The runtime to allocate from.
+                If not provided, the globals returned by get_alloc and
+                get_stringpool are used.
+    */
+    explicit Fader(Runtime const & runtime = Runtime())
+        : runtime_(runtime), fades_(runtime.alloc()) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        lastTick_ = 0;
+    }
+
+    /*!
+        @brief  Stops all fades, leaving the LEDs where they are.
+    */
+    void clear() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        fades_.clear();
+    }
+
+    /*!
+        @brief  Checks if there are no fades left.
+
+        @return True if there are no fades, false otherwise.
+    */
+    bool is_empty() const {
+        return fades_.is_empty();
+    }
+
+    /*!
+        @brief  Starts fading an LED, replacing any fade it already has.
+
+        @param  name
+                The name of the LED.
+
+        @param  from
+                The brightness the LED is at, in percent.
+
+        @param  to
+                The brightness to fade to, in percent.
+
+        @param  durationMs
+                The number of milliseconds the fade takes.
+
+        @param  curve
+                How to move between the two brightnesses.
+
+        @param  now
+                The current time, from the clock.
+
+        @return True if the fade was started, false if there was not
+                enough memory.
+    */
+    bool start(symbol_t const & name, int const & from, int const & to,
+               int const & durationMs, FadeCurve const & curve, unsigned long const & now) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        stop(name);
+        // The first tick of a new fade is a whole tick away
+        if (fades_.is_empty()) {
+            lastTick_ = now;
+        }
+        if (!fades_.push_back(Fade{name, now, durationMs, (char)from, (char)to, (char)curve})) {
+            KTY_LOG_WARNING(F("%s: Unable to fade %s\n"), PRINT_FUNC, name.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /*!
+        @brief  Starts fading an LED, replacing any fade it already has.
+
+        @param  name
+                The name of the LED.
+
+        @param  from
+                The brightness the LED is at, in percent.
+
+        @param  to
+                The brightness to fade to, in percent.
+
+        @param  durationMs
+                The number of milliseconds the fade takes.
+
+        @param  curve
+                How to move between the two brightnesses.
+
+        @param  now
+                The current time, from the clock.
+
+        @return True if the fade was started, false if there was not
+                enough memory.
+    */
+    bool start(PoolString const & name, int const & from, int const & to,
+               int const & durationMs, FadeCurve const & curve, unsigned long const & now) {
+        symbol_t symbol(runtime_.stringpool(), name.c_str());
+        return !symbol.is_empty() && start(symbol, from, to, durationMs, curve, now);
+    }
+
+    /*!
+        @brief  Stops the fade of an LED, if it has one,
+                leaving it where it is.
+
+        @param  name
+                The name of the LED.
+    */
+    void stop(symbol_t const & name) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        for (typename Deque<Fade>::Iterator it = fades_.begin(); it != fades_.end(); ++it) {
+            if (it->name == name) {
+                fades_.erase(it);
+                break;
+            }
+        }
+        if (fades_.is_empty()) {
+            fades_.release_head();
+        }
+    }
+
+    /*!
+        @brief  Stops the fade of an LED, if it has one,
+                leaving it where it is.
+
+        @param  name
+                The name of the LED.
+    */
+    void stop(PoolString const & name) {
+        stop(symbol_t::find(runtime_.stringpool(), name.c_str()));
+    }
+
+    /*!
+        @brief  Updates the PWM outputs and brightness of all fading LEDs,
+                if a tick has passed since the last update.
+                LEDs which have reached the end of their fade are set to their
+                final brightness straight away, tick or not, and stop fading.
+
+        @param  now
+                The current time, from the clock.
+
+        @param  machineState
+                The machine state holding the LEDs.
+    */
+    template <typename MachineState>
+    void tick(unsigned long const & now, MachineState & machineState) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (fades_.is_empty()) {
+            return;
+        }
+        bool isTick = now - lastTick_ >= (unsigned long)Sizes::fade_tick_ms;
+        if (isTick) {
+            lastTick_ = now;
+        }
+        typename Deque<Fade>::Iterator it = fades_.begin();
+        while (it != fades_.end()) {
+            long elapsed = (long)(now - it->start);
+            if (!isTick && elapsed < it->durationMs) {
+                ++it;
+                continue;
+            }
+            // LEDs which are gone or replaced stop fading
+            if (machineState.get_device_type(it->name) != DeviceType::LED) {
+                it = fades_.erase(it);
+                continue;
+            }
+            int pin = machineState.get_device_info(it->name, 1);
+            if (elapsed >= it->durationMs) {
+                analogWrite(pin, it->to * 2.55);
+                machineState.set_device(it->name, DeviceType::LED, -1, pin, it->to);
+                it = fades_.erase(it);
+                continue;
+            }
+            int duty = fade_duty(it->from, it->to, elapsed, it->durationMs, (FadeCurve)it->curve);
+            analogWrite(pin, duty);
+            machineState.set_device(it->name, DeviceType::LED, -1, pin, (duty * 100 + 127) / 255);
+            ++it;
+        }
+        if (fades_.is_empty()) {
+            fades_.release_head();
+        }
+    }
+
+    /*!
+        @brief  Gets the time left until the next tick.
+
+        @param  now
+                The current time, from the clock.
+
+        @return The number of milliseconds until the next tick,
+                0 if a tick is already due, or -1 if there are no fades.
+    */
+    long time_until_next(unsigned long const & now) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (fades_.is_empty()) {
+            return -1;
+        }
+        long timeLeft = Sizes::fade_tick_ms - (long)(now - lastTick_);
+        return timeLeft > 0 ? timeLeft : 0;
+    }
+
+    /*!
+        @brief  Works out the PWM output part of the way through a fade.
+
+        @param  from
+                The brightness at the start of the fade, in percent.
+
+        @param  to
+                The brightness at the end of the fade, in percent.
+
+        @param  elapsed
+                The number of milliseconds since the fade started.
+
+        @param  durationMs
+                The number of milliseconds the fade takes.
+
+        @param  curve
+                How to move between the two brightnesses.
+
+        @return The PWM output, from 0 to 255.
+    */
+    static int fade_duty(int const & from, int const & to, long const & elapsed,
+                         int const & durationMs, FadeCurve const & curve) {
+        long fromDuty = from * 255L / 100;
+        long toDuty = to * 255L / 100;
+        if (elapsed >= durationMs) {
+            return toDuty;
+        }
+        if (curve == FadeCurve::GAMMA) {
+            // Perceived brightness goes roughly with the square root of the
+            // output, so that is what moves linearly
+            long fromLevel = isqrt(fromDuty * 255);
+            long toLevel = isqrt(toDuty * 255);
+            long level = fromLevel + (toLevel - fromLevel) * elapsed / durationMs;
+            return level * level / 255;
+        }
+        return fromDuty + (toDuty - fromDuty) * elapsed / durationMs;
+    }
+
+private:
+    /*!
+        @brief  Gets the integer square root of a number.
+
+        @param  n
+                The number, which must not be negative.
+
+        @return The largest integer whose square is at most n.
+    */
+    static long isqrt(long const & n) {
+        long root = 0;
+        long bit = 1L << 30;
+        long rest = n;
+        while (bit > rest) {
+            bit >>= 2;
+        }
+        while (bit != 0) {
+            if (rest >= root + bit) {
+                rest -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else {
+                root >>= 1;
+            }
+            bit >>= 2;
+        }
+        return root;
+    }
+
+    /*!
+        @brief  A single LED being faded.
+    */
+    struct Fade {
+        /** The name of the LED */
+        symbol_t name;
+        /** The time at which the fade started, from the clock */
+        unsigned long start;
+        /** The number of milliseconds the fade takes */
+        int durationMs;
+        /** The brightness at the start of the fade, in percent */
+        char from;
+        /** The brightness at the end of the fade, in percent */
+        char to;
+        /** How to move between the two brightnesses */
+        char curve;
+    };
+
+    Runtime runtime_;
+    /** The LEDs being faded */
+    Deque<Fade> fades_;
+    /** The time of the last tick */
+    unsigned long lastTick_;
+
+};
+
+} // namespace kty
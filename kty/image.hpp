@@ -0,0 +1,251 @@
+#pragma once
+
+#include <kty/types.hpp>
+
+#if defined(ARDUINO)
+#include <avr/pgmspace.h>
+#endif
+
+namespace kty {
+
+/*!
+    Layout of a precompiled image of a script, version 1.
+    Numbers are little-endian, and strings end with a '\0'.
+
+        "KTYI"                          magic
+        u8                              version
+        u16 n, n * string               symbol table, the names declared
+        u16 n, n * (u16 sym, i32)       constants
+        u16 n, n * (u16 sym, i32)       numbers
+        u16 n, n * (u16 sym, u8 type,   devices
+                    i32, i32, i32)
+        u16 n, n * (u16 sym, u16 m,     groups, with their commands as
+                    m * string)         they are kept by the interpreter
+        string...                       commands to run after loading,
+                                        up to the end of the image
+
+    Names are referred to by their index in the symbol table.
+*/
+
+/** The characters every image starts with */
+constexpr char imageMagic[] = "KTYI";
+/** The length of the magic characters */
+constexpr int imageMagicLen = sizeof(imageMagic) - 1;
+/** The version of the layout, changed whenever the layout changes */
+constexpr unsigned char imageVersion = 1;
+
+/*!
+    @brief  Class that reads the values an image is made of, in order.
+            On Arduino the image is read from program memory.
+            Nothing is read past the end of the image. Reads which would go
+            past it give 0 instead, and mark the image as cut short.
+*/
+class ImageReader {
+
+public:
+    /*!
+        @brief  Constructor for a reader at the start of an image.
+
+        @param  image
+                The image, in program memory on Arduino.
+
+        @param  size
+                The number of bytes in the image.
+    */
+    ImageReader(unsigned char const * image, unsigned long const & size)
+        : image_(image), size_(size), pos_(0), isOk_(true) {
+    }
+
+    /*!
+        @brief  Reads the start of the image, which says what it is.
+
+        @return True if this is an image of the current version,
+                false otherwise.
+    */
+    bool read_header() {
+        for (int i = 0; i < imageMagicLen; ++i) {
+            if (read_u8() != (unsigned char)imageMagic[i]) {
+                return false;
+            }
+        }
+        return read_u8() == imageVersion && isOk_;
+    }
+
+    /*!
+        @brief  Reads an unsigned 8-bit number.
+
+        @return The number.
+    */
+    unsigned char read_u8() {
+        if (pos_ >= size_) {
+            isOk_ = false;
+            return 0;
+        }
+#if defined(ARDUINO)
+        return pgm_read_byte_near(image_ + pos_++);
+#else
+        return image_[pos_++];
+#endif
+    }
+
+    /*!
+        @brief  Reads an unsigned 16-bit number.
+
+        @return The number.
+    */
+    unsigned int read_u16() {
+        unsigned int low = read_u8();
+        return low | (unsigned int)read_u8() << 8;
+    }
+
+    /*!
+        @brief  Reads a signed 32-bit number.
+
+        @return The number.
+    */
+    long read_i32() {
+        unsigned long value = read_u16();
+        value |= (unsigned long)read_u16() << 16;
+        // Negative numbers keep their sign where long is wider than 32 bits
+        if (value & 0x80000000UL) {
+            value |= ~0xFFFFFFFFUL;
+        }
+        return (long)value;
+    }
+
+    /*!
+        @brief  Reads a string.
+                Characters which do not fit in the buffer are skipped.
+
+        @param  buffer
+                Where to save the string.
+
+        @param  bufferLen
+                The number of characters the buffer holds, including the
+                final '\0'.
+
+        @return The length of the string saved.
+    */
+    int read_str(char * buffer, int const & bufferLen) {
+        int len = 0;
+        for (char c = read_u8(); c != '\0'; c = read_u8()) {
+            if (len < bufferLen - 1) {
+                buffer[len++] = c;
+            }
+        }
+        buffer[len] = '\0';
+        return len;
+    }
+
+    /*!
+        @brief  Checks if everything in the image has been read.
+
+        @return True if the end of the image has been reached,
+                false otherwise.
+    */
+    bool is_end() const {
+        return pos_ >= size_;
+    }
+
+    /*!
+        @brief  Checks if every read so far was within the image.
+
+        @return True if nothing was read past the end, false otherwise.
+    */
+    bool is_ok() const {
+        return isOk_;
+    }
+
+private:
+    /** The image */
+    unsigned char const * image_;
+    /** The number of bytes in the image */
+    unsigned long size_;
+    /** The index of the next byte to read */
+    unsigned long pos_;
+    /** Whether every read so far was within the image */
+    bool isOk_;
+
+};
+
+/*!
+    @brief  Class that writes the values an image is made of, in order,
+            to a sink which takes one byte at a time through
+            `void write(unsigned char const & byte)`.
+*/
+template <typename Sink>
+class ImageWriter {
+
+public:
+    /*!
+        @brief  Constructor for a writer.
+
+        @param  sink
+                Where to write the image.
+    */
+    explicit ImageWriter(Sink & sink)
+        : sink_(sink) {
+    }
+
+    /*!
+        @brief  Writes the start of the image, which says what it is.
+    */
+    void write_header() {
+        for (int i = 0; i < imageMagicLen; ++i) {
+            write_u8(imageMagic[i]);
+        }
+        write_u8(imageVersion);
+    }
+
+    /*!
+        @brief  Writes an unsigned 8-bit number.
+
+        @param  value
+                The number.
+    */
+    void write_u8(unsigned char const & value) {
+        sink_.write(value);
+    }
+
+    /*!
+        @brief  Writes an unsigned 16-bit number.
+
+        @param  value
+                The number.
+    */
+    void write_u16(unsigned int const & value) {
+        write_u8(value & 0xFF);
+        write_u8(value >> 8 & 0xFF);
+    }
+
+    /*!
+        @brief  Writes a signed 32-bit number.
+
+        @param  value
+                The number.
+    */
+    void write_i32(long const & value) {
+        write_u16((unsigned long)value & 0xFFFF);
+        write_u16((unsigned long)value >> 16 & 0xFFFF);
+    }
+
+    /*!
+        @brief  Writes a string.
+
+        @param  str
+                The string.
+    */
+    void write_str(char const * str) {
+        for ( ; *str != '\0'; ++str) {
+            write_u8(*str);
+        }
+        write_u8('\0');
+    }
+
+private:
+    /** Where the image is written */
+    Sink & sink_;
+
+};
+
+} // namespace kty
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <kty/containers/deque.hpp>
+#include <kty/containers/string.hpp>
+#include <kty/image.hpp>
+#include <kty/interpreter.hpp>
+#include <kty/machine_state.hpp>
+#include <kty/runtime.hpp>
+#include <kty/string_utils.hpp>
+#include <kty/symbol.hpp>
+#include <kty/token.hpp>
+#include <kty/tokenizer.hpp>
+#include <kty/types.hpp>
+
+namespace kty {
+
+/*!
+    @brief  Class that makes a precompiled image of a script, for
+            Interpreter::load_image to load without tokenizing it.
+            The commands at the start of the script which only declare
+            constants, numbers, LEDs and groups are run on an interpreter of
+            its own, and what they leave behind is saved in the image.
+            Everything from the first command which does something else on
+            is saved as it is, to be executed after loading, since what it
+            does can depend on when it runs.
+*/
+template <typename Runtime = Runtime<>, typename PoolString = PoolString<>, typename Token = Token<>>
+class ImageBuilder {
+
+public:
+    /** The type of symbol that names are held as */
+    typedef typename Interpreter<Runtime, PoolString, Token>::symbol_t symbol_t;
+
+    /*!
+        @brief  Constructor for the image builder.
+
+        @param  runtime
+                The runtime to allocate from.
+                If not provided, the globals returned by get_alloc and
+                get_stringpool are used.
+    */
+    explicit ImageBuilder(Runtime const & runtime = Runtime())
+        : runtime_(runtime), interpreter_(runtime), tokenizer_(runtime),
+          names_(runtime.alloc()), commands_(runtime.alloc()) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        isDeclaring_ = true;
+    }
+
+    /*!
+        @brief  Destructor for the image builder.
+    */
+    ~ImageBuilder() {
+        // Groups keep their commands until the interpreter is reset
+        interpreter_.reset();
+    }
+
+    /*!
+        @brief  Adds the next command of the script.
+
+        @param  command
+                The command.
+    */
+    void add(PoolString const & command) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (isDeclaring_) {
+            // Commands which are part of a group belong to its declaration
+            if (interpreter_.get_prompt_prefix().strlen() > 0) {
+                interpreter_.execute(command);
+                return;
+            }
+            Deque<Token> tokens = tokenizer_.tokenize(command);
+            // Blank lines and comments
+            if (tokens.size() <= 1) {
+                return;
+            }
+            if (tokens.size() > 2 && tokens.front().is_name() && tokens[1].is_create_command()) {
+                add_name(tokens.front().get_symbol());
+                interpreter_.execute(command);
+                return;
+            }
+            isDeclaring_ = false;
+        }
+        // Kept the way the interpreter would keep it, so loading it is the
+        // same as entering it
+        PoolString ownCommand(runtime_.stringpool(), command.c_str());
+        remove_str_multiple_whitespace(ownCommand);
+        interpreter_.inline_constants(ownCommand);
+        commands_.push_back(ownCommand);
+    }
+
+    /*!
+        @brief  Writes the image of the commands added so far.
+
+        @param  sink
+                Where to write the image, which takes one byte at a time
+                through `void write(unsigned char const & byte)`.
+    */
+    template <typename Sink>
+    void write(Sink & sink) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        ImageWriter<Sink> writer(sink);
+        writer.write_header();
+        writer.write_u16(names_.size());
+        for (typename Deque<symbol_t>::Iterator it = names_.begin(); it != names_.end(); ++it) {
+            writer.write_str(it->c_str());
+        }
+
+        writer.write_u16(count_names(&Interpreter<Runtime, PoolString, Token>::constant_exists));
+        int idx = 0;
+        for (typename Deque<symbol_t>::Iterator it = names_.begin(); it != names_.end(); ++it, ++idx) {
+            PoolString name(runtime_.stringpool(), it->c_str());
+            if (interpreter_.constant_exists(name)) {
+                writer.write_u16(idx);
+                writer.write_i32(interpreter_.get_constant_value(name));
+            }
+        }
+
+        writer.write_u16(count_names(&Interpreter<Runtime, PoolString, Token>::number_exists));
+        idx = 0;
+        for (typename Deque<symbol_t>::Iterator it = names_.begin(); it != names_.end(); ++it, ++idx) {
+            PoolString name(runtime_.stringpool(), it->c_str());
+            if (interpreter_.number_exists(name)) {
+                writer.write_u16(idx);
+                writer.write_i32(interpreter_.get_number_value(name));
+            }
+        }
+
+        writer.write_u16(count_names(&Interpreter<Runtime, PoolString, Token>::device_exists));
+        idx = 0;
+        for (typename Deque<symbol_t>::Iterator it = names_.begin(); it != names_.end(); ++it, ++idx) {
+            PoolString name(runtime_.stringpool(), it->c_str());
+            if (interpreter_.device_exists(name)) {
+                writer.write_u16(idx);
+                writer.write_u8(interpreter_.get_device_type(name));
+                for (int info = 0; info < 3; ++info) {
+                    writer.write_i32(interpreter_.get_device_info(name, info));
+                }
+            }
+        }
+
+        writer.write_u16(count_names(&Interpreter<Runtime, PoolString, Token>::group_exists));
+        idx = 0;
+        for (typename Deque<symbol_t>::Iterator it = names_.begin(); it != names_.end(); ++it, ++idx) {
+            PoolString name(runtime_.stringpool(), it->c_str());
+            if (interpreter_.group_exists(name)) {
+                Deque<PoolString> groupCommands = interpreter_.get_group_commands(name);
+                writer.write_u16(idx);
+                writer.write_u16(groupCommands.size());
+                for (typename Deque<PoolString>::Iterator command = groupCommands.begin(); command != groupCommands.end(); ++command) {
+                    writer.write_str(command->c_str());
+                }
+            }
+        }
+
+        for (typename Deque<PoolString>::Iterator it = commands_.begin(); it != commands_.end(); ++it) {
+            writer.write_str(it->c_str());
+        }
+    }
+
+private:
+    /*!
+        @brief  Remembers a declared name, once.
+
+        @param  name
+                The name.
+    */
+    void add_name(symbol_t const & name) {
+        for (typename Deque<symbol_t>::Iterator it = names_.begin(); it != names_.end(); ++it) {
+            if (*it == name) {
+                return;
+            }
+        }
+        names_.push_back(name);
+    }
+
+    /*!
+        @brief  Counts the declared names which are of a kind.
+
+        @param  exists
+                Checks if a name is of the kind.
+
+        @return The number of names of the kind.
+    */
+    template <typename Exists>
+    int count_names(Exists exists) {
+        int count = 0;
+        for (typename Deque<symbol_t>::Iterator it = names_.begin(); it != names_.end(); ++it) {
+            if ((interpreter_.*exists)(PoolString(runtime_.stringpool(), it->c_str()))) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    Runtime runtime_;
+    /** Runs the declarations */
+    Interpreter<Runtime, PoolString, Token> interpreter_;
+    Tokenizer<Runtime, Token, PoolString>   tokenizer_;
+    /** The declared names, in the order they were first declared */
+    Deque<symbol_t>   names_;
+    /** The commands to execute after loading */
+    Deque<PoolString> commands_;
+    /** Whether the commands added so far are all declarations */
+    bool isDeclaring_;
+
+};
+
+} // namespace kty
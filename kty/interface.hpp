@@ -2,6 +2,8 @@
 
 #include <kty/containers/string.hpp>
 #include <kty/containers/stringpool.hpp>
+#include <kty/runtime.hpp>
+#include <kty/sizes.hpp>
 
 namespace kty {
 
@@ -9,18 +11,27 @@ namespace kty {
     @brief  Class that handles interactions between the user(programmer) 
             and the rest of the program.
 */
-template <typename GetPoolFunc = decltype(get_stringpool), typename PoolString = PoolString<>>
+template <typename Runtime = Runtime<>, typename PoolString = PoolString<>>
 class Interface {
 
 public:
+    /** The character sent by Ctrl-C */
+    static const char ABORT_CHAR = 3;
+
     /*!
         @brief  Constructor for the interface.
 
-        @param  getPoolFunc
-                A function that returns a pointer to a string pool when called.
+        @param  runtime
+                The runtime to allocate from.
+                If not provided, the globals returned by get_alloc and
+                get_stringpool are used.
     */
-    explicit Interface(GetPoolFunc & getPoolFunc = get_stringpool) 
-        : getPoolFunc_(&getPoolFunc) {
+    explicit Interface(Runtime const & runtime = Runtime()) 
+        : runtime_(runtime) {
+        inputStart_ = 0;
+        inputSize_ = 0;
+        lineLen_ = 0;
+        isAbort_ = false;
     }
 
     /*!
@@ -83,28 +94,77 @@ public:
     }
 
     /*!
-        @brief  Reads in a command string from the Serial interface until the
-                newline character is read.
-                Blocks until a complete command string is read.
-        
-        @return The command string read from the Serial interface.
+        @brief  Takes the next complete command string typed through the
+                Serial interface, if there is one. Never blocks.
+                Everything the Serial interface has received is moved into
+                the input buffer first, so that the small receive buffer of
+                the Serial interface does not overflow while a pasted script
+                is being run. Whitespace is left out of the command string,
+                and characters past the maximum length of a string are dropped.
+
+        @param  command
+                Where to save the command string read.
+
+        @return True if a complete command string was read, false otherwise.
     */
-    PoolString get_next_command() {
-        PoolString command(*getPoolFunc_);
-        char str[2] = " "; // To use operator += on command_
-        while (true) {
-            if (Serial.available()) {
-                char c = Serial.read();
-                if (c == '\n') { // Finished reading one complete line of input
-                    break;
-                }
-                if (!isspace(c)) {
-                    str[0] = c;
-                    command += str;
-                }
+    bool get_next_command(PoolString & command) {
+        NoTokenizer tokenizer;
+        return get_next_command(command, tokenizer);
+    }
+
+    /*!
+        @brief  Takes the next complete command string typed through the
+                Serial interface, if there is one, while feeding every character
+                kept to a tokenizer in streaming mode as it arrives.
+                Once this returns true, finish() on the tokenizer gives the
+                tokens of the command string straight away.
+
+        @param  command
+                Where to save the command string read.
+
+        @param  tokenizer
+                The tokenizer to feed.
+
+        @return True if a complete command string was read, false otherwise.
+    */
+    template <typename Tokenizer>
+    bool get_next_command(PoolString & command, Tokenizer & tokenizer) {
+        read_input();
+        // Characters after a Ctrl-C wait until read_abort() has reported it,
+        // so they are not fed to a tokenizer still holding the line before it
+        if (isAbort_) {
+            return false;
+        }
+        while (inputSize_ > 0) {
+            char c = input_[inputStart_];
+            inputStart_ = (inputStart_ + 1) % Sizes::input_buffer_size;
+            --inputSize_;
+            if (c == '\n') { // Finished reading one complete line of input
+                line_[lineLen_] = '\0';
+                command = line_;
+                lineLen_ = 0;
+                return true;
+            }
+            if (!isspace(c) && lineLen_ < Sizes::string_length - 1) {
+                line_[lineLen_++] = c;
+                tokenizer.feed(c);
             }
         }
-        return command;
+        return false;
+    }
+
+    /*!
+        @brief  Checks if the user has asked to stop everything that is
+                running, by sending Ctrl-C through the Serial interface.
+                Everything typed before the Ctrl-C is thrown away.
+
+        @return True if the user has asked to stop, false otherwise.
+    */
+    bool read_abort() {
+        read_input();
+        bool isAbort = isAbort_;
+        isAbort_ = false;
+        return isAbort;
     }
 
     /*!
@@ -118,7 +178,45 @@ public:
     }
 
 private:
-    GetPoolFunc * getPoolFunc_;
+    /*!
+        @brief  Stands in for a tokenizer when none is being fed.
+    */
+    struct NoTokenizer {
+        void feed(char const & c) {
+        }
+    };
+
+    /*!
+        @brief  Moves everything the Serial interface has received into the
+                input buffer, for as long as there is space.
+    */
+    void read_input() {
+        while (inputSize_ < Sizes::input_buffer_size && Serial.available()) {
+            char c = Serial.read();
+            if (c == ABORT_CHAR) {
+                inputSize_ = 0;
+                lineLen_ = 0;
+                isAbort_ = true;
+                continue;
+            }
+            input_[(inputStart_ + inputSize_) % Sizes::input_buffer_size] = c;
+            ++inputSize_;
+        }
+    }
+
+    Runtime runtime_;
+    /** Characters received but not yet taken, as a ring buffer */
+    char input_[Sizes::input_buffer_size];
+    /** The index of the oldest character in the input buffer */
+    int inputStart_;
+    /** The number of characters in the input buffer */
+    int inputSize_;
+    /** The command string being put together */
+    char line_[Sizes::string_length];
+    /** The number of characters in the command string being put together */
+    int lineLen_;
+    /** Whether Ctrl-C was received since the last check */
+    bool isAbort_;
 
 };
 
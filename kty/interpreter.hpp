@@ -5,12 +5,17 @@
 #include <kty/containers/deque_of_deque.hpp>
 #include <kty/containers/string.hpp>
 #include <kty/containers/stringpool.hpp>
+#include <kty/fader.hpp>
+#include <kty/image.hpp>
 #include <kty/machine_state.hpp>
 #include <kty/parser.hpp>
+#include <kty/runtime.hpp>
 #include <kty/string_utils.hpp>
+#include <kty/timer_wheel.hpp>
 #include <kty/token.hpp>
 #include <kty/tokenizer.hpp>
 #include <kty/types.hpp>
+#include <kty/vm.hpp>
 
 namespace kty {
 
@@ -25,32 +30,76 @@ enum InterpreterStatus {
 
 /*!
     @brief  Class that stores state on all devices and groups, and executes commands.
+            Waiting commands do not block. The rest of the running command is
+            parked on a timer wheel instead, and continues from update() once
+            its time is up, so other commands can run in the meantime.
+            Groups started with Spawn run as tasks of their own, each with its
+            own queue of commands and scope. Ready tasks take turns one command
+            at a time, so a group which never waits does not hold up the others.
+            Groups started with Every run as tasks which park themselves until
+            the next of a series of fixed deadlines, so their period does not
+            drift by the time the group takes to run.
+            LEDs faded with FadeTo are updated by the interpreter itself on a
+            fixed tick, from update() and in between commands.
+            Constants made with IsConstant are kept by the interpreter rather
+            than the machine state. Their names are replaced by their values
+            as commands are entered, so commands kept in groups hold the
+            values themselves, and expressions made only of constants and
+            numbers are worked out once when compiled.
+            With a command budget set, execute() and update() hand control
+            back after that many commands, and the rest continues from the
+            next update(), so the caller can keep reading input.
 */
-template <typename GetAllocFunc = decltype(get_alloc), typename GetPoolFunc = decltype(get_stringpool), typename PoolString = PoolString<>, typename Token = Token<>>
+template <typename Runtime = Runtime<>, typename PoolString = PoolString<>, typename Token = Token<>>
 class Interpreter {
 
 public:
+    /** The type of symbol that names are held as */
+    typedef typename MachineState<Runtime, PoolString>::symbol_t symbol_t;
+    /** The type of call a group makes to another group */
+    typedef typename MachineState<Runtime, PoolString>::GroupCall GroupCall;
+
+    /** The type of function used to read the current time in milliseconds */
+    typedef unsigned long ClockFunc();
+    /** The type of member function which executes a kind of command */
+    typedef void (Interpreter::*CommandHandler)(Deque<Token> const & command);
+
     /*!
         @brief  Default interpreter constructor.
 
-        @param  getAllocFunc
-                A function that returns a allocator pointer when called.
-
-        @param  getPoolFunc
-                A function that returns a pointer to a string pool when called.
+        @param  runtime
+                The runtime to allocate from.
+                Interpreters with different runtimes are fully independent.
+                If not provided, the globals returned by get_alloc and
+                get_stringpool are used.
     */
-    Interpreter(GetAllocFunc & getAllocFunc = get_alloc, GetPoolFunc & getPoolFunc = get_stringpool)
-            : getAllocFunc_(getAllocFunc), getPoolFunc_(getPoolFunc),
-              commandQueue_(getAllocFunc), commandBuffer_(getAllocFunc),
-              machineState_(getAllocFunc, getPoolFunc),
-              lastGroupName_(getPoolFunc),
-              lastCondition_(getAllocFunc),
-              parser_(getAllocFunc, getPoolFunc), tokenizer_(getAllocFunc, getPoolFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+    explicit Interpreter(Runtime const & runtime = Runtime())
+            : runtime_(runtime),
+              commandQueue_(runtime.alloc()), commandBuffer_(runtime.alloc()),
+              machineState_(runtime),
+              lastGroupName_(runtime.stringpool()),
+              lastCondition_(runtime.alloc()),
+              timers_(runtime), clock_(millis),
+              fader_(runtime),
+              constants_(runtime.alloc()),
+              parser_(runtime), tokenizer_(runtime) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
         status_ = InterpreterStatus::NORMAL;
         currScopeLevel_ = 0;          // Start at scope level 0
         lastCondition_.push_back(-1); // Last condition at scope level 0 = null
         bracketParity_ = 0;
+        numCommandsExecuted_ = 0;
+        firstTask_ = 0;
+        numTasks_ = 0;
+        for (int i = 0; i < Sizes::task_count; ++i) {
+            tasks_[i] = Deque<PoolString>(runtime.alloc());
+        }
+        commandBudget_ = -1;
+        for (int i = 0; i < Sizes::group_cache_size; ++i) {
+            groupCacheCommands_[i] = Deque<PoolString>(runtime.alloc());
+        }
+        clear_group_cache();
+        clear_name_cache();
     }
 
     /*!
@@ -58,15 +107,145 @@ public:
                 Essentially starting the interpreter from the beginning.
     */
     void reset() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
+        abort();
+        machineState_.reset();
+        constants_.clear();
+        clear_group_cache();
+        // Drop the tokens of the last command held by the parser
+        parser_.set_command(Deque<Token>(runtime_.alloc()));
+    }
+
+    /*!
+        @brief  Stops everything that is running or waiting to run,
+                including groups and conditionals being entered,
+                while keeping all numbers, devices and groups.
+                LEDs which are fading stay where they are.
+    */
+    void abort() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         status_ = InterpreterStatus::NORMAL;
         currScopeLevel_ = 0;
-        lastCondition_[currScopeLevel_] = -1;
+        lastCondition_.clear();
+        lastCondition_.push_back(-1);
         bracketParity_ = 0;
         lastGroupName_ = "";
-        machineState_.reset();
         commandQueue_.clear();
         commandBuffer_.clear();
+        timers_.clear();
+        for ( ; numTasks_ > 0; --numTasks_) {
+            tasks_[firstTask_].clear();
+            firstTask_ = (firstTask_ + 1) % Sizes::task_count;
+        }
+        for (int i = 0; i < Sizes::repeat_count; ++i) {
+            repeats_[i].name = symbol_t();
+        }
+        fader_.clear();
+    }
+
+    /*!
+        @brief  Sets the number of commands run by each call to execute()
+                or update() before handing control back.
+                Commands left over continue from the next update().
+                Defaults to no limit.
+
+        @param  commandBudget
+                The number of commands, or -1 for no limit.
+    */
+    void set_command_budget(int commandBudget) {
+        commandBudget_ = commandBudget;
+    }
+
+    /*!
+        @brief  Chooses how the VM dispatches the instructions of expressions.
+                Defaults to computed gotos where the build supports them,
+                see KTY_VM_THREADED.
+
+        @param  isThreaded
+                True to dispatch with computed gotos, false to use a switch.
+    */
+    void set_threaded_dispatch(bool isThreaded) {
+        vm_.set_threaded(isThreaded);
+    }
+
+    /*!
+        @brief  Checks if there are commands ready to run straight away,
+                left over from running out of the command budget or
+                waiting for their turn.
+
+        @return True if update() has commands to run, false otherwise.
+    */
+    bool is_busy() const {
+        return status_ == InterpreterStatus::NORMAL && numTasks_ > 0;
+    }
+
+    /*!
+        @brief  Sets the function used to read the current time.
+                Defaults to millis().
+
+        @param  clock
+                The function returning the current time in milliseconds.
+    */
+    void set_clock(ClockFunc & clock) {
+        clock_ = &clock;
+    }
+
+    /*!
+        @brief  Checks if any commands are parked until a later time or
+                ready to run, or any LEDs are fading.
+
+        @return True if update() has something to do now or later,
+                false otherwise.
+    */
+    bool is_waiting() const {
+        return is_busy() || !timers_.is_empty() || !fader_.is_empty();
+    }
+
+    /*!
+        @brief  Gets the time left until parked commands are due to continue,
+                or fading LEDs are due to be updated.
+
+        @return The number of milliseconds until update() has something to do,
+                0 if it has something already, or -1 if nothing is waiting.
+    */
+    long time_until_next_event() const {
+        if (is_busy()) {
+            return 0;
+        }
+        unsigned long now = clock_();
+        long timeLeft = timers_.time_until_next(now);
+        long fadeTimeLeft = fader_.time_until_next(now);
+        if (timeLeft == -1 || (fadeTimeLeft != -1 && fadeTimeLeft < timeLeft)) {
+            timeLeft = fadeTimeLeft;
+        }
+        return timeLeft;
+    }
+
+    /*!
+        @brief  Continues all parked commands which are due, together with any
+                other tasks which are ready, and updates fading LEDs.
+                Should be called regularly, e.g. on every loop().
+                Parked commands are held back while a group or conditional
+                is being entered, and continue once it is closed.
+    */
+    void update() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        fader_.tick(clock_(), machineState_);
+        if (status_ != InterpreterStatus::NORMAL || !commandQueue_.is_empty()) {
+            return;
+        }
+        switch_task();
+        execute_command_queue();
+    }
+
+    /*!
+        @brief  Gets the number of commands executed since construction.
+                This includes commands run from within groups and conditionals.
+
+        @return The number of commands executed.
+    */
+    long num_commands_executed() const {
+        return numCommandsExecuted_;
     }
 
     /*!
@@ -76,8 +255,8 @@ public:
                 If there is no required prefix, an empty string is returned.
     */
     PoolString get_prompt_prefix() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
-        PoolString prefix(*getPoolFunc_);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
+        PoolString prefix(runtime_.stringpool());
         switch (status_) {
         case NORMAL:
             prefix = "";
@@ -106,7 +285,7 @@ public:
         @return True if the number exists, false otherwise.
     */
     bool number_exists(PoolString const & name) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
         return machineState_.number_exists(name);
     }
 
@@ -119,7 +298,7 @@ public:
         @return True if the device exists, false otherwise.
     */
     bool device_exists(PoolString const & name) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
         return machineState_.device_exists(name);
     }
 
@@ -132,10 +311,38 @@ public:
         @return True if the group exists, false otherwise.
     */
     int group_exists(PoolString const & name) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
         return machineState_.group_exists(name);
     }
 
+    /*!
+        @brief  Checks whether a constant exists.
+
+        @param  name
+                The name of the constant to search for.
+
+        @return True if the constant exists, false otherwise.
+    */
+    bool constant_exists(PoolString const & name) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return find_constant_value(symbol_t::find(runtime_.stringpool(), name.c_str())) != nullptr;
+    }
+
+    /*!
+        @brief  Gets the value of a constant.
+
+        @param  name
+                The constant name.
+
+        @return The value of the constant.
+                Returns 0 if it does not exist.
+    */
+    int get_constant_value(PoolString const & name) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        int const * constant = find_constant_value(symbol_t::find(runtime_.stringpool(), name.c_str()));
+        return constant == nullptr ? 0 : *constant;
+    }
+
     /*!
         @brief  Gets the value of a number.
 
@@ -146,7 +353,7 @@ public:
                 Returns 0 if it does not exist.
     */
     int get_number_value(PoolString const & name) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
         return machineState_.get_number_value(name);        
     }
 
@@ -160,7 +367,7 @@ public:
                 Returns an unknown device if it does not exist.
     */
     DeviceType get_device_type(PoolString const & name) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
         return machineState_.get_device_type(name);        
     }
 
@@ -177,7 +384,7 @@ public:
                 Returns -1 if it does not exist.
     */
     int get_device_info(PoolString const & name, int const & idx) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         return machineState_.get_device_info(name, idx);
     }
 
@@ -191,7 +398,7 @@ public:
                 If the group does not exist, an empty deque is returned.
     */
     Deque<PoolString> get_group_commands(PoolString const & name) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);        
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);        
         return machineState_.get_group_commands(name);        
     }
 
@@ -203,12 +410,86 @@ public:
         @param  command
                 The command to execute.
     */
-    void execute(PoolString command) {
-        remove_str_multiple_whitespace(command);
-        commandQueue_.push_back(command);
+    void execute(PoolString const & command) {
+        // Copy the command into our own runtime, reducing whitespace in place
+        // so that commands kept in groups look the same however they were typed
+        PoolString ownCommand(runtime_.stringpool(), command.c_str());
+        remove_str_multiple_whitespace(ownCommand);
+        inline_constants(ownCommand);
+        // A new command goes ahead of a running task, which waits its turn
+        if (status_ == InterpreterStatus::NORMAL && !commandQueue_.is_empty()) {
+            yield_task();
+        }
+        commandQueue_.push_back(ownCommand);
+        execute_command_queue();
+    }
+
+    /*!
+        @brief  Executes a given command which has already been tokenized,
+                such as by a tokenizer in streaming mode while it was typed,
+                as well as the commands in the command queue afterwards if
+                necessary.
+                The tokens are only used if the command can run straight away,
+                otherwise the command is tokenized again when its turn comes.
+
+        @param  command
+                The command to execute.
+
+        @param  tokens
+                The tokenized command.
+    */
+    void execute(PoolString const & command, Deque<Token> const & tokens) {
+        if (status_ != InterpreterStatus::NORMAL || !commandQueue_.is_empty() ||
+            tokens.size() <= 1) {
+            execute(command);
+            return;
+        }
+        ++numCommandsExecuted_;
+        if (constants_.is_empty()) {
+            execute_command_tokens(parser_.parse(tokens));
+        }
+        else {
+            Deque<Token> ownTokens(tokens);
+            inline_constants(ownTokens);
+            execute_command_tokens(parser_.parse(ownTokens));
+        }
+        if (status_ == InterpreterStatus::NORMAL) {
+            switch_task();
+        }
         execute_command_queue();
     }
 
+    /*!
+        @brief  Loads the constants, numbers, devices and groups of a
+                precompiled image of a script, made by ImageBuilder, in place
+                of entering the commands which declare them.
+                Nothing is tokenized. The commands which followed the
+                declarations in the script are left in the image, to be read
+                and executed one by one afterwards.
+
+        @param  image
+                The image, read from its start. If successful, it is left at
+                the first command to execute.
+
+        @return True if successful, false if it is not an image of this
+                version or it is cut short, in which case nothing is loaded.
+    */
+    bool load_image(ImageReader & image) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (!image.read_header()) {
+            KTY_LOG_WARNING(F("%s: Not an image of version %d\n"), PRINT_FUNC, imageVersion);
+            return false;
+        }
+        // Check the whole image before changing anything
+        ImageReader check(image);
+        if (!read_image_declarations(check, false)) {
+            KTY_LOG_WARNING(F("%s: Image is cut short\n"), PRINT_FUNC);
+            return false;
+        }
+        read_image_declarations(image, true);
+        return true;
+    }
+
     /*!
         @brief  Executes just the given command. 
                 This method takes the current interpreter status into account.
@@ -221,17 +502,26 @@ public:
                 The command to execute.
     */
     void execute_single_command(PoolString const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         // Nothing to execute
         if (command.strlen() == 0) {
             return;
         }
+        ++numCommandsExecuted_;
         // Check for special interpreter-only commands
         if (command == "DecreaseScopeLevel") {
             --currScopeLevel_;
             return;
         }
-        Deque<Token> tokens;
+        if (is_restore_scope(command)) {
+            restore_scope(command.c_str() + 12);
+            return;
+        }
+        if (strncmp(command.c_str(), "RepeatEvery", 11) == 0) {
+            repeat_every(str_to_int(command.substr_ii(11)));
+            return;
+        }
+        Deque<Token> tokens(runtime_.alloc());
         switch (status_) {
         case NORMAL:
             tokens = tokenizer_.tokenize(command);
@@ -252,14 +542,126 @@ public:
 
     /*!
         @brief  Executes all the commands still in the command queue, if any.
+                Other ready tasks get their turn in between commands, round-robin,
+                until every task has finished or is parked, or the command
+                budget runs out.
+                Tasks do not take turns while a group or conditional is being
+                entered, as the commands which follow belong to it.
     */
     void execute_command_queue() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        int budget = commandBudget_;
         while (!commandQueue_.is_empty()) {
             PoolString command(commandQueue_.front());
             commandQueue_.pop_front();
             execute_single_command(command);
+            // A task which just got its scope back runs at least one command,
+            // otherwise it would only ever save and restore its scope
+            if (status_ == InterpreterStatus::NORMAL &&
+                (commandQueue_.is_empty() || !is_restore_scope(command))) {
+                // Out of budget, so the running task waits for the next update()
+                if (budget > 0 && --budget == 0 && (commandQueue_.is_empty() || yield_task())) {
+                    return;
+                }
+                switch_task();
+            }
+        }
+    }
+
+    /*!
+        @brief  Lets the next ready task run, and puts the running task, if it
+                has commands left, at the back of the ready tasks.
+                Parked tasks which are due become ready first.
+    */
+    void switch_task() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (!fader_.is_empty()) {
+            fader_.tick(clock_(), machineState_);
+        }
+        if (!timers_.is_empty()) {
+            resume_due_tasks();
+        }
+        if (numTasks_ == 0) {
+            return;
+        }
+        // Out of memory or task slots, so the running task keeps going instead
+        if (!commandQueue_.is_empty() && !yield_task()) {
+            return;
+        }
+        commandQueue_.swap(tasks_[firstTask_]);
+        // The slot is left empty, so it gives its head node back
+        tasks_[firstTask_].release_head();
+        firstTask_ = (firstTask_ + 1) % Sizes::task_count;
+        --numTasks_;
+    }
+
+    /*!
+        @brief  Puts the running task at the back of the ready tasks,
+                together with its scope.
+
+        @return True if the task was put back, false if there was not
+                enough memory, in which case it keeps running.
+    */
+    bool yield_task() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        save_scope();
+        if (!start_task(commandQueue_)) {
+            return false;
+        }
+        currScopeLevel_ = 0;
+        lastCondition_[0] = -1;
+        return true;
+    }
+
+    /*!
+        @brief  Makes all parked tasks which are due ready to run.
+    */
+    void resume_due_tasks() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        Deque<PoolString> commands(runtime_.alloc());
+        unsigned long now = clock_();
+        while (timers_.pop_due(now, commands)) {
+            // Out of memory, so the task stays parked until the next switch
+            if (!start_task(commands)) {
+                timers_.schedule(now, commands);
+                return;
+            }
+        }
+    }
+
+    /*!
+        @brief  Adds a task to the back of the ready tasks.
+                The commands are moved into the task rather than copied.
+
+        @param  commands
+                The commands of the task, in the order they should run.
+                Left empty if the task was added.
+
+        @return True if the task was added, false if every task slot
+                is taken, in which case the commands are left as they are.
+    */
+    bool start_task(Deque<PoolString> & commands) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (numTasks_ == Sizes::task_count) {
+            KTY_LOG_WARNING(F("%s: Unable to start task of %d commands\n"), PRINT_FUNC, commands.size());
+            return false;
         }
+        tasks_[(firstTask_ + numTasks_) % Sizes::task_count].swap(commands);
+        ++numTasks_;
+        return true;
+    }
+
+    /*!
+        @brief  Checks if a command is the special interpreter-only command
+                which restores a saved scope.
+
+        @param  command
+                The command to check.
+
+        @return True if the command restores a scope, false otherwise.
+    */
+    bool is_restore_scope(PoolString const & command) const {
+        return strncmp(command.c_str(), "RestoreScope", 12) == 0;
     }
 
     /*!
@@ -270,7 +672,7 @@ public:
                 Tokens in command are assumed to be in postfix notation.
     */
     void execute_command_tokens(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (command.back().is_if()) {
             execute_if(command);
         }
@@ -291,23 +693,8 @@ public:
                 if (command.size() == 1) {
                     execute_print_info(command);
                 }
-                // Creation of a device/group
-                else if (command.back().is_create_num() || 
-                         command.back().is_create_led() || 
-                         command.back().is_create_group()) {
-                    execute_create(command);
-                }
-                else if (command.back().is_move_by() ||
-                         command.back().is_move_by_for()) {
-                    execute_move_by(command);
-                }
-                else if (command.back().is_set_to() ||
-                         command.back().is_set_to_for()) {
-                    execute_set_to(command);
-                }
-                // Running group
                 else {
-                    execute_run_group(command);
+                    (this->*name_command_handler(command.back().get_type()))(command);
                 }
             }
             else if (command.front().is_string()) {
@@ -316,6 +703,38 @@ public:
         }
     }
 
+    /*!
+        @brief  Gets the function which executes a command on a name,
+                from the type of the token ending the command.
+
+        @param  type
+                The type of the last token of the command.
+
+        @return The function executing the command.
+                Tokens which do not end a command of their own run the
+                group with the name.
+    */
+    static CommandHandler name_command_handler(TokenType const & type) {
+        static const CommandHandler lookup[] = {
+            &Interpreter::execute_create,    // CREATE_NUM
+            &Interpreter::execute_create,    // CREATE_CONST
+            &Interpreter::execute_create,    // CREATE_LED
+            &Interpreter::execute_create,    // CREATE_GROUP
+            &Interpreter::execute_run_group, // RUN_GROUP
+            &Interpreter::execute_spawn,     // SPAWN
+            &Interpreter::execute_every,     // EVERY
+            &Interpreter::execute_move_by,   // MOVE_BY_FOR
+            &Interpreter::execute_move_by,   // MOVE_BY
+            &Interpreter::execute_set_to,    // SET_TO_FOR
+            &Interpreter::execute_set_to,    // SET_TO
+            &Interpreter::execute_fade_to,   // FADE_TO
+        };
+        if (type < (int)(sizeof(lookup) / sizeof(lookup[0]))) {
+            return lookup[type];
+        }
+        return &Interpreter::execute_run_group;
+    }
+
     /*!
         @brief  Executes the more general print command.
 
@@ -323,12 +742,12 @@ public:
                 The command to execute
     */
     void execute_print(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         Deque<Token> tokens(command);
         tokens.pop_back();
         tokens = evaluate_postfix(tokens);
         for (typename Deque<Token>::Iterator it = tokens.begin(); it != tokens.end(); ++it) {
-            Serial.print(it->get_value().c_str());
+            Serial.print(it->value_c_str());
         }
         Serial.println("");
     }
@@ -340,11 +759,14 @@ public:
                 The command to execute
     */
     void execute_wait(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         Deque<Token> tokens(command);
         tokens.pop_back();
         tokens = evaluate_postfix(tokens);
-        delay(get_token_value(tokens.back()));
+        int durationMs = get_token_value(tokens.back());
+        if (durationMs > 0) {
+            park(durationMs);
+        }
     }
 
     /*!
@@ -354,29 +776,35 @@ public:
                 The command to execute.
     */
     void execute_print_info(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        PoolString name(command.front().get_value());
-        if (number_exists(name)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        symbol_t name(command.front().get_symbol());
+        int const * constant = find_constant_value(name);
+        if (constant != nullptr) {
+            Serial.print(name.c_str());
+            Serial.print(F(": constant storing "));
+            Serial.println(*constant);
+        }
+        else if (machineState_.number_exists(name)) {
             Serial.print(name.c_str());
             Serial.print(F(": number storing "));
-            Serial.println(get_number_value(name));
+            Serial.println(machineState_.get_number_value(name));
         }
-        else if (device_exists(name)) {
-            switch (get_device_type(name)) {
+        else if (machineState_.device_exists(name)) {
+            switch (machineState_.get_device_type(name)) {
             case LED:
                 Serial.print(name.c_str());
                 Serial.print(F(": LED using pin "));
-                Serial.print(get_device_info(name, 1));
+                Serial.print(machineState_.get_device_info(name, 1));
                 Serial.print(F(" at "));
-                Serial.print(get_device_info(name, 2));
+                Serial.print(machineState_.get_device_info(name, 2));
                 Serial.println(F("%"));                
             };
         }
-        else if (group_exists(name)) {
+        else if (machineState_.group_exists(name)) {
             Serial.print(name.c_str());
             Serial.println(F(": group containing the command(s) "));
-            int nameLen = name.strlen();
-            Deque<PoolString> groupCommands = get_group_commands(name);
+            int nameLen = ::strlen(name.c_str());
+            Deque<PoolString> groupCommands = machineState_.get_group_commands(name);
             for (typename Deque<PoolString>::Iterator it = groupCommands.begin(); it != groupCommands.end(); ++it) {
                 // Print out enough spaces to line up vertically with the end of
                 // the name of the group
@@ -400,7 +828,7 @@ public:
                 The command to execute.
     */
     void execute_if(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         Deque<Token> tokenQueue(command);
         // Skip the if token at the end
         tokenQueue.pop_back();
@@ -415,7 +843,7 @@ public:
                 The command to execute.
     */
     void execute_else(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         // No condition to extract for else, immediately create group
         create_else();
     }
@@ -427,19 +855,29 @@ public:
                 The command to execute.
     */
     void execute_create(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         Deque<Token> tokenQueue(command);
         // Skip the create token at the end
         Token createToken = tokenQueue.back();
         tokenQueue.pop_back();
-        PoolString name(tokenQueue.front().get_value());
+        symbol_t name(tokenQueue.front().get_symbol());
         tokenQueue.pop_front();
+        // Commands already entered hold the value of the constant
+        if (find_constant_value(name) != nullptr) {
+            Serial.print(F("Error: "));
+            Serial.print(name.c_str());
+            Serial.println(F(" is a constant"));
+            return;
+        }
 
         Deque<Token> result = evaluate_postfix(tokenQueue);
 
         if (createToken.is_create_num()) {
             create_number(name, result);
         }
+        else if (createToken.is_create_const()) {
+            create_constant(name, result);
+        }
         else if (createToken.is_create_led()) {
             create_led(name, result);
         }
@@ -455,17 +893,15 @@ public:
                 The command to execute.
     */
     void execute_move_by(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         Deque<Token> tokenQueue(command);
         Token moveByToken = tokenQueue.back();
         tokenQueue.pop_back();
-        PoolString name(tokenQueue.front().get_value());
+        symbol_t name(tokenQueue.front().get_symbol());
         tokenQueue.pop_front();
         // Nothing to move
-        if (!number_exists(name) && !device_exists(name)) {
-            Serial.print(F("Error: "));
-            Serial.print(name.c_str());
-            Serial.println(F(" does not exist"));
+        if (!machineState_.number_exists(name) && !machineState_.device_exists(name)) {
+            print_unchangeable(name);
             return;
         }
 
@@ -480,43 +916,32 @@ public:
         displacement = get_token_value(result.back());
 
         // Execute move
-        int value = get_number_value(name);
-        int deviceInfo1 = get_device_info(name, 1);
-        int deviceInfo2 = get_device_info(name, 2);
-        if (number_exists(name)) {
+        int value = machineState_.get_number_value(name);
+        int deviceInfo1 = machineState_.get_device_info(name, 1);
+        int deviceInfo2 = machineState_.get_device_info(name, 2);
+        if (machineState_.number_exists(name)) {
             machineState_.set_number(name, value + displacement);
         }
         else {
-            switch (get_device_type(name)) {
+            switch (machineState_.get_device_type(name)) {
             case LED:
                 int brightness = deviceInfo2 + displacement;
                 if (brightness > 100) {
-                    Log.notice(F("%s: LED brightness over 100%, maximum is 100%\n"), PRINT_FUNC);
+                    KTY_LOG_NOTICE(F("%s: LED brightness over 100%, maximum is 100%\n"), PRINT_FUNC);
                     brightness = 100;
                 }
                 else if (brightness < 0) {
-                    Log.notice(F("%s: LED brightness below 0%, minimum is 0%\n"), PRINT_FUNC);
+                    KTY_LOG_NOTICE(F("%s: LED brightness below 0%, minimum is 0%\n"), PRINT_FUNC);
                     brightness = 0;
                 }
+                fader_.stop(name);
                 analogWrite(deviceInfo1, brightness * 2.55);
                 machineState_.set_device(name, DeviceType::LED, -1, deviceInfo1, brightness);
             };
         }
         // MoveByFor command
         if (moveByToken.is_move_by_for()) {
-            // Additional time delay
-            delay(durationMs);
-            // Then set back to original value
-            if (number_exists(name)) {
-                machineState_.set_number(name, value);
-            }
-            else {
-                switch (get_device_type(name)) {
-                case LED:
-                    analogWrite(deviceInfo1, deviceInfo2 * 2.55);
-                    machineState_.set_device(name, DeviceType::LED, -1, deviceInfo1, deviceInfo2);
-                };
-            }
+            revert_after(name, machineState_.number_exists(name) ? value : deviceInfo2, durationMs);
         }
     }
 
@@ -527,17 +952,15 @@ public:
                 The command to execute.
     */
     void execute_set_to(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         Deque<Token> tokenQueue(command);
         Token setToToken = tokenQueue.back();
         tokenQueue.pop_back();
-        PoolString name(tokenQueue.front().get_value());
+        symbol_t name(tokenQueue.front().get_symbol());
         tokenQueue.pop_front();
         // Nothing to set
-        if (!number_exists(name) && !device_exists(name)) {
-            Serial.print(F("Error: "));
-            Serial.print(name.c_str());
-            Serial.println(F(" does not exist"));
+        if (!machineState_.number_exists(name) && !machineState_.device_exists(name)) {
+            print_unchangeable(name);
             return;
         }
         // Evaluate arguments
@@ -551,43 +974,182 @@ public:
         newValue = get_token_value(result.back());
 
         // Execute set
-        int value = get_number_value(name);
-        int deviceInfo1 = get_device_info(name, 1);
-        int deviceInfo2 = get_device_info(name, 2);
-        if (number_exists(name)) {
+        int value = machineState_.get_number_value(name);
+        int deviceInfo1 = machineState_.get_device_info(name, 1);
+        int deviceInfo2 = machineState_.get_device_info(name, 2);
+        if (machineState_.number_exists(name)) {
             machineState_.set_number(name, newValue);
         }
         else {
-            switch (get_device_type(name)) {
+            switch (machineState_.get_device_type(name)) {
             case LED:
                 int brightness = newValue;
                 if (brightness > 100) {
-                    Log.notice(F("%s: LED brightness over 100%, maximum is 100%\n"), PRINT_FUNC);
+                    KTY_LOG_NOTICE(F("%s: LED brightness over 100%, maximum is 100%\n"), PRINT_FUNC);
                     brightness = 100;
                 }
                 else if (brightness < 0) {
-                    Log.notice(F("%s: LED brightness below 0%, minimum is 0%\n"), PRINT_FUNC);
+                    KTY_LOG_NOTICE(F("%s: LED brightness below 0%, minimum is 0%\n"), PRINT_FUNC);
                     brightness = 0;
                 }
+                fader_.stop(name);
                 analogWrite(deviceInfo1, brightness * 2.55);
                 machineState_.set_device(name, DeviceType::LED, -1, deviceInfo1, brightness);
             };
         }
         // SetToFor command
         if (setToToken.is_set_to_for()) {
-            // Additional time delay
-            delay(durationMs);
-            // Then set back to original value
-            if (number_exists(name)) {
-                machineState_.set_number(name, value);
-            }
-            else {
-                switch (get_device_type(name)) {
-                case LED:
-                    analogWrite(deviceInfo1, deviceInfo2 * 2.55);
-                    machineState_.set_device(name, DeviceType::LED, -1, deviceInfo1, deviceInfo2);
-                };
+            revert_after(name, machineState_.number_exists(name) ? value : deviceInfo2, durationMs);
+        }
+    }
+
+    /*!
+        @brief  Executes the fade to command.
+                The LED fades from its current brightness on its own, while
+                the rest of the running command is held back until the fade
+                is done.
+
+        @param  command
+                The command to execute.
+    */
+    void execute_fade_to(Deque<Token> const & command) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        Deque<Token> tokenQueue(command);
+        tokenQueue.pop_back();
+        symbol_t name(tokenQueue.front().get_symbol());
+        tokenQueue.pop_front();
+        if (machineState_.get_device_type(name) != DeviceType::LED) {
+            Serial.print(F("Error: "));
+            Serial.print(name.c_str());
+            Serial.println(F(" is not an LED"));
+            return;
+        }
+        // Evaluate arguments
+        Deque<Token> result = evaluate_postfix(tokenQueue);
+        FadeCurve curve = get_token_value(result.back()) ? FadeCurve::GAMMA : FadeCurve::LINEAR;
+        result.pop_back();
+        int durationMs = get_token_value(result.back());
+        result.pop_back();
+        int brightness = get_token_value(result.back());
+        if (brightness > 100) {
+            KTY_LOG_NOTICE(F("%s: LED brightness over 100%, maximum is 100%\n"), PRINT_FUNC);
+            brightness = 100;
+        }
+        else if (brightness < 0) {
+            KTY_LOG_NOTICE(F("%s: LED brightness below 0%, minimum is 0%\n"), PRINT_FUNC);
+            brightness = 0;
+        }
+
+        int pinNumber = machineState_.get_device_info(name, 1);
+        if (durationMs <= 0 || !fader_.start(name, machineState_.get_device_info(name, 2), brightness, durationMs, curve, clock_())) {
+            fader_.stop(name);
+            analogWrite(pinNumber, brightness * 2.55);
+            machineState_.set_device(name, DeviceType::LED, -1, pinNumber, brightness);
+            return;
+        }
+        park(durationMs);
+    }
+
+    /*!
+        @brief  Sets a number or device back to its original value once
+                a duration is up, blocking the rest of the running command
+                until then.
+
+        @param  name
+                The name of the number or device.
+
+        @param  value
+                The original value.
+
+        @param  durationMs
+                The number of milliseconds until the value is set back.
+    */
+    void revert_after(symbol_t const & name, int const & value, int const & durationMs) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        PoolString revert(runtime_.stringpool(), name.c_str());
+        revert += " SetTo(";
+        revert += int_to_str(value, runtime_.stringpool());
+        revert += ")";
+        // The revert runs first once the rest of the command continues
+        commandQueue_.push_front(revert);
+        if (durationMs > 0) {
+            park(durationMs);
+        }
+    }
+
+    /*!
+        @brief  Parks the rest of the running command on the timer wheel,
+                to continue from update() after a duration.
+                If the timer wheel is out of memory, blocks for the duration
+                instead.
+
+        @param  durationMs
+                The number of milliseconds until the command continues.
+    */
+    void park(int const & durationMs) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        park_until(clock_() + durationMs);
+    }
+
+    /*!
+        @brief  Parks the rest of the running command on the timer wheel,
+                to continue from update() at a deadline.
+                If the timer wheel is out of memory, blocks until the deadline
+                instead.
+
+        @param  deadline
+                The time at which the command continues, from the clock.
+    */
+    void park_until(unsigned long const & deadline) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        save_scope();
+        if (!timers_.schedule(deadline, commandQueue_)) {
+            long timeLeft = (long)(deadline - clock_());
+            if (timeLeft > 0) {
+                delay(timeLeft);
             }
+            return;
+        }
+        commandQueue_.clear();
+        currScopeLevel_ = 0;
+        lastCondition_[0] = -1;
+    }
+
+    /*!
+        @brief  Saves the scope of the running command in front of the
+                command queue, as a special interpreter-only command holding
+                the last condition of each scope level up to the current one.
+                Nothing is saved at scope level 0 without a last condition.
+    */
+    void save_scope() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (currScopeLevel_ == 0 && lastCondition_[0] == -1) {
+            return;
+        }
+        PoolString restoreScope(runtime_.stringpool(), "RestoreScope");
+        char condition[2] = " "; // To use operator += on restoreScope
+        for (int i = 0; i <= currScopeLevel_; ++i) {
+            condition[0] = lastCondition_[i] == -1 ? '-' : '0' + lastCondition_[i];
+            restoreScope += condition;
+        }
+        commandQueue_.push_front(restoreScope);
+    }
+
+    /*!
+        @brief  Restores a scope saved by save_scope().
+
+        @param  conditions
+                The last condition of each scope level up to the saved one,
+                as '-' for none, '0' for false or '1' for true.
+    */
+    void restore_scope(char const * conditions) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        currScopeLevel_ = strlen(conditions) - 1;
+        while (lastCondition_.size() <= currScopeLevel_ + 1) {
+            lastCondition_.push_back(-1);
+        }
+        for (int i = 0; i <= currScopeLevel_; ++i) {
+            lastCondition_[i] = conditions[i] == '-' ? -1 : conditions[i] - '0';
         }
     }
 
@@ -600,40 +1162,43 @@ public:
                 The command to execute.
     */
     void execute_run_group(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         Deque<Token> tokenQueue(command);
         // Remove RunGroup command from back
         tokenQueue.pop_back();
         // Extract name of group and check if it exists
-        PoolString name(tokenQueue.front().get_value());
-        if (!group_exists(name)) {
-            Log.warning(F("%s: %s does not exist\n"), PRINT_FUNC, name.c_str());
+        symbol_t name(tokenQueue.front().get_symbol());
+        Deque<PoolString> const * groupCommands = cached_group_commands(name);
+        if (groupCommands == nullptr) {
+            KTY_LOG_WARNING(F("%s: %s does not exist\n"), PRINT_FUNC, name.c_str());
             return;
         }
         // Extract number of times to run group
         Deque<Token> result = evaluate_postfix(tokenQueue);
         int numTimes = get_token_value(result.back());
+        if (numTimes == -1 || numTimes > 0) {
+            leave_tail_scopes();
+        }
         // Push command for one more call to run the group
         if (numTimes > 1) {
-            commandQueue_.push_front(PoolString(*getPoolFunc_));
+            commandQueue_.push_front(PoolString(runtime_.stringpool()));
             commandQueue_.front() += name.c_str();
             commandQueue_.front() += "RunGroup(";
-            commandQueue_.front() += int_to_str(numTimes - 1, *getPoolFunc_);
+            commandQueue_.front() += int_to_str(numTimes - 1, runtime_.stringpool());
             commandQueue_.front() += ")";
         }
         // Continuously run the group
         else if (numTimes == -1) {
-            commandQueue_.push_front(PoolString(*getPoolFunc_));
+            commandQueue_.push_front(PoolString(runtime_.stringpool()));
             commandQueue_.front() += name.c_str();
             commandQueue_.front() += "RunGroup(-1)";
         }
         // If running group at least once(or continuously)
-        if (numTimes == -1 || numTimes > 0) {
-            Deque<PoolString> groupCommands = get_group_commands(name);
+        if ((numTimes == -1 || numTimes > 0) && !groupCommands->is_empty()) {
             // Push from the last command to ensure correct order
-            typename Deque<PoolString>::Iterator it = groupCommands.end();
+            typename Deque<PoolString>::ConstIterator it = groupCommands->end();
             --it;
-            for ( ; it != groupCommands.begin(); --it) {
+            for ( ; it != groupCommands->begin(); --it) {
                 commandQueue_.push_front(*it);
             }
             // Additional push for the first command (not handled by loop)
@@ -642,167 +1207,257 @@ public:
     }
 
     /*!
-        @brief  Executes the printing of a string.
-
-        @param  command
-                The print string command to execute.
+        @brief  Leaves the scopes of the if and else blocks which are done
+                once the running command is, before it runs a group.
+                A group run as the last command of nested blocks, such as a
+                group running itself again from inside an If, then does not
+                keep one scope per call, and the DecreaseScopeLevel command
+                of each, so recursion takes the same memory however deep it
+                goes.
+                The scope of the outermost of those blocks is kept, so that
+                the conditions of the scopes around it, which an Else after
+                it looks at, stay as they are.
     */
-    void execute_print_string(Deque<Token> const & command) {
-        Serial.println(command.front().get_value().c_str());
+    void leave_tail_scopes() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        int numScopes = 0;
+        for (typename Deque<PoolString>::Iterator it = commandQueue_.begin();
+             it != commandQueue_.end() && *it == "DecreaseScopeLevel"; ++it) {
+            ++numScopes;
+        }
+        // Only the last of the scopes has to be left by running its command
+        for ( ; numScopes > 1; --numScopes) {
+            commandQueue_.pop_front();
+            --currScopeLevel_;
+        }
     }
 
     /*!
-        @brief  Evaluates a postfix expression.
+        @brief  Gets the commands of a group, ready to be run.
+                Calls the group makes to small groups with a plain
+                `name RunGroup()` are replaced by the commands of those
+                groups, saving a command and a lookup per call.
+                The commands are cached by the name of the group until any
+                group is set again, so runs of the same group only look it
+                up once. A group which drops out of the cache is built again
+                from the calls found when it was set, without tokenizing its
+                commands. Runs which have already started keep the commands
+                they started with.
 
-        @param  tokenQueue
-                The postfix expression to be evaluated.
+        @param  name
+                The name of the group.
 
-        @return The result stack after evaluation is complete.
-                The stack may contain multiple values, depending on the input expression.
+        @return The commands, or nullptr if the group does not exist.
     */
-    Deque<Token> evaluate_postfix(Deque<Token> const & tokenQueue) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        Deque<Token> tokenStack;
-
-        for (typename Deque<Token>::ConstIterator it = tokenQueue.begin(); it != tokenQueue.end(); ++it) {
-            Token const & token = *it;
-            if (token.is_unary_operator()) {
-                Token operand = tokenStack.back();
-                tokenStack.pop_back();
-                Token result = evaluate_unary_operation(token, operand);
-                tokenStack.push_back(result);
-            }
-            else if (token.is_operator()) {
-                Token rhs = tokenStack.back();
-                tokenStack.pop_back();
-                Token lhs = tokenStack.back();
-                tokenStack.pop_back();
-                Token result = evaluate_operation(token, lhs, rhs);
-                tokenStack.push_back(result);
-            }
-            else if (token.is_operand()) {
-                // Instantly evaluate
-                tokenStack.push_back(Token(TokenType::NUM_VAL, int_to_str(get_token_value(token))));
-            }
-            // Everything else just goes directly to the tokenStack
-            else {
-                tokenStack.push_back(token);
+    Deque<PoolString> const * cached_group_commands(symbol_t const & name) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (groupCacheVersion_ != machineState_.groups_version()) {
+            clear_group_cache();
+        }
+        if (name.is_empty()) {
+            return nullptr;
+        }
+        int idx = name.id() % Sizes::group_cache_size;
+        if (groupCacheIds_[idx] != name.id()) {
+            if (!machineState_.group_exists(name)) {
+                return nullptr;
             }
+            groupCacheCommands_[idx] = machineState_.get_inlined_group_commands(name, Sizes::inline_group_size);
+            groupCacheIds_[idx] = name.id();
         }
-        return tokenStack;
+        return &groupCacheCommands_[idx];
     }
 
     /*!
-        @brief  Evaluates single unary operation.
+        @brief  Sets a group, finding the calls its commands make to other
+                groups for inlining once, rather than on every run.
+                Only calls which run a group once with a plain
+                `name RunGroup()` or `name RunGroup(1)` are inlined.
 
-        @param  operation
-                The operation to be applied.
-        
-        @param  operand
-                The operand to be operated on.
-
-        @return The result of performing the operation.
-                If any of the arguments are invalid, 
-                a token containing "0" is returned.
-    */
-    Token evaluate_unary_operation(Token const & operation, Token const & operand) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        int value = get_token_value(operand);
-        Token result(TokenType::NUM_VAL);
-        result.set_value(int_to_str(0));
-        
-        if (operation.is_unary_neg()) {
-            result.set_value(int_to_str(-value));
-        }
-        else if (operation.is_logi_not()) {
-            result.set_value(int_to_str(!value));
-        }
+        @param  name
+                The name of the group.
 
-        return result;
+        @param  commands
+                The commands for the group.
+    */
+    void set_group(symbol_t const & name, Deque<PoolString> const & commands) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        Deque<GroupCall> calls(runtime_.alloc());
+        bool setsGroups = false;
+        int i = 0;
+        for (typename Deque<PoolString>::ConstIterator it = commands.begin(); it != commands.end(); ++it, ++i) {
+            Deque<Token> tokens = tokenizer_.tokenize(*it);
+            for (typename Deque<Token>::Iterator tokenIt = tokens.begin(); tokenIt != tokens.end(); ++tokenIt) {
+                setsGroups = setsGroups || tokenIt->get_type() == TokenType::CREATE_GROUP;
+            }
+            // name RunGroup ( 1 ) CMD_END
+            if (tokens.size() == 6 && tokens[0].is_name() &&
+                tokens[1].get_type() == TokenType::RUN_GROUP &&
+                tokens[3].is_num_val() && str_to_int(tokens[3].value_c_str()) == 1) {
+                GroupCall call = {i, tokens[0].get_symbol()};
+                calls.push_back(call);
+            }
+        }
+        machineState_.set_group(name, commands, calls, setsGroups);
     }
 
     /*!
-        @brief  Evaluates single binary operation.
+        @brief  Empties the cache of group commands.
+    */
+    void clear_group_cache() {
+        for (int i = 0; i < Sizes::group_cache_size; ++i) {
+            groupCacheIds_[i] = symbol_t::NO_ID;
+            groupCacheCommands_[i].clear();
+        }
+        groupCacheVersion_ = machineState_.groups_version();
+    }
 
-        @param  operation
-                The operation to be applied.
-        
-        @param  lhs
-                The left hand side operand.
-        
-        @param  rhs
-                The right hand side operand.
+    /*!
+        @brief  Executes the spawning of a command group.
+                The commands in the command group are started as a task of
+                their own, which takes turns with the running command.
 
-        @return The result of performing the operation.
-                If any of the arguments are invalid, 
-                a token containing "0" is returned.
+        @param  command
+                The command to execute.
     */
-    Token evaluate_operation(Token const & operation, Token const & lhs, Token const & rhs) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        int lhsValue = get_token_value(lhs);
-        int rhsValue = get_token_value(rhs);
-        Token result(TokenType::NUM_VAL);
-        result.set_value(int_to_str(0));
-
-        if (operation.is_equals()) {
-            result.set_value(int_to_str(lhsValue == rhsValue));
-        }
-        else if (operation.is_l_equals()) {
-            result.set_value(int_to_str(lhsValue <= rhsValue));
-        }
-        else if (operation.is_g_equals()) {
-            result.set_value(int_to_str(lhsValue >= rhsValue));
-        }
-        else if (operation.is_less()) {
-            result.set_value(int_to_str(lhsValue < rhsValue));
-        }
-        else if (operation.is_greater()) {
-            result.set_value(int_to_str(lhsValue > rhsValue));
+    void execute_spawn(Deque<Token> const & command) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        symbol_t name(command.front().get_symbol());
+        if (!machineState_.group_exists(name)) {
+            KTY_LOG_WARNING(F("%s: %s does not exist\n"), PRINT_FUNC, name.c_str());
+            return;
         }
-        else if (operation.is_math_add()) {
-            result.set_value(int_to_str(lhsValue + rhsValue));
+        Deque<PoolString> taskCommands = machineState_.get_group_commands(name);
+        start_task(taskCommands);
+    }
+
+    /*!
+        @brief  Executes the running of a command group at a fixed period.
+                The commands in the command group are started as a task of
+                their own, which runs them straight away, and then again
+                every period.
+
+        @param  command
+                The command to execute.
+    */
+    void execute_every(Deque<Token> const & command) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        Deque<Token> tokenQueue(command);
+        // Remove Every command from back
+        tokenQueue.pop_back();
+        symbol_t name(tokenQueue.front().get_symbol());
+        if (!machineState_.group_exists(name)) {
+            KTY_LOG_WARNING(F("%s: %s does not exist\n"), PRINT_FUNC, name.c_str());
+            return;
         }
-        else if (operation.is_math_sub()) {
-            result.set_value(int_to_str(lhsValue - rhsValue));
+        Deque<Token> result = evaluate_postfix(tokenQueue);
+        int periodMs = get_token_value(result.back());
+        if (periodMs <= 0) {
+            KTY_LOG_WARNING(F("%s: period of %d is not above 0\n"), PRINT_FUNC, periodMs);
+            return;
         }
-        else if (operation.is_math_mul()) {
-            result.set_value(int_to_str(lhsValue * rhsValue));
+        int idx = 0;
+        while (idx < Sizes::repeat_count && !repeats_[idx].name.is_empty()) {
+            ++idx;
         }
-        else if (operation.is_math_div()) {
-            result.set_value(int_to_str(lhsValue / rhsValue));
+        if (idx == Sizes::repeat_count) {
+            KTY_LOG_WARNING(F("%s: Unable to repeat %s\n"), PRINT_FUNC, name.c_str());
+            return;
         }
-        else if (operation.is_math_mod()) {
-            result.set_value(int_to_str(lhsValue % rhsValue));
+        Deque<PoolString> taskCommands = machineState_.get_group_commands(name);
+        taskCommands.push_back(repeat_command(idx));
+        if (start_task(taskCommands)) {
+            repeats_[idx] = Repeat{clock_(), periodMs, name};
         }
-        else if (operation.is_math_pow()) {
-            result.set_value(int_to_str(power(lhsValue, rhsValue)));
+    }
+
+    /*!
+        @brief  Parks the task of a group run with Every until its next
+                deadline, with the commands of the group queued up again.
+                Deadlines which have already passed are skipped, rather than
+                run late one after another.
+
+        @param  idx
+                The index of the repeat which is due again.
+    */
+    void repeat_every(int const & idx) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (idx < 0 || idx >= Sizes::repeat_count || repeats_[idx].name.is_empty()) {
+            return;
         }
-        else if (operation.is_logi_and()) {
-            result.set_value(int_to_str(lhsValue && rhsValue));
+        Repeat & repeat = repeats_[idx];
+        // Stop repeating groups which no longer exist, freeing their slot
+        Deque<PoolString> const * groupCommands = cached_group_commands(repeat.name);
+        if (groupCommands == nullptr) {
+            repeat.name = symbol_t();
+            return;
         }
-        else if (operation.is_logi_or()) {
-            result.set_value(int_to_str(lhsValue || rhsValue));
+        unsigned long now = clock_();
+        do {
+            repeat.deadline += repeat.periodMs;
+        } while ((long)(now - repeat.deadline) >= 0);
+        for (typename Deque<PoolString>::ConstIterator it = groupCommands->begin(); it != groupCommands->end(); ++it) {
+            commandQueue_.push_back(*it);
         }
-        return result;
+        commandQueue_.push_back(repeat_command(idx));
+        park_until(repeat.deadline);
     }
 
     /*!
-        @brief  Evaluates a to the power of b.
+        @brief  Creates the special interpreter-only command which repeats
+                a group run with Every once its commands are done.
 
-        @param  a
-                The base.
-        
-        @param  b
-                The exponent.
+        @param  idx
+                The index of the repeat.
+
+        @return The command.
+    */
+    PoolString repeat_command(int const & idx) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        PoolString repeat(runtime_.stringpool(), "RepeatEvery");
+        repeat += int_to_str(idx, runtime_.stringpool());
+        return repeat;
+    }
+
+    /*!
+        @brief  Executes the printing of a string.
+
+        @param  command
+                The print string command to execute.
+    */
+    void execute_print_string(Deque<Token> const & command) {
+        Serial.println(command.front().value_c_str());
+    }
+
+    /*!
+        @brief  Evaluates a postfix expression.
+
+        @param  tokenQueue
+                The postfix expression to be evaluated.
 
-        @return a raised to the power of b.
+        @return The result stack after evaluation is complete.
+                The stack may contain multiple values, depending on the input expression.
     */
-    int power(int const & a, int const & b) {
-        int result = 1;
-        for (int i = 0; i < b; ++i) {
-            result *= a;
+    Deque<Token> evaluate_postfix(Deque<Token> const & tokenQueue) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        Deque<Token> tokenStack(runtime_.alloc());
+        Program<Token> program;
+        if (!program.compile(tokenQueue)) {
+            tokenStack.push_back(Token(TokenType::NUM_VAL, int_to_str(0, runtime_.stringpool())));
+            return tokenStack;
         }
-        return result;
+        typename Vm<Token>::Value stack[Sizes::program_size];
+        int depth = vm_.run(program, *this, stack);
+        // Only the results are turned back into tokens
+        for (int i = 0; i < depth; ++i) {
+            if (stack[i].token != nullptr) {
+                tokenStack.push_back(*stack[i].token);
+            }
+            else {
+                tokenStack.push_back(Token(TokenType::NUM_VAL, int_to_str(stack[i].number, runtime_.stringpool())));
+            }
+        }
+        return tokenStack;
     }
 
     /*!
@@ -817,22 +1472,60 @@ public:
                 Otherwise, 0 is returned.
     */
     int get_token_value(Token const & token) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         if (token.is_num_val()) {
-            return str_to_int(token.get_value());
+            return str_to_int(token.value_c_str());
         }
         else if (token.is_name()) {
-            PoolString name(token.get_value());
-            if (number_exists(name)) {
-                return get_number_value(name);
-            }
-            else if (device_exists(name)) {
-                return get_device_info(name, 2);
+            int const * value = find_name_value(token.get_symbol());
+            if (value != nullptr) {
+                return *value;
             }
         }
         return 0;
     }
 
+    /*!
+        @brief  Gets where the value of a name is kept, which is the value of
+                a number, or the status value of a device.
+                Every name remembers where its value was found, so evaluating
+                it again reads the value straight away instead of searching
+                the numbers and devices, until a number or device is added.
+
+        @param  name
+                The name.
+
+        @return A pointer to the value, or nullptr if the name is neither
+                a number nor a device.
+    */
+    int const * find_name_value(symbol_t const & name) {
+        if (nameCacheVersion_ != machineState_.names_version()) {
+            clear_name_cache();
+        }
+        if (name.is_empty()) {
+            return nullptr;
+        }
+        NameCacheEntry & entry = nameCache_[name.id() % Sizes::name_cache_size];
+        if (entry.id != name.id()) {
+            entry.value = machineState_.find_number_value(name);
+            if (entry.value == nullptr) {
+                entry.value = machineState_.find_device_info_2(name);
+            }
+            entry.id = name.id();
+        }
+        return entry.value;
+    }
+
+    /*!
+        @brief  Empties the cache of where the values of names are kept.
+    */
+    void clear_name_cache() {
+        for (int i = 0; i < Sizes::name_cache_size; ++i) {
+            nameCache_[i].id = symbol_t::NO_ID;
+        }
+        nameCacheVersion_ = machineState_.names_version();
+    }
+
     /*!
         @brief  Creates a number using the name and information given.
 
@@ -843,12 +1536,160 @@ public:
                 The information about the number.
                 The number value is expected to be the top token of the stack.
     */
-    void create_number(PoolString const & name, Deque<Token> & info) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        int value = str_to_int(info.back().get_value());
+    void create_number(symbol_t const & name, Deque<Token> & info) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        int value = str_to_int(info.back().value_c_str());
         machineState_.set_number(name, value);     
     }
 
+    /*!
+        @brief  Creates a constant using the name and information given.
+                Only new names can become constants, as commands which
+                already use the name would go on using what it was before.
+
+        @param  name
+                The name of the constant to be created
+
+        @param  info
+                The information about the constant.
+                The constant value is expected to be the top token of the stack.
+    */
+    void create_constant(symbol_t const & name, Deque<Token> & info) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (machineState_.number_exists(name) || machineState_.device_exists(name) ||
+            machineState_.group_exists(name)) {
+            Serial.print(F("Error: "));
+            Serial.print(name.c_str());
+            Serial.println(F(" already exists"));
+            return;
+        }
+        int value = str_to_int(info.back().value_c_str());
+        if (!constants_.push_back(Constant{name, value})) {
+            KTY_LOG_WARNING(F("%s: Unable to create %s\n"), PRINT_FUNC, name.c_str());
+        }
+    }
+
+    /*!
+        @brief  Gets where the value of a constant is kept.
+
+        @param  name
+                The name of the constant.
+
+        @return A pointer to the value, or nullptr if there is no constant
+                with the name.
+    */
+    int const * find_constant_value(symbol_t const & name) const {
+        if (name.is_empty()) {
+            return nullptr;
+        }
+        for (typename Deque<Constant>::ConstIterator it = constants_.begin(); it != constants_.end(); ++it) {
+            if (it->name == name) {
+                return &it->value;
+            }
+        }
+        return nullptr;
+    }
+
+    /*!
+        @brief  Prints why a command cannot change a name, which is either
+                a constant or does not exist.
+
+        @param  name
+                The name.
+    */
+    void print_unchangeable(symbol_t const & name) const {
+        Serial.print(F("Error: "));
+        Serial.print(name.c_str());
+        if (find_constant_value(name) != nullptr) {
+            Serial.println(F(" is a constant"));
+        }
+        else {
+            Serial.println(F(" does not exist"));
+        }
+    }
+
+    /*!
+        @brief  Replaces the names of constants in a command by their values.
+                The name a command starts with is what the command acts on,
+                so it is left as it is, as are strings and comments.
+                If the command would become too long, it is left unchanged.
+
+        @param  command
+                The command, which is changed in place.
+    */
+    void inline_constants(PoolString & command) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (constants_.is_empty()) {
+            return;
+        }
+        Deque<int> nameEnds(runtime_.alloc());
+        Deque<Token> tokens = tokenizer_.tokenize(command.c_str(), nameEnds);
+        char result[Sizes::string_length + 1];
+        int resultLen = 0;
+        char const * str = command.c_str();
+        int copiedLen = 0;
+        typename Deque<int>::Iterator endIt = nameEnds.begin();
+        for (typename Deque<Token>::Iterator it = tokens.begin(); it != tokens.end(); ++it) {
+            if (!it->is_name() || endIt == nameEnds.end()) {
+                continue;
+            }
+            int end = *endIt;
+            ++endIt;
+            int const * constant = it == tokens.begin() ? nullptr : find_constant_value(it->get_symbol());
+            if (constant == nullptr) {
+                continue;
+            }
+            // Negative values are bracketed so that they stay one operand
+            PoolString value(runtime_.stringpool(), *constant < 0 ? "(" : "");
+            value += int_to_str(*constant, runtime_.stringpool());
+            value += *constant < 0 ? ")" : "";
+            int start = end - ::strlen(it->value_c_str());
+            // Names cut short by the tokenizer are left as they are
+            if (start < copiedLen || ::strncmp(str + start, it->value_c_str(), end - start) != 0) {
+                continue;
+            }
+            if (resultLen + (start - copiedLen) + value.strlen() > Sizes::string_length) {
+                KTY_LOG_WARNING(F("%s: Command is too long to replace constants\n"), PRINT_FUNC);
+                return;
+            }
+            memcpy(result + resultLen, str + copiedLen, start - copiedLen);
+            resultLen += start - copiedLen;
+            memcpy(result + resultLen, value.c_str(), value.strlen());
+            resultLen += value.strlen();
+            copiedLen = end;
+        }
+        if (copiedLen == 0) {
+            return;
+        }
+        int restLen = ::strlen(str + copiedLen);
+        if (resultLen + restLen > Sizes::string_length) {
+            KTY_LOG_WARNING(F("%s: Command is too long to replace constants\n"), PRINT_FUNC);
+            return;
+        }
+        memcpy(result + resultLen, str + copiedLen, restLen + 1);
+        command = result;
+    }
+
+    /*!
+        @brief  Replaces the names of constants in a tokenized command by
+                their values.
+                The name a command starts with is what the command acts on,
+                so it is left as it is.
+
+        @param  tokens
+                The tokenized command, which is changed in place.
+    */
+    void inline_constants(Deque<Token> & tokens) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        typename Deque<Token>::Iterator it = tokens.begin();
+        for (++it; it != tokens.end(); ++it) {
+            int const * constant = it->is_name() ? find_constant_value(it->get_symbol()) : nullptr;
+            if (constant != nullptr) {
+                *it = Token(TokenType::NUM_VAL, int_to_str(*constant, runtime_.stringpool()));
+            }
+        }
+    }
+
     /*!
         @brief  Creates an LED using the name and information given.
 
@@ -860,16 +1701,115 @@ public:
                 The LED brightness value is expected to be the top token of the stack,
                 and the LED pin number is expected to be the second token from the top.
     */
-    void create_led(PoolString const & name, Deque<Token> & info) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        int brightness = str_to_int(info.back().get_value());
+    void create_led(symbol_t const & name, Deque<Token> & info) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        int brightness = str_to_int(info.back().value_c_str());
         info.pop_back();
-        int pinNumber = str_to_int(info.back().get_value());
+        int pinNumber = str_to_int(info.back().value_c_str());
+        set_led(name, pinNumber, brightness);
+    }
+
+    /*!
+        @brief  Sets up the pin of an LED, and sets the LED.
+
+        @param  name
+                The name of the LED.
+
+        @param  pinNumber
+                The pin the LED uses.
+
+        @param  brightness
+                The brightness of the LED, in percent.
+    */
+    void set_led(symbol_t const & name, int const & pinNumber, int const & brightness) {
         pinMode(pinNumber, OUTPUT);
         analogWrite(pinNumber, (int)(brightness * 2.55));
         machineState_.set_device(name, DeviceType::LED, -1, pinNumber, brightness);
     }
 
+    /*!
+        @brief  Reads the constants, numbers, devices and groups of an image.
+
+        @param  image
+                The image, just past its start.
+
+        @param  isLoaded
+                True to load what is read, false to only check the image.
+
+        @return True if the image holds everything it should,
+                false otherwise.
+    */
+    bool read_image_declarations(ImageReader & image, bool const & isLoaded) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        char buffer[Sizes::string_length + 1];
+        Deque<symbol_t> symbols(runtime_.alloc());
+        unsigned int numSymbols = image.read_u16();
+        for (unsigned int i = 0; i < numSymbols; ++i) {
+            image.read_str(buffer, sizeof(buffer));
+            if (isLoaded) {
+                symbols.push_back(symbol_t(runtime_.stringpool(), buffer));
+            }
+        }
+        unsigned int numConstants = image.read_u16();
+        for (unsigned int i = 0; i < numConstants; ++i) {
+            unsigned int name = image.read_u16();
+            int value = image.read_i32();
+            if (name >= numSymbols) {
+                return false;
+            }
+            if (isLoaded) {
+                constants_.push_back(Constant{symbols[name], value});
+            }
+        }
+        unsigned int numNumbers = image.read_u16();
+        for (unsigned int i = 0; i < numNumbers; ++i) {
+            unsigned int name = image.read_u16();
+            int value = image.read_i32();
+            if (name >= numSymbols) {
+                return false;
+            }
+            if (isLoaded) {
+                machineState_.set_number(symbols[name], value);
+            }
+        }
+        unsigned int numDevices = image.read_u16();
+        for (unsigned int i = 0; i < numDevices; ++i) {
+            unsigned int name = image.read_u16();
+            DeviceType type = (DeviceType)image.read_u8();
+            int info0 = image.read_i32();
+            int info1 = image.read_i32();
+            int info2 = image.read_i32();
+            if (name >= numSymbols) {
+                return false;
+            }
+            if (isLoaded && type == DeviceType::LED) {
+                set_led(symbols[name], info1, info2);
+            }
+            else if (isLoaded) {
+                machineState_.set_device(symbols[name], type, info0, info1, info2);
+            }
+        }
+        unsigned int numGroups = image.read_u16();
+        for (unsigned int i = 0; i < numGroups; ++i) {
+            unsigned int name = image.read_u16();
+            unsigned int numCommands = image.read_u16();
+            Deque<PoolString> commands(runtime_.alloc());
+            for (unsigned int j = 0; j < numCommands; ++j) {
+                image.read_str(buffer, sizeof(buffer));
+                if (isLoaded) {
+                    commands.push_back(PoolString(runtime_.stringpool(), buffer));
+                }
+            }
+            if (name >= numSymbols) {
+                return false;
+            }
+            if (isLoaded) {
+                set_group(symbols[name], commands);
+            }
+        }
+        return image.is_ok();
+    }
+
     /*!
         @brief  Begins the creation of an if command group.
 
@@ -877,7 +1817,7 @@ public:
                 The result of evaluating the condition.
     */
     void create_if(int const & condition) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         enter_scope(InterpreterStatus::CREATING_IF);
         // Expand lastCondition_ if necessary
         while (lastCondition_.size() <= currScopeLevel_ + 1) {
@@ -894,7 +1834,7 @@ public:
                 The command to add to the if command group.
     */
     void add_to_if(PoolString const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         Deque<Token> tokens = tokenizer_.tokenize(command);
         // Group is closed
         if (bracketParity_ == 0 && tokens.size() == 2 && tokens.front().is_cl_paren()) {
@@ -919,12 +1859,12 @@ public:
                 and adds its commands to the commandQueue if the condition is true.
     */
     void close_if() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         int condition = lastCondition_[currScopeLevel_ - 1];
         if (condition) {
             // Special interpreter-only command to ensure we decrease scope level
             // after all the instructions in the if block are done
-            commandQueue_.push_front(PoolString("DecreaseScopeLevel", *getPoolFunc_));
+            commandQueue_.push_front(PoolString(runtime_.stringpool(), "DecreaseScopeLevel"));
             // Add commands to commandQueue in reverse order,
             // since pushing from the front
             while (!commandBuffer_.is_empty()) {
@@ -942,7 +1882,7 @@ public:
         @brief  Begins the creation of an else command group.
     */
     void create_else() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         enter_scope(InterpreterStatus::CREATING_ELSE);
         // Expand lastCondition_ if necessary
         while (lastCondition_.size() <= currScopeLevel_ + 1) {
@@ -958,7 +1898,7 @@ public:
                 The command to add to the else command group.
     */
     void add_to_else(PoolString const & command) {
-        Log.verbose(F("%s\n"),  PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"),  PRINT_FUNC);
         Deque<Token> tokens = tokenizer_.tokenize(command);
         // Group is closed
         if (bracketParity_ == 0 && tokens.size() == 2 && tokens.front().is_cl_paren()) {
@@ -984,7 +1924,7 @@ public:
                 directly follows an if that had a condition which was false.
     */
     void close_else() {
-        Log.verbose(F("%s\n"),  PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"),  PRINT_FUNC);
         int condition = lastCondition_[currScopeLevel_ - 1];
         // No else should be run after this
         lastCondition_[currScopeLevel_ - 1] = -1;
@@ -992,7 +1932,7 @@ public:
         if (condition == 0) {
             // Special interpreter-only command to ensure we decrease scope level
             // after all the instructions in the if block are done
-            commandQueue_.push_front(PoolString("DecreaseScopeLevel", *getPoolFunc_));
+            commandQueue_.push_front(PoolString(runtime_.stringpool(), "DecreaseScopeLevel"));
             // Add commands to commandQueue in reverse order,
             // since pushing from the front
             while (!commandBuffer_.is_empty()) {
@@ -1012,10 +1952,10 @@ public:
         @param  name
                 The name of the command group to be created.
     */
-    void create_group(PoolString const & name) {
-        Log.verbose(F("%s\n"),  PRINT_FUNC);
+    void create_group(symbol_t const & name) {
+        KTY_LOG_VERBOSE(F("%s\n"),  PRINT_FUNC);
         enter_scope(InterpreterStatus::CREATING_GROUP);
-        lastGroupName_ = name;
+        lastGroupName_ = name.c_str();
     }
 
     /*!
@@ -1025,7 +1965,7 @@ public:
                 The command to add to the command group.
     */
     void add_to_group(PoolString const & command) {
-        Log.verbose(F("%s\n"),  PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"),  PRINT_FUNC);
         Deque<Token> tokens = tokenizer_.tokenize(command);
         if (bracketParity_ == 0 && tokens.size() == 2 && tokens.front().is_cl_paren()) {
             close_group();
@@ -1048,8 +1988,8 @@ public:
         @brief  Finishes the creation of a command group.
     */
     void close_group() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        machineState_.set_group(lastGroupName_, commandBuffer_);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        set_group(symbol_t(runtime_.stringpool(), lastGroupName_.c_str()), commandBuffer_);
         lastGroupName_ = "";
         exit_scope();
     }
@@ -1073,14 +2013,13 @@ public:
     }
 
 private:
-    GetAllocFunc * getAllocFunc_;
-    GetPoolFunc * getPoolFunc_;
+    Runtime runtime_;
 
     Deque<PoolString> commandQueue_;
     Deque<PoolString> commandBuffer_;
 
-    MachineState<> machineState_;
-    PoolString     lastGroupName_;
+    MachineState<Runtime, PoolString> machineState_;
+    PoolString                        lastGroupName_;
 
     InterpreterStatus status_;
 
@@ -1090,8 +2029,80 @@ private:
 
     int bracketParity_;
 
-    Parser<>    parser_;
-    Tokenizer<> tokenizer_;
+    long numCommandsExecuted_;
+
+    /** Commands parked until a later time */
+    TimerWheel<Runtime, PoolString> timers_;
+    ClockFunc *                     clock_;
+
+    /** Commands of the tasks waiting for their turn, in a ring from firstTask_ */
+    Deque<PoolString> tasks_[Sizes::task_count];
+    /** The slot of the task whose turn is next */
+    int firstTask_;
+    /** The number of tasks waiting for their turn */
+    int numTasks_;
+
+    /*!
+        @brief  A group run with Every.
+    */
+    struct Repeat {
+        /** The time at which the group last became due, from the clock */
+        unsigned long deadline;
+        /** The number of milliseconds between runs */
+        int periodMs;
+        /** The name of the group, or an empty symbol if the slot is free */
+        symbol_t name;
+    };
+
+    /** Commands run per call to execute() or update(), or -1 for no limit */
+    int commandBudget_;
+
+    /** Groups run with Every, referred to by their slot */
+    Repeat repeats_[Sizes::repeat_count];
+
+    /** LEDs being faded */
+    Fader<Runtime, PoolString> fader_;
+
+    /*!
+        @brief  A number which never changes.
+    */
+    struct Constant {
+        /** The name of the constant */
+        symbol_t name;
+        /** The value */
+        int value;
+    };
+
+    /** Constants, whose names are replaced by their values as commands are entered */
+    Deque<Constant> constants_;
+
+    /** Runs the compiled expressions of commands */
+    Vm<Token> vm_;
+
+    /** Ids of the groups whose commands are cached, or NO_ID for none */
+    unsigned short    groupCacheIds_[Sizes::group_cache_size];
+    /** The cached commands of groups, with small groups they run inlined */
+    Deque<PoolString> groupCacheCommands_[Sizes::group_cache_size];
+    /** The version of the groups that the cache was filled from */
+    unsigned int      groupCacheVersion_;
+
+    /*!
+        @brief  Where the value of a name was found.
+    */
+    struct NameCacheEntry {
+        /** The id of the name, or NO_ID for none */
+        unsigned short id;
+        /** The value, or nullptr if the name has no value */
+        int const * value;
+    };
+
+    /** Where the values of names were found, by the id of the name */
+    NameCacheEntry nameCache_[Sizes::name_cache_size];
+    /** The version of the names that the cache was filled from */
+    unsigned int   nameCacheVersion_;
+
+    Parser<Runtime, Token, PoolString>    parser_;
+    Tokenizer<Runtime, Token, PoolString> tokenizer_;
 
 };
 
@@ -5,6 +5,8 @@
 #include <kty/containers/deque_of_deque.hpp>
 #include <kty/containers/string.hpp>
 #include <kty/containers/stringpool.hpp>
+#include <kty/runtime.hpp>
+#include <kty/symbol.hpp>
 #include <kty/types.hpp>
 
 namespace kty {
@@ -19,33 +21,54 @@ enum DeviceType {
     @brief  Class that contains information about the current machine state.
             Information stored includes device names and information,
             and group names and information.
+            Names are held as symbols, so looking one up compares ids instead
+            of strings. Lookups by string only work out the symbol once.
 */
-template <typename GetAllocFunc = decltype(get_alloc), typename GetPoolFunc = decltype(get_stringpool), typename PoolString = PoolString<>>
+template <typename Runtime = Runtime<>, typename PoolString = PoolString<>>
 class MachineState {
 
 public:
+    /** The type of symbol that names are held as */
+    typedef Symbol<typename Runtime::stringpool_t> symbol_t;
+
     /*!
-        @brief  MachineState constructor.
+        @brief  A command of a group which runs another group once with a
+                plain `name RunGroup()`, found when the group is set.
+    */
+    struct GroupCall {
+        /** The index of the command within the group */
+        int      command;
+        /** The name of the group it runs */
+        symbol_t callee;
+    };
 
-        @param  getAllocFunc
-                A function that returns a allocator pointer when called.
+    /*!
+        @brief  MachineState constructor.
 
-        @param  getPoolFunc
-                A function that returns a pointer to a string pool when called.
+        @param  runtime
+                The runtime to allocate from.
+                If not provided, the globals returned by get_alloc and
+                get_stringpool are used.
     */
-    MachineState(GetAllocFunc & getAllocFunc = get_alloc, GetPoolFunc & getPoolFunc = get_stringpool)
-        : getAllocFunc_(&getAllocFunc), getPoolFunc_(&getPoolFunc),
-          deviceNames_(getAllocFunc), deviceTypes_(getAllocFunc), 
-          deviceInfo_0_(getAllocFunc), deviceInfo_1_(getAllocFunc), deviceInfo_2_(getAllocFunc),
-          groupNames_(getAllocFunc), groupCommands_(getAllocFunc, getPoolFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+    explicit MachineState(Runtime const & runtime = Runtime())
+        : runtime_(runtime),
+          numberNames_(runtime.alloc()), numberValues_(runtime.alloc()),
+          deviceNames_(runtime.alloc()), deviceTypes_(runtime.alloc()), 
+          deviceInfo_0_(runtime.alloc()), deviceInfo_1_(runtime.alloc()), deviceInfo_2_(runtime.alloc()),
+          groupNames_(runtime.alloc()), groupCommands_(runtime.alloc(), runtime.stringpool()),
+          groupSetsGroups_(runtime.alloc()), callerNames_(runtime.alloc()), groupCalls_(runtime.alloc()) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        namesVersion_ = 0;
+        groupsVersion_ = 0;
     }
 
     /*!
         @brief  Resets the state, clearing all memory.
     */
     void reset() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        numberNames_.clear();
+        numberValues_.clear();
         deviceNames_.clear();
         deviceTypes_.clear();
         deviceInfo_0_.clear();
@@ -53,6 +76,11 @@ public:
         deviceInfo_2_.clear();
         groupNames_.clear();
         groupCommands_.clear();
+        groupSetsGroups_.clear();
+        callerNames_.clear();
+        groupCalls_.clear();
+        ++namesVersion_;
+        ++groupsVersion_;
     }
 
     /*!
@@ -63,9 +91,9 @@ public:
         
         @return True if the number exists, false otherwise.
     */
-    bool number_exists(PoolString const & name) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        for (typename Deque<PoolString>::ConstIterator it = numberNames_.cbegin(); it != numberNames_.cend(); ++it) {
+    bool number_exists(symbol_t const & name) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        for (typename Deque<symbol_t>::ConstIterator it = numberNames_.cbegin(); it != numberNames_.cend(); ++it) {
             if (*it == name) {
                  return true;
             }
@@ -73,6 +101,18 @@ public:
         return false;
     }
 
+    /*!
+        @brief  Checks if a number with the given name exists.
+
+        @param  name
+                The name of the number.
+
+        @return True if the number exists, false otherwise.
+    */
+    bool number_exists(PoolString const & name) const {
+        return number_exists(find_symbol(name));
+    }
+
     /*!
         @brief  Gets the value of a number.
 
@@ -82,9 +122,9 @@ public:
         @return The number value, if it exists.
                 Otherwise 0 is returned.
     */
-    int get_number_value(PoolString const & name) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        typename Deque<PoolString>::ConstIterator nameIter = numberNames_.cbegin();
+    int get_number_value(symbol_t const & name) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        typename Deque<symbol_t>::ConstIterator nameIter = numberNames_.cbegin();
         typename Deque<int>::ConstIterator valueIter = numberValues_.cbegin();
         for ( ; nameIter != numberNames_.cend() && valueIter != numberValues_.cend(); ++nameIter, ++valueIter) {
             if (*nameIter == name) {
@@ -94,6 +134,42 @@ public:
         return 0;
     }
 
+    /*!
+        @brief  Gets the value of a number.
+
+        @param  name
+                The name of the number.
+
+        @return The number value, if it exists.
+                Otherwise 0 is returned.
+    */
+    int get_number_value(PoolString const & name) const {
+        return get_number_value(find_symbol(name));
+    }
+
+    /*!
+        @brief  Gets where the value of a number is kept.
+                The value stays where it is when it is set again, and when
+                other names are added, until names_version() changes.
+
+        @param  name
+                The name of the number.
+
+        @return A pointer to the number value, if it exists.
+                Otherwise nullptr is returned.
+    */
+    int const * find_number_value(symbol_t const & name) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        typename Deque<symbol_t>::ConstIterator nameIter = numberNames_.cbegin();
+        typename Deque<int>::ConstIterator valueIter = numberValues_.cbegin();
+        for ( ; nameIter != numberNames_.cend() && valueIter != numberValues_.cend(); ++nameIter, ++valueIter) {
+            if (*nameIter == name) {
+                return &*valueIter;
+            }
+        }
+        return nullptr;
+    }
+
     /*!
         @brief  Sets the number.
 
@@ -105,9 +181,13 @@ public:
 
         @return True if the set was successful, false otherwise.
     */
-    bool set_number(PoolString const & name, int const & value) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        typename Deque<PoolString>::Iterator nameIter = numberNames_.begin();
+    bool set_number(symbol_t const & name, int const & value) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        // Out of strings to name it with
+        if (name.is_empty()) {
+            return false;
+        }
+        typename Deque<symbol_t>::Iterator nameIter = numberNames_.begin();
         typename Deque<int>::Iterator valueIter = numberValues_.begin();
         for ( ; nameIter != numberNames_.end() && valueIter != numberValues_.end(); ++nameIter, ++valueIter) {
             if (*nameIter == name) {
@@ -115,12 +195,28 @@ public:
                 return true;
             }
         }
+        ++namesVersion_;
         bool result = true;
         result = numberNames_.push_front(name) && result;
         result = numberValues_.push_front(value) && result;
         return result;
     }
 
+    /*!
+        @brief  Sets the number.
+
+        @param  name
+                The name of the number.
+
+        @param  value
+                The value of the number.
+
+        @return True if the set was successful, false otherwise.
+    */
+    bool set_number(PoolString const & name, int const & value) {
+        return set_number(symbol_t(runtime_.stringpool(), name.c_str()), value);
+    }
+
     /*!
         @brief  Checks if a device with the given name exists.
         
@@ -129,9 +225,9 @@ public:
         
         @return True if the device exists, false otherwise.
     */
-    bool device_exists(PoolString const & name) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        for (typename Deque<PoolString>::ConstIterator it = deviceNames_.cbegin(); it != deviceNames_.cend(); ++it) {
+    bool device_exists(symbol_t const & name) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        for (typename Deque<symbol_t>::ConstIterator it = deviceNames_.cbegin(); it != deviceNames_.cend(); ++it) {
             if (*it == name) {
                  return true;
             }
@@ -139,6 +235,18 @@ public:
         return false;
     }
 
+    /*!
+        @brief  Checks if a device with the given name exists.
+
+        @param  name
+                The name of the device.
+
+        @return True if the device exists, false otherwise.
+    */
+    bool device_exists(PoolString const & name) const {
+        return device_exists(find_symbol(name));
+    }
+
     /*!
         @brief  Gets the type of a device.
 
@@ -148,9 +256,9 @@ public:
         @return The device type, if it exists.
                 Otherwise the unknown device type is returned.
     */
-    DeviceType get_device_type(PoolString const & name) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        typename Deque<PoolString>::ConstIterator nameIter = deviceNames_.cbegin();
+    DeviceType get_device_type(symbol_t const & name) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        typename Deque<symbol_t>::ConstIterator nameIter = deviceNames_.cbegin();
         typename Deque<DeviceType>::ConstIterator typeIter = deviceTypes_.cbegin();
         for ( ; nameIter != deviceNames_.cend() && typeIter != deviceTypes_.cend(); ++nameIter, ++typeIter) {
             if (*nameIter == name) {
@@ -160,6 +268,19 @@ public:
         return DeviceType::UNKNOWN_DEVICE;
     }
 
+    /*!
+        @brief  Gets the type of a device.
+
+        @param  name
+                The name of the device.
+
+        @return The device type, if it exists.
+                Otherwise the unknown device type is returned.
+    */
+    DeviceType get_device_type(PoolString const & name) const {
+        return get_device_type(find_symbol(name));
+    }
+
     /*!
         @brief  Gets the info of a device.
 
@@ -172,9 +293,9 @@ public:
         @return The device info, if it exists.
                 Otherwise -1 is returned.
     */
-    int get_device_info(PoolString const & name, int const & idx) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        typename Deque<PoolString>::ConstIterator nameIter = deviceNames_.cbegin();
+    int get_device_info(symbol_t const & name, int const & idx) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        typename Deque<symbol_t>::ConstIterator nameIter = deviceNames_.cbegin();
         typename Deque<int>::ConstIterator info0Iter = deviceInfo_0_.cbegin();
         typename Deque<int>::ConstIterator info1Iter = deviceInfo_1_.cbegin();
         typename Deque<int>::ConstIterator info2Iter = deviceInfo_2_.cbegin();
@@ -197,6 +318,46 @@ public:
         return -1;
     }
 
+    /*!
+        @brief  Gets the info of a device.
+
+        @param  name
+                The name of the device.
+
+        @param  idx
+                The information index.
+
+        @return The device info, if it exists.
+                Otherwise -1 is returned.
+    */
+    int get_device_info(PoolString const & name, int const & idx) const {
+        return get_device_info(find_symbol(name), idx);
+    }
+
+    /*!
+        @brief  Gets where the info 2 of a device, such as the brightness of
+                an LED, is kept.
+                The info stays where it is when the device is set again, and
+                when other names are added, until names_version() changes.
+
+        @param  name
+                The name of the device.
+
+        @return A pointer to the device info, if the device exists.
+                Otherwise nullptr is returned.
+    */
+    int const * find_device_info_2(symbol_t const & name) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        typename Deque<symbol_t>::ConstIterator nameIter = deviceNames_.cbegin();
+        typename Deque<int>::ConstIterator info2Iter = deviceInfo_2_.cbegin();
+        for ( ; nameIter != deviceNames_.cend() && info2Iter != deviceInfo_2_.cend(); ++nameIter, ++info2Iter) {
+            if (*nameIter == name) {
+                return &*info2Iter;
+            }
+        }
+        return nullptr;
+    }
+
     /*!
         @brief  Sets the device.
 
@@ -217,9 +378,13 @@ public:
         
         @return True if the set was successful, false otherwise.
     */
-    bool set_device(PoolString const & name, DeviceType type, int const & info0, int const & info1, int const & info2) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        typename Deque<PoolString>::Iterator nameIter = deviceNames_.begin();
+    bool set_device(symbol_t const & name, DeviceType type, int const & info0, int const & info1, int const & info2) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        // Out of strings to name it with
+        if (name.is_empty()) {
+            return false;
+        }
+        typename Deque<symbol_t>::Iterator nameIter = deviceNames_.begin();
         typename Deque<DeviceType>::Iterator typeIter = deviceTypes_.begin();
         typename Deque<int>::Iterator info0Iter = deviceInfo_0_.begin();
         typename Deque<int>::Iterator info1Iter = deviceInfo_1_.begin();
@@ -237,6 +402,7 @@ public:
                 return true;
             }
         }
+        ++namesVersion_;
         bool result = true;
         result = deviceNames_.push_front(name) && result;
         result = deviceTypes_.push_front(type) && result;
@@ -246,6 +412,30 @@ public:
         return result;
     }
 
+    /*!
+        @brief  Sets the device.
+
+        @param  name
+                The name of the device.
+
+        @param  type
+                The type of the device.
+
+        @param  info0
+                The info 0 of the device.
+
+        @param  info1
+                The info 1 of the device.
+
+        @param  info2
+                The info 2 of the device.
+
+        @return True if the set was successful, false otherwise.
+    */
+    bool set_device(PoolString const & name, DeviceType type, int const & info0, int const & info1, int const & info2) {
+        return set_device(symbol_t(runtime_.stringpool(), name.c_str()), type, info0, info1, info2);
+    }
+
     /*!
         @brief  Checks if a group with the given name exists.
         
@@ -254,9 +444,9 @@ public:
         
         @return True if the group exists, false otherwise.
     */
-    bool group_exists(PoolString const & name) const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        for (typename Deque<PoolString>::ConstIterator it = groupNames_.cbegin(); it != groupNames_.cend(); ++it) {
+    bool group_exists(symbol_t const & name) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        for (typename Deque<symbol_t>::ConstIterator it = groupNames_.cbegin(); it != groupNames_.cend(); ++it) {
             if (*it == name) {
                  return true;
             }
@@ -264,6 +454,18 @@ public:
         return false;
     }
 
+    /*!
+        @brief  Checks if a group with the given name exists.
+
+        @param  name
+                The name of the group.
+
+        @return True if the group exists, false otherwise.
+    */
+    bool group_exists(PoolString const & name) const {
+        return group_exists(find_symbol(name));
+    }
+
     /*!
         @brief  Gets the commands within a group.
 
@@ -273,14 +475,83 @@ public:
         @return The commands within the group.
                 If the group does not exist, an empty deque is returned.
     */
-    Deque<PoolString> get_group_commands(PoolString const & name) const {
-        Deque<PoolString> commands;
+    Deque<PoolString> get_group_commands(symbol_t const & name) const {
+        Deque<PoolString> commands(runtime_.alloc());
         int i = 0;
-        for (typename Deque<PoolString>::ConstIterator it = groupNames_.cbegin(); it != groupNames_.cend(); ++it, ++i) {
+        for (typename Deque<symbol_t>::ConstIterator it = groupNames_.cbegin(); it != groupNames_.cend(); ++it, ++i) {
             if (*it == name) {
                 for (int j = 0; j < groupCommands_.size(i); ++j) {
-                    commands.push_back(groupCommands_.get_str(i, j));
+                    commands.push_back(PoolString(runtime_.stringpool(), groupCommands_.get_str_idx(i, j)));
                 }
+                break;
+            }
+        }
+        return commands;
+    }
+
+    /*!
+        @brief  Gets the commands within a group.
+
+        @param  name
+                The name of the group.
+
+        @return The commands within the group.
+                If the group does not exist, an empty deque is returned.
+    */
+    Deque<PoolString> get_group_commands(PoolString const & name) const {
+        return get_group_commands(find_symbol(name));
+    }
+
+    /*!
+        @brief  Gets the commands within a group, with its calls to small
+                groups replaced by the commands of those groups.
+                Only the calls found when the group was set are replaced,
+                and only by groups of up to maxInlined commands.
+                A group is never inlined into itself, and only one level of
+                calls is inlined, so recursion is left to run as before.
+                Nothing is inlined into or out of groups which set groups
+                themselves, as the inlined commands could go out of date
+                while they run.
+
+        @param  name
+                The name of the group.
+
+        @param  maxInlined
+                The largest group, in commands, to inline.
+
+        @return The commands within the group.
+                If the group does not exist, an empty deque is returned.
+    */
+    Deque<PoolString> get_inlined_group_commands(symbol_t const & name, int maxInlined) const {
+        Deque<PoolString> commands(runtime_.alloc());
+        int i = group_idx(name);
+        if (i < 0) {
+            return commands;
+        }
+        // The calls of a group are kept together, in the order of its commands
+        typename Deque<symbol_t>::ConstIterator callerIt = callerNames_.cbegin();
+        typename Deque<GroupCall>::ConstIterator callIt = groupCalls_.cbegin();
+        while (callerIt != callerNames_.cend() && *callerIt != name) {
+            ++callerIt;
+            ++callIt;
+        }
+        bool canInline = maxInlined > 0 && !groupSetsGroups_[i];
+        for (int j = 0; j < groupCommands_.size(i); ++j) {
+            int calleeIdx = -1;
+            if (callerIt != callerNames_.cend() && *callerIt == name && callIt->command == j) {
+                if (canInline && callIt->callee != name) {
+                    calleeIdx = group_idx(callIt->callee);
+                }
+                ++callerIt;
+                ++callIt;
+            }
+            if (calleeIdx < 0 || groupSetsGroups_[calleeIdx] ||
+                groupCommands_.size(calleeIdx) == 0 || groupCommands_.size(calleeIdx) > maxInlined) {
+                commands.push_back(PoolString(runtime_.stringpool(), groupCommands_.get_str_idx(i, j)));
+                continue;
+            }
+            for (int k = 0; k < groupCommands_.size(calleeIdx); ++k) {
+                commands.push_back(PoolString(runtime_.stringpool(), groupCommands_.get_str_idx(calleeIdx, k)));
             }
         }
         return commands;
@@ -288,6 +559,8 @@ public:
 
     /*!
         @brief  Sets a group.
+                As nothing is known about what its commands do, nothing is
+                inlined into or out of it, see get_inlined_group_commands().
 
         @param  name
                 The name of the group.
@@ -297,40 +570,176 @@ public:
         
         @return True if the set was successful, false otherwise.
     */
-    bool set_group(PoolString const & name, Deque<PoolString> const & commands) {
-        int i = 0;
+    bool set_group(symbol_t const & name, Deque<PoolString> const & commands) {
+        return set_group(name, commands, Deque<GroupCall>(runtime_.alloc()), true);
+    }
+
+    /*!
+        @brief  Sets a group, along with what is known about its commands
+                for inlining, see get_inlined_group_commands().
+
+        @param  name
+                The name of the group.
+
+        @param  commands
+                The commands for the group.
+
+        @param  calls
+                The commands which run another group once,
+                in the order of the commands.
+
+        @param  setsGroups
+                Whether any of the commands sets a group.
+
+        @return True if the set was successful, false otherwise.
+    */
+    bool set_group(symbol_t const & name, Deque<PoolString> const & commands,
+                   Deque<GroupCall> const & calls, bool const & setsGroups) {
+        // Out of strings to name it with
+        if (name.is_empty()) {
+            return false;
+        }
+        ++groupsVersion_;
         bool result = true;
-        for (typename Deque<PoolString>::Iterator it = groupNames_.begin(); it != groupNames_.end(); ++it, ++i) {
-            if (*it == name) {
-                groupCommands_.clear(i);
-                for (typename Deque<PoolString>::ConstIterator cmdIt = commands.begin(); cmdIt != commands.end(); ++cmdIt) {
-                    result = groupCommands_.push_back(i, *cmdIt) && result;
-                }
-                return result;
-            }
+        set_group_calls(name, calls);
+        int i = group_idx(name);
+        if (i < 0) {
+            result = groupNames_.push_front(name) && result;
+            result = groupSetsGroups_.push_front(setsGroups) && result;
+            groupCommands_.push_front();
+            i = 0;
+        }
+        else {
+            groupSetsGroups_[i] = setsGroups;
+            groupCommands_.clear(i);
         }
-        result = groupNames_.push_front(name) && result;
-        groupCommands_.push_front();
         for (typename Deque<PoolString>::ConstIterator cmdIt = commands.begin(); cmdIt != commands.end(); ++cmdIt) {
-            result = groupCommands_.push_back(0, *cmdIt) && result;
+            result = groupCommands_.push_back(i, *cmdIt) && result;
         }
         return result;
     }
 
+    /*!
+        @brief  Sets a group.
+
+        @param  name
+                The name of the group.
+
+        @param  commands
+                The commands for the group.
+
+        @return True if the set was successful, false otherwise.
+    */
+    bool set_group(PoolString const & name, Deque<PoolString> const & commands) {
+        return set_group(symbol_t(runtime_.stringpool(), name.c_str()), commands);
+    }
+
+    /*!
+        @brief  Gets a number which changes whenever a number or device is
+                added, or all of them are removed.
+                Anything found out about where numbers and devices are kept
+                is still true for as long as this number stays the same.
+
+        @return The version of the names of numbers and devices.
+    */
+    unsigned int names_version() const {
+        return namesVersion_;
+    }
+
+    /*!
+        @brief  Gets a number which changes whenever any group is set,
+                or all groups are removed.
+                Anything worked out from the commands of groups is still
+                up to date for as long as this number stays the same.
+
+        @return The version of the groups.
+    */
+    unsigned int groups_version() const {
+        return groupsVersion_;
+    }
+
 private:
-    GetAllocFunc * getAllocFunc_;
-    GetPoolFunc * getPoolFunc_;
+    /*!
+        @brief  Gets the symbol of a name, without interning it.
+                A name which is not interned cannot name anything.
 
-    Deque<PoolString> numberNames_;
+        @param  name
+                The name.
+
+        @return The symbol of the name, or an empty symbol if the name
+                is not interned.
+    */
+    symbol_t find_symbol(PoolString const & name) const {
+        return symbol_t::find(runtime_.stringpool(), name.c_str());
+    }
+
+    /*!
+        @brief  Gets where a group is kept.
+
+        @param  name
+                The name of the group.
+
+        @return The index of the group, or -1 if it does not exist.
+    */
+    int group_idx(symbol_t const & name) const {
+        int i = 0;
+        for (typename Deque<symbol_t>::ConstIterator it = groupNames_.cbegin(); it != groupNames_.cend(); ++it, ++i) {
+            if (*it == name) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /*!
+        @brief  Replaces the calls a group makes to other groups.
+
+        @param  name
+                The name of the group.
+
+        @param  calls
+                The new calls, in the order of the commands.
+    */
+    void set_group_calls(symbol_t const & name, Deque<GroupCall> const & calls) {
+        typename Deque<symbol_t>::Iterator callerIt = callerNames_.begin();
+        typename Deque<GroupCall>::Iterator callIt = groupCalls_.begin();
+        while (callerIt != callerNames_.end()) {
+            if (*callerIt == name) {
+                callerIt = callerNames_.erase(callerIt);
+                callIt = groupCalls_.erase(callIt);
+            }
+            else {
+                ++callerIt;
+                ++callIt;
+            }
+        }
+        for (typename Deque<GroupCall>::ConstIterator it = calls.begin(); it != calls.end(); ++it) {
+            callerNames_.push_back(name);
+            groupCalls_.push_back(*it);
+        }
+    }
+
+    Runtime runtime_;
+
+    Deque<symbol_t>   numberNames_;
     Deque<int>        numberValues_;
-    Deque<PoolString> deviceNames_;
+    Deque<symbol_t>   deviceNames_;
     Deque<DeviceType> deviceTypes_;
     Deque<int>        deviceInfo_0_;
     Deque<int>        deviceInfo_1_;
     Deque<int>        deviceInfo_2_;
 
-    Deque<PoolString>      groupNames_;
+    /** Changes whenever a number or device is added or all are removed */
+    unsigned int      namesVersion_;
+
+    Deque<symbol_t>        groupNames_;
     DequeDequePoolString<> groupCommands_;
+    Deque<bool>            groupSetsGroups_;
+    /** The calls groups make to other groups, kept together per group */
+    Deque<symbol_t>        callerNames_;
+    Deque<GroupCall>       groupCalls_;
+    /** Changes whenever a group is set or all groups are removed */
+    unsigned int           groupsVersion_;
 
 };
 
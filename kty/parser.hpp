@@ -4,6 +4,7 @@
 #include <kty/containers/deque.hpp>
 #include <kty/containers/string.hpp>
 #include <kty/containers/stringpool.hpp>
+#include <kty/runtime.hpp>
 #include <kty/token.hpp>
 #include <kty/tokenizer.hpp>
 #include <kty/string_utils.hpp>
@@ -14,39 +15,35 @@ namespace kty {
 /*!
     @brief  Class that performs parsing on commands.
 */
-template <typename GetAllocFunc = decltype(get_alloc), typename GetPoolFunc = decltype(get_stringpool), typename Token = Token<>, typename PoolString = PoolString<>>
+template <typename Runtime = Runtime<>, typename Token = Token<>, typename PoolString = PoolString<>>
 class Parser {
 
 public:
     /*!
         @brief  Constructor for Parser object.
 
-        @param  getAllocFunc
-                A function that returns a allocator pointer when called.
-
-        @param  getPoolFunc
-                A function that returns a pointer to a string pool when called.
+        @param  runtime
+                The runtime to allocate from.
+                If not provided, the globals returned by get_alloc and
+                get_stringpool are used.
     */
-    Parser(GetAllocFunc & getAllocFunc = get_alloc, GetPoolFunc & getPoolFunc = get_stringpool)
-        : getAllocFunc_(&getAllocFunc), getPoolFunc_(&getPoolFunc), command_(getAllocFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+    explicit Parser(Runtime const & runtime = Runtime())
+        : runtime_(runtime), command_(runtime.alloc()) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
     }
     
     /*!
         @brief  Constructor for Parser object.
 
-        @param  getAllocFunc
-                A function that returns a allocator pointer when called.
-
-        @param  getPoolFunc
-                A function that returns a pointer to a string pool when called.
+        @param  runtime
+                The runtime to allocate from.
 
         @param  command
                 The tokenized command to parse.
     */
-    Parser(GetAllocFunc & getAllocFunc, GetPoolFunc & getPoolFunc, Deque<Token> const & command)
-        : getAllocFunc_(&getAllocFunc), getPoolFunc_(&getPoolFunc), command_(getAllocFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+    Parser(Runtime const & runtime, Deque<Token> const & command)
+        : runtime_(runtime), command_(runtime.alloc()) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         set_command(command);
     }
 
@@ -57,7 +54,7 @@ public:
                 The tokenized command to parse.
     */
     void set_command(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         command_ = command;
         preprocess();
     }
@@ -68,7 +65,7 @@ public:
         @return The parsed command tokens.
     */
     Deque<Token> parse() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         return run_shunting_yard();        
     }
 
@@ -81,7 +78,7 @@ public:
         @return The parsed command tokens.
     */
     Deque<Token> parse(Deque<Token> const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         set_command(command);
         return parse();
     }
@@ -90,7 +87,7 @@ public:
         @brief  Preprocesses the stored command to prepare for parsing.
     */
     void preprocess() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         // Erase CMD_END token from the back if it exists
         if (command_.size() > 0 && command_.back().is_cmd_end()) {
             command_.pop_back();
@@ -108,70 +105,70 @@ public:
         @return The converted postfix expression.
     */
     Deque<Token> run_shunting_yard() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        Deque<Token> operatorStack(*getAllocFunc_);
-        Deque<Token> output(*getAllocFunc_);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        Deque<Token> operatorStack(runtime_.alloc());
+        Deque<Token> output(runtime_.alloc());
 
         for (typename Deque<Token>::Iterator it = command_.begin(); it != command_.end(); ++it) {
             Token & token = *it;
             if (token.is_operand()) {
-                Log.verbose(F("%s: operand\n"), PRINT_FUNC);
-                Log.verbose(F("%s: operand %s pushed to output\n"), PRINT_FUNC, token.str().c_str());
+                KTY_LOG_VERBOSE(F("%s: operand\n"), PRINT_FUNC);
+                KTY_LOG_VERBOSE(F("%s: operand %s pushed to output\n"), PRINT_FUNC, token.str().c_str());
                 output.push_back(token);
             }
             else if (token.is_function()) {
-                Log.verbose(F("%s: function\n"), PRINT_FUNC);
-                Log.verbose(F("%s: function %s pushed to operator stack\n"), PRINT_FUNC, token.str().c_str());
+                KTY_LOG_VERBOSE(F("%s: function\n"), PRINT_FUNC);
+                KTY_LOG_VERBOSE(F("%s: function %s pushed to operator stack\n"), PRINT_FUNC, token.str().c_str());
                 operatorStack.push_back(token);
             }
             else if (token.is_operator()) {
-                Log.verbose(F("%s: operator\n"), PRINT_FUNC);
+                KTY_LOG_VERBOSE(F("%s: operator\n"), PRINT_FUNC);
                 while (!operatorStack.is_empty() &&
                        (operatorStack.back().is_function() ||
                         operatorStack.back().has_greater_precedence_than(token) ||
                            (operatorStack.back().has_equal_precedence_to(token) && 
                             operatorStack.back().is_left_associative())) &&
                        !operatorStack.back().is_op_paren()) {
-                    Log.verbose(F("%s: operator %s pushed from operator stack to output\n"), PRINT_FUNC, operatorStack.back().str().c_str());
+                    KTY_LOG_VERBOSE(F("%s: operator %s pushed from operator stack to output\n"), PRINT_FUNC, operatorStack.back().str().c_str());
                     output.push_back(operatorStack.back());
                     operatorStack.pop_back();                    
                 }
-                Log.verbose(F("%s: operator %s pushed to operator stack\n"), PRINT_FUNC, token.str().c_str());
+                KTY_LOG_VERBOSE(F("%s: operator %s pushed to operator stack\n"), PRINT_FUNC, token.str().c_str());
                 operatorStack.push_back(token);
             }
             else if (token.is_op_paren()) {
-                Log.verbose(F("%s: op_paren\n"), PRINT_FUNC);
-                Log.verbose(F("%s: op paren %s pushed to operator stack\n"), PRINT_FUNC, token.str().c_str());
+                KTY_LOG_VERBOSE(F("%s: op_paren\n"), PRINT_FUNC);
+                KTY_LOG_VERBOSE(F("%s: op paren %s pushed to operator stack\n"), PRINT_FUNC, token.str().c_str());
                 operatorStack.push_back(token);
             }
             else if (token.is_cl_paren()) {
-                Log.verbose(F("%s: cl_paren\n"), PRINT_FUNC);
+                KTY_LOG_VERBOSE(F("%s: cl_paren\n"), PRINT_FUNC);
                 while (!operatorStack.is_empty() && 
                        !operatorStack.back().is_op_paren()) {
-                    Log.verbose(F("%s: %s pushed from operator stack to output\n"), PRINT_FUNC, operatorStack.back().str().c_str());
+                    KTY_LOG_VERBOSE(F("%s: %s pushed from operator stack to output\n"), PRINT_FUNC, operatorStack.back().str().c_str());
                     output.push_back(operatorStack.back());
                     operatorStack.pop_back();                    
                 }
-                Log.verbose(F("%s: %s popped from operator stack\n"), PRINT_FUNC, operatorStack.back().str().c_str());
+                KTY_LOG_VERBOSE(F("%s: %s popped from operator stack\n"), PRINT_FUNC, operatorStack.back().str().c_str());
                 operatorStack.pop_back();
             }
             else if (token.is_comma()) {
-                Log.verbose(F("%s: comma\n"), PRINT_FUNC);
+                KTY_LOG_VERBOSE(F("%s: comma\n"), PRINT_FUNC);
                 while (!operatorStack.is_empty() && 
                        !operatorStack.back().is_op_paren()) {
-                    Log.verbose(F("%s: %s pushed from operator stack to output\n"), PRINT_FUNC, operatorStack.back().str().c_str());
+                    KTY_LOG_VERBOSE(F("%s: %s pushed from operator stack to output\n"), PRINT_FUNC, operatorStack.back().str().c_str());
                     output.push_back(operatorStack.back());
                     operatorStack.pop_back();                    
                 }
             }
             else {
-                Log.verbose(F("%s: others\n"), PRINT_FUNC);
-                Log.verbose(F("%s: %s pushed to output\n"), PRINT_FUNC, token.str().c_str());
+                KTY_LOG_VERBOSE(F("%s: others\n"), PRINT_FUNC);
+                KTY_LOG_VERBOSE(F("%s: %s pushed to output\n"), PRINT_FUNC, token.str().c_str());
                 output.push_back(token);
             }
         }
         while (!operatorStack.is_empty()) {
-            Log.verbose(F("%s: %s pushed from operator stack to output\n"), PRINT_FUNC, operatorStack.back().str().c_str());
+            KTY_LOG_VERBOSE(F("%s: %s pushed from operator stack to output\n"), PRINT_FUNC, operatorStack.back().str().c_str());
             output.push_back(operatorStack.back());
             operatorStack.pop_back();
         }
@@ -179,8 +176,7 @@ public:
     }
 
 private:
-    GetAllocFunc * getAllocFunc_;
-    GetPoolFunc * getPoolFunc_;
+    Runtime runtime_;
     Deque<Token> command_;
 
 };
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <kty/containers/allocator.hpp>
+#include <kty/containers/stringpool.hpp>
+#include <kty/sizes.hpp>
+#include <kty/types.hpp>
+
+namespace kty {
+
+/*!
+    @brief  Class that holds the memory an interpreter runs in.
+            Every component is given a runtime when it is constructed,
+            and allocates all of its nodes and strings from it.
+            Giving each interpreter its own runtime allows several
+            independent interpreters to live in one program.
+            A runtime only points to its allocator and string pool,
+            so it is cheap to copy.
+*/
+template <typename Alloc = Allocator<Sizes::alloc_size, Sizes::alloc_block_size>, typename StringPool = StringPool<Sizes::stringpool_size, Sizes::string_length>>
+class Runtime {
+
+public:
+    /** The type of allocator used by the runtime */
+    typedef Alloc alloc_t;
+    /** The type of string pool used by the runtime */
+    typedef StringPool stringpool_t;
+
+    /*!
+        @brief  Constructor for the runtime.
+
+        @param  alloc
+                The allocator for all deque nodes.
+
+        @param  stringPool
+                The string pool for all strings.
+    */
+    Runtime(Alloc & alloc, StringPool & stringPool)
+        : alloc_(&alloc), stringPool_(&stringPool) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+    }
+
+    /*!
+        @brief  Constructor for the runtime.
+                Uses the allocator and string pool returned by the given
+                functions, which are only called once, here.
+
+        @param  getAllocFunc
+                A function that returns an allocator pointer when called.
+
+        @param  getPoolFunc
+                A function that returns a pointer to a string pool when called.
+    */
+    explicit Runtime(decltype(get_alloc) & getAllocFunc = get_alloc, decltype(get_stringpool) & getPoolFunc = get_stringpool)
+        : alloc_(getAllocFunc(nullptr)), stringPool_(getPoolFunc(nullptr)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+    }
+
+    /*!
+        @brief  Gets the allocator of the runtime.
+
+        @return A reference to the allocator.
+    */
+    Alloc & alloc() const {
+        return *alloc_;
+    }
+
+    /*!
+        @brief  Gets the string pool of the runtime.
+
+        @return A reference to the string pool.
+    */
+    StringPool & stringpool() const {
+        return *stringPool_;
+    }
+
+private:
+    Alloc * alloc_;
+    StringPool * stringPool_;
+
+};
+
+} // namespace kty
@@ -17,6 +17,28 @@ public:
     static const int stringpool_size = 64;
     /** The maximum number of characters per string. */    
     static const int string_length = 32;
+    /** The number of slots in the timer wheel. */
+    static const int timer_wheel_size = 8;
+    /** The number of milliseconds covered by one timer wheel slot. */
+    static const int timer_tick_ms = 16;
+    /** The number of tasks which can wait for their turn at once. */
+    static const int task_count = 6;
+    /** The number of groups which can be run with Every at once. */
+    static const int repeat_count = 4;
+    /** The number of milliseconds between updates of fading LEDs. */
+    static const int fade_tick_ms = 16;
+    /** The number of commands run before handing control back, when limited. */
+    static const int command_budget = 8;
+    /** The number of characters of typed input held before it is read. */
+    static const int input_buffer_size = 128;
+    /** The maximum number of instructions in one compiled expression. */
+    static const int program_size = 32;
+    /** The number of groups whose commands are kept ready to run. */
+    static const int group_cache_size = 2;
+    /** The number of names whose values are looked up without a search. */
+    static const int name_cache_size = 8;
+    /** The largest group, in commands, which is inlined where it is run. */
+    static const int inline_group_size = 4;
 #else // When running on desktop console
     /** The number of blocks in the allocator. */
     static const int alloc_size = 200;
@@ -26,6 +48,28 @@ public:
     static const int stringpool_size = 200;
     /** The maximum number of characters per string. */
     static const int string_length = 128;
+    /** The number of slots in the timer wheel. */
+    static const int timer_wheel_size = 64;
+    /** The number of milliseconds covered by one timer wheel slot. */
+    static const int timer_tick_ms = 16;
+    /** The number of tasks which can wait for their turn at once. */
+    static const int task_count = 32;
+    /** The number of groups which can be run with Every at once. */
+    static const int repeat_count = 16;
+    /** The number of milliseconds between updates of fading LEDs. */
+    static const int fade_tick_ms = 16;
+    /** The number of commands run before handing control back, when limited. */
+    static const int command_budget = 1000;
+    /** The number of characters of typed input held before it is read. */
+    static const int input_buffer_size = 1024;
+    /** The maximum number of instructions in one compiled expression. */
+    static const int program_size = 128;
+    /** The number of groups whose commands are kept ready to run. */
+    static const int group_cache_size = 16;
+    /** The number of names whose values are looked up without a search. */
+    static const int name_cache_size = 32;
+    /** The largest group, in commands, which is inlined where it is run. */
+    static const int inline_group_size = 8;
 #endif
 
 private:
@@ -161,10 +161,9 @@ namespace kty {
     @return The int represented in the string.
             If the string is invalid, 0 is returned.
 */
-template <typename PoolString = PoolString<>>
-int str_to_int(PoolString const & str) {
-    Log.verbose(F("%s\n"), PRINT_FUNC);
-    int len = str.strlen();
+int str_to_int(char const * str) {
+    KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+    int len = ::strlen(str);
     if (len == 0) {
         return 0;
     }
@@ -193,20 +192,36 @@ int str_to_int(PoolString const & str) {
     return result;
 }
 
+/*! 
+    @brief  Converts the string representation of an integer to an int.
+
+    @param  str
+            The string to be converted.
+            The string can be prefixed with a '-', which indicates a negative number.
+
+    @return The int represented in the string.
+            If the string is invalid, 0 is returned.
+*/
+template <typename PoolString = PoolString<>>
+int str_to_int(PoolString const & str) {
+    return str_to_int(static_cast<char const *>(str.c_str()));
+}
+
 /*! 
     @brief  Converts an integer into its string representation.
 
     @param  i
             The integer to be converted.
 
-    @param  stringPool
-            The pool used to allocate strings.
+    @param  getPoolFunc
+            A function that returns a pointer to a string pool when called,
+            or the string pool itself, used to allocate the string.
 
     @return The string representation of the integer.
 */
 template <typename GetPoolFunc = decltype(get_stringpool), typename PoolString = PoolString<>>
 PoolString int_to_str(int i, GetPoolFunc & getPoolFunc = get_stringpool) {
-    Log.verbose(F("%s\n"), PRINT_FUNC);
+    KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
     char strChar[2] = "";
     bool isNegative = false;
     if (i < 0) {
@@ -214,6 +229,10 @@ PoolString int_to_str(int i, GetPoolFunc & getPoolFunc = get_stringpool) {
         i *= -1;
     }
     PoolString output(getPoolFunc);
+    if (i == 0) {
+        output = "0";
+        return output;
+    }
     // output will contain digits in reverse order
     while (i > 0) {
         strChar[0] = (char)(i % 10 + '0');
@@ -245,7 +264,7 @@ PoolString int_to_str(int i, GetPoolFunc & getPoolFunc = get_stringpool) {
 */
 template <typename PoolString = PoolString<>>
 void remove_str_whitespace(PoolString & str) {
-    Log.verbose(F("%s\n"), PRINT_FUNC);
+    KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
     PoolString temp(str);
     temp = "";
     char str_[2] = " ";
@@ -269,28 +288,25 @@ void remove_str_whitespace(PoolString & str) {
 */
 template <typename PoolString = PoolString<>>
 void remove_str_multiple_whitespace(PoolString & str) {
-    Log.verbose(F("%s\n"), PRINT_FUNC);
-    PoolString temp(str);
-    temp = "";
-    char str_[2] = " ";
-    int len = str.strlen();
+    KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+    // The string only gets shorter, so it is rewritten in a single pass
+    char * chars = str.c_str();
+    int len = 0;
     int i = 0;
-    while (i < len) {
-        if (isspace(str[i])) {
+    while (chars[i] != '\0') {
+        if (isspace(chars[i])) {
             // Replace all types of whitespace with ' '
-            str_[0] = ' ';
+            chars[len++] = ' ';
             // Skip forward until non-whitespace
-            while (i < len && isspace(str[i])) {
+            while (isspace(chars[i])) {
                 ++i;
             }
         }
         else {
-            str_[0] = str[i];
-            ++i;
+            chars[len++] = chars[i++];
         }
-        temp += str_;
     }
-    str = temp;
+    chars[len] = '\0';
 }
 
 } // namespace kty
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <kty/containers/stringpool.hpp>
+#include <kty/sizes.hpp>
+#include <kty/types.hpp>
+
+namespace kty {
+
+/*!
+    @brief  Class that holds a name interned in a string pool.
+            Every distinct name is stored once, and equal names share the
+            same 16-bit id, which is the index of their string in the pool.
+            Comparing two symbols compares their ids, not their characters.
+            The name is kept alive for as long as a symbol, or any copy of
+            it, refers to it, and its text can always be read back.
+*/
+template <typename Pool = StringPool<Sizes::stringpool_size, Sizes::string_length>>
+class Symbol {
+
+public:
+    /** The id of the empty symbol, which refers to no name */
+    static const unsigned short NO_ID = 0xFFFF;
+
+    /*!
+        @brief  Constructor for an empty symbol without a pool,
+                e.g. for the free slots of an array.
+    */
+    Symbol()
+        : pool_(nullptr), id_(NO_ID) {
+    }
+
+    /*!
+        @brief  Constructor for an empty symbol.
+
+        @param  stringPool
+                The string pool to intern names in.
+    */
+    explicit Symbol(Pool & stringPool)
+        : pool_(&stringPool), id_(NO_ID) {
+    }
+
+    /*!
+        @brief  Constructor for a symbol, interning its name if it is not
+                interned yet.
+                If the pool is out of strings, the symbol is empty.
+
+        @param  stringPool
+                The string pool to intern the name in.
+
+        @param  name
+                The name. An empty name gives an empty symbol.
+    */
+    Symbol(Pool & stringPool, char const * name)
+        : pool_(&stringPool), id_(NO_ID) {
+        if (name[0] != '\0') {
+            int idx = pool_->intern(name);
+            id_ = idx < 0 ? NO_ID : idx;
+        }
+    }
+
+    /*!
+        @brief  Constructor for a symbol which shares a name that is already
+                interned.
+
+        @param  stringPool
+                The string pool holding the name.
+
+        @param  id
+                The index of the interned name in the pool.
+    */
+    Symbol(Pool & stringPool, int const & id)
+        : pool_(&stringPool), id_(id) {
+        pool_->inc_ref_count(id_);
+    }
+
+    /*!
+        @brief  Copy constructor for a symbol.
+                The name is shared, not copied.
+
+        @param  other
+                The symbol to copy from.
+    */
+    Symbol(Symbol const & other)
+        : pool_(other.pool_), id_(other.id_) {
+        if (id_ != NO_ID) {
+            pool_->inc_ref_count(id_);
+        }
+    }
+
+    /*!
+        @brief  Copy assignment operator for a symbol.
+                The name is shared, not copied.
+
+        @param  other
+                The symbol to copy from.
+
+        @return A reference to this symbol.
+    */
+    Symbol & operator=(Symbol const & other) {
+        if (other.id_ != NO_ID) {
+            other.pool_->inc_ref_count(other.id_);
+        }
+        release();
+        pool_ = other.pool_;
+        id_ = other.id_;
+        return *this;
+    }
+
+    /*!
+        @brief  Destructor for a symbol.
+    */
+    ~Symbol() {
+        release();
+    }
+
+    /*!
+        @brief  Gets the symbol of a name which is already interned,
+                without interning it.
+
+        @param  stringPool
+                The string pool to look in.
+
+        @param  name
+                The name to look for.
+
+        @return The symbol of the name,
+                or an empty symbol if the name is not interned.
+    */
+    static Symbol find(Pool & stringPool, char const * name) {
+        int idx = stringPool.find_interned(name);
+        return idx < 0 ? Symbol(stringPool) : Symbol(stringPool, idx);
+    }
+
+    /*!
+        @brief  Gets the id of the symbol.
+
+        @return The id, or NO_ID if the symbol is empty.
+    */
+    unsigned short id() const {
+        return id_;
+    }
+
+    /*!
+        @brief  Checks if the symbol refers to no name.
+
+        @return True if the symbol is empty, false otherwise.
+    */
+    bool is_empty() const {
+        return id_ == NO_ID;
+    }
+
+    /*!
+        @brief  Gets the name of the symbol.
+
+        @return The name, or an empty string if the symbol is empty.
+    */
+    char const * c_str() const {
+        return id_ == NO_ID ? "" : pool_->c_str(id_);
+    }
+
+    /*!
+        @brief  Checks if two symbols refer to the same name.
+                Empty symbols are not equal to anything, themselves included.
+
+        @param  other
+                The symbol to compare to.
+
+        @return True if both symbols refer to the same name, false otherwise.
+    */
+    bool operator==(Symbol const & other) const {
+        return id_ == other.id_ && id_ != NO_ID && pool_ == other.pool_;
+    }
+
+    /*!
+        @brief  Checks if two symbols refer to different names.
+
+        @param  other
+                The symbol to compare to.
+
+        @return True if the symbols do not refer to the same name,
+                false otherwise.
+    */
+    bool operator!=(Symbol const & other) const {
+        return !(*this == other);
+    }
+
+private:
+    /*!
+        @brief  Lets go of the name, if any.
+    */
+    void release() {
+        // Deques assign into zeroed memory, which has no pool
+        if (pool_ != nullptr && id_ != NO_ID) {
+            pool_->deallocate_idx(id_);
+            id_ = NO_ID;
+        }
+    }
+
+    /** The string pool holding the name */
+    Pool * pool_;
+    /** The index of the name in the pool, or NO_ID if empty */
+    unsigned short id_;
+
+};
+
+} // namespace kty
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <kty/containers/allocator.hpp>
+#include <kty/containers/deque.hpp>
+#include <kty/containers/string.hpp>
+#include <kty/containers/stringpool.hpp>
+#include <kty/runtime.hpp>
+#include <kty/sizes.hpp>
+#include <kty/types.hpp>
+
+namespace kty {
+
+/*!
+    @brief  Class that holds blocks of commands until a deadline.
+            Timers are hashed into a fixed number of slots by their deadline,
+            each slot covering Sizes::timer_tick_ms milliseconds, so finding
+            the due timers only looks at the slots the clock has moved past.
+            Timers further away than one turn of the wheel stay in their slot
+            until the wheel comes around to them again.
+            Deadlines are compared with wrap-around in mind, so the wheel keeps
+            working when millis() overflows, as long as the number of slots
+            and the tick length are powers of two.
+*/
+template <typename Runtime = Runtime<>, typename PoolString = PoolString<>>
+class TimerWheel {
+
+public:
+    /*!
+        @brief  Constructor for the timer wheel.
+
+        @param  runtime
+                The runtime to allocate from.
+                If not provided, the globals returned by get_alloc and
+                get_stringpool are used.
+    */
+    explicit TimerWheel(Runtime const & runtime = Runtime()) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        for (int i = 0; i < Sizes::timer_wheel_size; ++i) {
+            slots_[i] = Deque<Timer>(runtime.alloc());
+        }
+        size_ = 0;
+        nextBlock_ = 0;
+        cursor_ = 0;
+    }
+
+    /*!
+        @brief  Removes all timers, and starts the wheel from the beginning.
+    */
+    void clear() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        for (int i = 0; i < Sizes::timer_wheel_size; ++i) {
+            slots_[i].clear();
+        }
+        size_ = 0;
+        cursor_ = 0;
+    }
+
+    /*!
+        @brief  Checks if there are no timers left.
+
+        @return True if there are no timers, false otherwise.
+    */
+    bool is_empty() const {
+        return size_ == 0;
+    }
+
+    /*!
+        @brief  Gets the number of commands held by the timers.
+
+        @return The number of commands held.
+    */
+    int size() const {
+        return size_;
+    }
+
+    /*!
+        @brief  Holds a block of commands until a deadline.
+
+        @param  deadline
+                The time at which the commands are due, from millis().
+                A deadline which has already passed is due straight away.
+
+        @param  commands
+                The commands to hold, in the order they should run.
+
+        @return True if the block was scheduled, false if there was not
+                enough memory, in which case nothing is scheduled.
+    */
+    bool schedule(unsigned long const & deadline, Deque<PoolString> const & commands) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (commands.is_empty()) {
+            return true;
+        }
+        // Deadlines behind the cursor go into the slot it is about to look at
+        Deque<Timer> & slot = slots_[slot_idx((long)(deadline - cursor_) < 0 ? cursor_ : deadline)];
+        unsigned int block = nextBlock_++;
+        int numPushed = 0;
+        for (typename Deque<PoolString>::ConstIterator it = commands.begin(); it != commands.end(); ++it) {
+            if (!slot.push_back(Timer{deadline, block, *it})) {
+                KTY_LOG_WARNING(F("%s: Unable to schedule block of %d commands\n"), PRINT_FUNC, commands.size());
+                for ( ; numPushed > 0; --numPushed) {
+                    slot.pop_back();
+                }
+                if (slot.is_empty()) {
+                    slot.release_head();
+                }
+                return false;
+            }
+            ++numPushed;
+        }
+        size_ += numPushed;
+        return true;
+    }
+
+    /*!
+        @brief  Takes the commands of one block which is due.
+                Blocks in the same slot come out in the order they were
+                scheduled.
+
+        @param  now
+                The current time, from millis().
+
+        @param  commands
+                Where to append the commands of the block.
+
+        @return True if a block was due, false otherwise.
+    */
+    bool pop_due(unsigned long const & now, Deque<PoolString> & commands) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        // If the clock has moved around the whole wheel since the last call,
+        // every slot gets looked at once
+        if (now - cursor_ >= (unsigned long)Sizes::timer_tick_ms * Sizes::timer_wheel_size) {
+            cursor_ = now - now % Sizes::timer_tick_ms - (unsigned long)Sizes::timer_tick_ms * (Sizes::timer_wheel_size - 1);
+        }
+        while (size_ > 0) {
+            Deque<Timer> & slot = slots_[slot_idx(cursor_)];
+            for (typename Deque<Timer>::Iterator it = slot.begin(); it != slot.end(); ++it) {
+                if ((long)(now - it->deadline) < 0) {
+                    continue;
+                }
+                unsigned int block = it->block;
+                while (it != slot.end() && it->block == block) {
+                    commands.push_back(it->command);
+                    it = slot.erase(it);
+                    --size_;
+                }
+                // Empty slots give their head node back to the allocator
+                if (slot.is_empty()) {
+                    slot.release_head();
+                }
+                return true;
+            }
+            // Stay on the current slot, as it can still get due timers
+            if (now - cursor_ < (unsigned long)Sizes::timer_tick_ms) {
+                break;
+            }
+            cursor_ += Sizes::timer_tick_ms;
+        }
+        return false;
+    }
+
+    /*!
+        @brief  Gets the time left until the next block is due.
+
+        @param  now
+                The current time, from millis().
+
+        @return The number of milliseconds until the next block is due,
+                0 if a block is already due, or -1 if there are no timers.
+    */
+    long time_until_next(unsigned long const & now) const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        long minTimeLeft = -1;
+        for (int i = 0; i < Sizes::timer_wheel_size; ++i) {
+            for (typename Deque<Timer>::ConstIterator it = slots_[i].begin(); it != slots_[i].end(); ++it) {
+                long timeLeft = (long)(it->deadline - now);
+                if (timeLeft < 0) {
+                    timeLeft = 0;
+                }
+                if (minTimeLeft == -1 || timeLeft < minTimeLeft) {
+                    minTimeLeft = timeLeft;
+                }
+            }
+        }
+        return minTimeLeft;
+    }
+
+private:
+    /*!
+        @brief  Gets the slot holding the timers due at a given time.
+
+        @param  time
+                The time, from millis().
+
+        @return The index of the slot.
+    */
+    static int slot_idx(unsigned long const & time) {
+        return (time / Sizes::timer_tick_ms) % Sizes::timer_wheel_size;
+    }
+
+    /*!
+        @brief  A single command held until a deadline.
+    */
+    struct Timer {
+        /** The time at which the command is due, from millis() */
+        unsigned long deadline;
+        /** The block the command belongs to */
+        unsigned int block;
+        /** The command */
+        PoolString command;
+    };
+
+    /** The timers, hashed by the tick of their deadline */
+    Deque<Timer> slots_[Sizes::timer_wheel_size];
+    /** The number of commands held */
+    int size_;
+    /** The number given to the next block scheduled */
+    unsigned int nextBlock_;
+    /** The start time of the slot that will be looked at next */
+    unsigned long cursor_;
+
+};
+
+} // namespace kty
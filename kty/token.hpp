@@ -2,6 +2,7 @@
 
 #include <kty/containers/string.hpp>
 #include <kty/containers/stringpool.hpp>
+#include <kty/symbol.hpp>
 #include <kty/types.hpp>
 
 namespace kty {
@@ -9,8 +10,8 @@ namespace kty {
 // Not using enum class due to int conversion requirement for ArduinoUnit
 /** The various types of tokens possible */
 enum TokenType {
-    CREATE_NUM = 0, CREATE_LED, CREATE_GROUP, RUN_GROUP,
-    MOVE_BY_FOR, MOVE_BY, SET_TO_FOR, SET_TO,
+    CREATE_NUM = 0, CREATE_CONST, CREATE_LED, CREATE_GROUP, RUN_GROUP, SPAWN, EVERY,
+    MOVE_BY_FOR, MOVE_BY, SET_TO_FOR, SET_TO, FADE_TO,
     PRINT, WAIT,
     NAME, NUM_VAL, STRING,
     IF, ELSE, 
@@ -23,6 +24,191 @@ enum TokenType {
     UNKNOWN_TOKEN,
 };
 
+/*!
+    @brief  The function that works out the result of an operator from the
+            values of its operands.
+            Unary operators get their operand as rhs, and ignore lhs.
+*/
+typedef int OperatorKernel(int lhs, int rhs);
+
+/*!
+    @brief  Checks if two values are equal.
+*/
+inline int op_equals(int lhs, int rhs) {
+    return lhs == rhs;
+}
+
+/*!
+    @brief  Checks if a value is less than or equal to another.
+*/
+inline int op_l_equals(int lhs, int rhs) {
+    return lhs <= rhs;
+}
+
+/*!
+    @brief  Checks if a value is greater than or equal to another.
+*/
+inline int op_g_equals(int lhs, int rhs) {
+    return lhs >= rhs;
+}
+
+/*!
+    @brief  Checks if a value is less than another.
+*/
+inline int op_less(int lhs, int rhs) {
+    return lhs < rhs;
+}
+
+/*!
+    @brief  Checks if a value is greater than another.
+*/
+inline int op_greater(int lhs, int rhs) {
+    return lhs > rhs;
+}
+
+/*!
+    @brief  Adds two values.
+*/
+inline int op_math_add(int lhs, int rhs) {
+    return lhs + rhs;
+}
+
+/*!
+    @brief  Subtracts a value from another.
+*/
+inline int op_math_sub(int lhs, int rhs) {
+    return lhs - rhs;
+}
+
+/*!
+    @brief  Multiplies two values.
+*/
+inline int op_math_mul(int lhs, int rhs) {
+    return lhs * rhs;
+}
+
+/*!
+    @brief  Divides a value by another.
+*/
+inline int op_math_div(int lhs, int rhs) {
+    return lhs / rhs;
+}
+
+/*!
+    @brief  Gets the remainder of dividing a value by another.
+*/
+inline int op_math_mod(int lhs, int rhs) {
+    return lhs % rhs;
+}
+
+/*!
+    @brief  Checks if both values are true.
+*/
+inline int op_logi_and(int lhs, int rhs) {
+    return lhs && rhs;
+}
+
+/*!
+    @brief  Checks if either value is true.
+*/
+inline int op_logi_or(int lhs, int rhs) {
+    return lhs || rhs;
+}
+
+/*!
+    @brief  Checks if exactly one of two values is true.
+*/
+inline int op_logi_xor(int lhs, int rhs) {
+    return !lhs != !rhs;
+}
+
+/*!
+    @brief  Negates a value.
+*/
+inline int op_unary_neg(int lhs, int rhs) {
+    return -rhs;
+}
+
+/*!
+    @brief  Checks if a value is false.
+*/
+inline int op_logi_not(int lhs, int rhs) {
+    return !rhs;
+}
+
+/*!
+    @brief  Raises a value to the power of another.
+            Negative exponents give 1.
+*/
+inline int op_math_pow(int lhs, int rhs) {
+    int result = 1;
+    for (int i = 0; i < rhs; ++i) {
+        result *= lhs;
+    }
+    return result;
+}
+
+/** Everything about a type of token which does not depend on its value */
+struct TokenTypeInfo {
+    /** How tightly an operator binds, highest first, or 0 if not an operator */
+    unsigned char precedence;
+    /** The number of operands of an operator, or 0 if not an operator */
+    unsigned char numOperands;
+    /** The number of arguments of a function, or 0 if not a function */
+    unsigned char numArguments;
+    /** Whether an operator groups from the left with operators of the same precedence */
+    bool isLeftAssociative;
+    /** Works out the result of an operator, or nullptr if not an operator */
+    OperatorKernel * kernel;
+};
+
+/** The information about every type of token, indexed by the type */
+constexpr TokenTypeInfo tokenTypeInfo[] = {
+    {0, 0, 1, false, nullptr}, // CREATE_NUM
+    {0, 0, 1, false, nullptr}, // CREATE_CONST
+    {0, 0, 2, false, nullptr}, // CREATE_LED
+    {0, 0, 0, false, nullptr}, // CREATE_GROUP
+    {0, 0, 1, false, nullptr}, // RUN_GROUP
+    {0, 0, 0, false, nullptr}, // SPAWN
+    {0, 0, 1, false, nullptr}, // EVERY
+    {0, 0, 2, false, nullptr}, // MOVE_BY_FOR
+    {0, 0, 1, false, nullptr}, // MOVE_BY
+    {0, 0, 2, false, nullptr}, // SET_TO_FOR
+    {0, 0, 1, false, nullptr}, // SET_TO
+    {0, 0, 3, false, nullptr}, // FADE_TO
+    {0, 0, 0, false, nullptr}, // PRINT
+    {0, 0, 1, false, nullptr}, // WAIT
+    {0, 0, 0, false, nullptr}, // NAME
+    {0, 0, 0, false, nullptr}, // NUM_VAL
+    {0, 0, 0, false, nullptr}, // STRING
+    {0, 0, 1, false, nullptr}, // IF
+    {0, 0, 0, false, nullptr}, // ELSE
+    {0, 0, 0, false, nullptr}, // OP_PAREN
+    {0, 0, 0, false, nullptr}, // CL_PAREN
+    {0, 0, 0, false, nullptr}, // COMMA
+    {2, 2, 0, true, op_equals}, // EQUALS
+    {2, 2, 0, true, op_l_equals}, // L_EQUALS
+    {2, 2, 0, true, op_g_equals}, // G_EQUALS
+    {2, 2, 0, true, op_less}, // LESS
+    {2, 2, 0, true, op_greater}, // GREATER
+    {3, 2, 0, true, op_math_add}, // MATH_ADD
+    {3, 2, 0, true, op_math_sub}, // MATH_SUB
+    {4, 2, 0, true, op_math_mul}, // MATH_MUL
+    {4, 2, 0, true, op_math_div}, // MATH_DIV
+    {4, 2, 0, true, op_math_mod}, // MATH_MOD
+    {5, 2, 0, false, op_math_pow}, // MATH_POW
+    {6, 1, 0, true, op_unary_neg}, // UNARY_NEG
+    {1, 2, 0, true, op_logi_and}, // LOGI_AND
+    {1, 2, 0, true, op_logi_or}, // LOGI_OR
+    {1, 2, 0, true, op_logi_xor}, // LOGI_XOR
+    {6, 1, 0, true, op_logi_not}, // LOGI_NOT
+    {0, 0, 0, false, nullptr}, // CMD_END
+    {0, 0, 0, false, nullptr}, // UNKNOWN_TOKEN
+};
+
+static_assert(sizeof(tokenTypeInfo) / sizeof(tokenTypeInfo[0]) == TokenType::UNKNOWN_TOKEN + 1,
+              "Every type of token needs its information");
+
 /*!
     @brief  Class that contains all the information about a token.
 */
@@ -30,6 +216,9 @@ template <typename GetPoolFunc = decltype(get_stringpool)>
 class Token {
 
 public:
+    /** The type of string pool holding the values of tokens */
+    typedef StringPool<Sizes::stringpool_size, Sizes::string_length> Pool;
+
     /*!
         @brief  The constructor for a token.
 
@@ -37,9 +226,11 @@ public:
                 A function that returns a pointer to a string pool when called.
     */
     explicit Token(GetPoolFunc & getPoolFunc = get_stringpool)
-        : value_(getPoolFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : pool_(getPoolFunc(nullptr)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         type_ = TokenType::UNKNOWN_TOKEN;
+        poolIdx_ = -1;
+        offset_ = 0;
     }
 
     /*!
@@ -52,9 +243,60 @@ public:
                 A function that returns a pointer to a string pool when called.
     */
     Token(TokenType type, GetPoolFunc & getPoolFunc = get_stringpool) 
-        : value_(getPoolFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : pool_(getPoolFunc(nullptr)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         type_ = type;
+        poolIdx_ = -1;
+        offset_ = 0;
+    }
+
+    /*!
+        @brief  The constructor for a token.
+
+        @param  type
+                The type of token.
+
+        @param  stringPool
+                The string pool to store the value of the token in.
+
+        @param  value
+                The value to store in the token.
+    */
+    Token(TokenType type, Pool & stringPool, char const * value = "") 
+        : pool_(&stringPool) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        type_ = type;
+        poolIdx_ = -1;
+        offset_ = 0;
+        copy_value(value);
+    }
+
+    /*!
+        @brief  The constructor for a token whose value is part of a string
+                in a string pool, which may hold the values of other tokens
+                as well. Nothing is copied, and the string is kept alive for
+                as long as the token, or any copy of it, needs it.
+
+        @param  type
+                The type of token.
+
+        @param  stringPool
+                The string pool holding the value of the token.
+
+        @param  poolIdx
+                The index of the string holding the value of the token.
+
+        @param  offset
+                Where the value starts within the string.
+                The value ends at the next '\0'.
+    */
+    Token(TokenType type, Pool & stringPool, int const & poolIdx, int const & offset) 
+        : pool_(&stringPool) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        type_ = type;
+        poolIdx_ = poolIdx;
+        offset_ = offset;
+        pool_->inc_ref_count(poolIdx_);
     }
 
     /*!
@@ -67,10 +309,12 @@ public:
                 The value to store in the token.
     */
     Token(TokenType type, PoolString<> const & value) 
-        : value_(value) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : pool_(&value.pool()) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         type_ = type;
-        value_ = value;
+        poolIdx_ = -1;
+        offset_ = 0;
+        copy_value(value.c_str());
     }
 
     /*!
@@ -86,10 +330,57 @@ public:
                 A function that returns a pointer to a string pool when called.
     */
     Token(TokenType type, char const * value, GetPoolFunc & getPoolFunc = get_stringpool) 
-        : value_(getPoolFunc) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        : pool_(getPoolFunc(nullptr)) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         type_ = type;
-        value_ = value;
+        poolIdx_ = -1;
+        offset_ = 0;
+        copy_value(value);
+    }
+
+    /*!
+        @brief  Copy constructor for a token.
+                The value is shared with the other token, not copied.
+
+        @param  other
+                The token to copy from.
+    */
+    Token(Token const & other)
+        : pool_(other.pool_) {
+        type_ = other.type_;
+        poolIdx_ = other.poolIdx_;
+        offset_ = other.offset_;
+        if (poolIdx_ >= 0) {
+            pool_->inc_ref_count(poolIdx_);
+        }
+    }
+
+    /*!
+        @brief  Copy assignment operator for a token.
+                The value is shared with the other token, not copied.
+
+        @param  other
+                The token to copy from.
+
+        @return A reference to this token.
+    */
+    Token & operator=(Token const & other) {
+        if (other.poolIdx_ >= 0) {
+            other.pool_->inc_ref_count(other.poolIdx_);
+        }
+        release_value();
+        type_ = other.type_;
+        pool_ = other.pool_;
+        poolIdx_ = other.poolIdx_;
+        offset_ = other.offset_;
+        return *this;
+    }
+
+    /*!
+        @brief  Destructor for a token.
+    */
+    ~Token() {
+        release_value();
     }
 
     /*!
@@ -99,7 +390,7 @@ public:
                 The type to set to.
     */
     void set_type(TokenType type) {
-        Log.verbose(F("%s: setting to %d\n"), PRINT_FUNC, type);
+        KTY_LOG_VERBOSE(F("%s: setting to %d\n"), PRINT_FUNC, type);
         type_ = type;
     }
 
@@ -109,7 +400,7 @@ public:
         @return The type of the token.
     */
     TokenType get_type() const {
-        Log.verbose(F("%s: getting %d\n"), PRINT_FUNC, type_);
+        KTY_LOG_VERBOSE(F("%s: getting %d\n"), PRINT_FUNC, type_);
         return type_;
     }
 
@@ -120,18 +411,46 @@ public:
                 The value to set to.
     */
     void set_value(PoolString<> const & value) {
-        Log.verbose(F("%s: setting to %s\n"), PRINT_FUNC, value.c_str());
-        value_ = value;
+        KTY_LOG_VERBOSE(F("%s: setting to %s\n"), PRINT_FUNC, value.c_str());
+        release_value();
+        pool_ = &value.pool();
+        copy_value(value.c_str());
     }
 
     /*!
         @brief  Gets the value of the token.
 
-        @return A copy of the value of the token.
+        @return A copy of the value of the token, which can outlive the token.
     */
     PoolString<> get_value() const {
-        Log.verbose(F("%s: getting %s\n"), PRINT_FUNC, value_.c_str());
-        return value_;
+        KTY_LOG_VERBOSE(F("%s: getting %s\n"), PRINT_FUNC, value_c_str());
+        return PoolString<>(*pool_, value_c_str());
+    }
+
+    /*!
+        @brief  Gets the value of the token without copying it.
+
+        @return The value of the token, which is only valid for as long as
+                the token is.
+    */
+    char const * value_c_str() const {
+        return poolIdx_ < 0 ? "" : pool_->c_str(poolIdx_) + offset_;
+    }
+
+    /*!
+        @brief  Gets the value of the token as a symbol.
+                The values of name tokens are interned when the token is made,
+                so this only shares the name.
+
+        @return The symbol of the value, or an empty symbol if the value
+                is empty.
+    */
+    Symbol<Pool> get_symbol() const {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (offset_ == 0 && pool_->is_interned(poolIdx_)) {
+            return Symbol<Pool>(*pool_, poolIdx_);
+        }
+        return Symbol<Pool>(*pool_, value_c_str());
     }
 
     /*!
@@ -140,15 +459,13 @@ public:
         @return The string representaion of the token.
     */
     PoolString<> str() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        // Copy assignment so we don't need to store the pool
-        PoolString<> result(value_);
-        result = "Token(";
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        PoolString<> result(*pool_, "Token(");
         result += type_as_c_str();
         result += ", ";
-        result += value_;
+        result += value_c_str();
         result += ")";
-        Log.verbose(F("%s: result %s\n"), PRINT_FUNC, result.c_str());
+        KTY_LOG_VERBOSE(F("%s: result %s\n"), PRINT_FUNC, result.c_str());
         return result;
     }
 
@@ -158,16 +475,20 @@ public:
         @return The string representation of the type of the token.
     */
     char const * type_as_c_str() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         static const char lookup[][14] = {
             "CREATE_NUM",
+            "CREATE_CONST",
             "CREATE_LED",
             "CREATE_GROUP",
             "RUN_GROUP",
+            "SPAWN",
+            "EVERY",
             "MOVE_BY_FOR",
             "MOVE_BY",
             "SET_TO_FOR",
             "SET_TO",
+            "FADE_TO",
             "PRINT",
             "WAIT",
             "NAME",
@@ -197,7 +518,7 @@ public:
             "CMD_END",
             "UNKNOWN_TOKEN",
         };
-        Log.verbose(F("%s: %s\n"), PRINT_FUNC, lookup[static_cast<int>(type_)]);
+        KTY_LOG_VERBOSE(F("%s: %s\n"), PRINT_FUNC, lookup[static_cast<int>(type_)]);
         return lookup[static_cast<int>(type_)];
     }
 
@@ -208,47 +529,7 @@ public:
                 If the token is not an operator, 0 is returned.
     */
     int precedence_level() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        static const int lookup[] = {
-            0, // CREATE_NUM
-            0, // CREATE_LED
-            0, // CREATE_GROUP,
-            0, // RUN_GROUP,
-            0, // MOVE_BY_FOR,
-            0, // MOVE_BY,
-            0, // SET_TO_FOR,
-            0, // SET_TO,
-            0, // PRINT,
-            0, // WAIT,
-            0, // NAME,
-            0, // NUM_VAL,
-            0, // STRING,
-            0, // IF,
-            0, // ELSE,
-            0, // OP_PAREN,
-            0, // CL_PAREN,
-            0, // COMMA,
-            2, // EQUALS,
-            2, // L_EQUALS,
-            2, // G_EQUALS,
-            2, // LESS,
-            2, // GREATER,
-            3, // MATH_ADD,
-            3, // MATH_SUB,
-            4, // MATH_MUL,
-            4, // MATH_DIV,
-            4, // MATH_MOD,
-            5, // MATH_POW,
-            6, // UNARY_NEG,
-            1, // LOGI_AND,
-            1, // LOGI_OR,
-            1, // LOGI_XOR,
-            6, // LOGI_NOT,
-            0, // CMD_END,
-            0, // UNKNOWN_TOKEN,
-        };
-        Log.verbose(F("%s: %d\n"), PRINT_FUNC, lookup[static_cast<int>(type_)]);
-        return lookup[static_cast<int>(type_)];
+        return tokenTypeInfo[type_].precedence;
     }
 
     /*! 
@@ -258,47 +539,17 @@ public:
                 If this token is not a function, returns 0.
     */
     int num_function_arguments() const {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        static const int lookup[] = {
-            1, // CREATE_NUM
-            2, // CREATE_LED
-            0, // CREATE_GROUP,
-            1, // RUN_GROUP,
-            2, // MOVE_BY_FOR,
-            1, // MOVE_BY,
-            2, // SET_TO_FOR,
-            1, // SET_TO,
-            0, // PRINT,
-            1, // WAIT,
-            0, // NAME,
-            0, // NUM_VAL,
-            0, // STRING,
-            1, // IF,
-            0, // ELSE,
-            0, // OP_PAREN,
-            0, // CL_PAREN,
-            0, // COMMA,
-            0, // EQUALS,
-            0, // L_EQUALS,
-            0, // G_EQUALS,
-            0, // LESS,
-            0, // GREATER,
-            0, // MATH_ADD,
-            0, // MATH_SUB,
-            0, // MATH_MUL,
-            0, // MATH_DIV,
-            0, // MATH_MOD,
-            0, // MATH_POW,
-            0, // UNARY_NEG,
-            0, // LOGI_AND,
-            0, // LOGI_OR,
-            0, // LOGI_XOR,
-            0, // LOGI_NOT,
-            0, // CMD_END,
-            0, // UNKNOWN_TOKEN,
-        };
-        Log.verbose(F("%s: %d\n"), PRINT_FUNC, lookup[static_cast<int>(type_)]);
-        return lookup[static_cast<int>(type_)];
+        return tokenTypeInfo[type_].numArguments;
+    }
+
+    /*!
+        @brief  Gets the function working out the result of this operator.
+
+        @return The kernel of this operator.
+                If this token is not an operator, nullptr is returned.
+    */
+    OperatorKernel * operator_kernel() const {
+        return tokenTypeInfo[type_].kernel;
     }
 
     /*!
@@ -334,6 +585,15 @@ public:
         return type_ == TokenType::CREATE_NUM;
     }
 
+    /*!
+        @brief  Checks if this is a CREATE_CONST token.
+
+        @return True if this is a CREATE_CONST token, false otherwise.
+    */
+    bool is_create_const() const {
+        return type_ == TokenType::CREATE_CONST;
+    }
+
     /*!
         @brief  Checks if this is a CREATE_LED token.
 
@@ -361,6 +621,24 @@ public:
         return type_ == TokenType::RUN_GROUP;
     }
 
+    /*!
+        @brief  Checks if this is a SPAWN token.
+
+        @return True if this is a SPAWN token, false otherwise.
+    */
+    bool is_spawn() const {
+        return type_ == TokenType::SPAWN;
+    }
+
+    /*!
+        @brief  Checks if this is an EVERY token.
+
+        @return True if this is an EVERY token, false otherwise.
+    */
+    bool is_every() const {
+        return type_ == TokenType::EVERY;
+    }
+
     /*!
         @brief  Checks if this is a MOVE_BY_FOR token.
 
@@ -397,6 +675,15 @@ public:
         return type_ == TokenType::SET_TO;
     }
 
+    /*!
+        @brief  Checks if this is a FADE_TO token.
+
+        @return True if this is a FADE_TO token, false otherwise.
+    */
+    bool is_fade_to() const {
+        return type_ == TokenType::FADE_TO;
+    }
+
     /*!
         @brief  Checks if this is a PRINT token.
 
@@ -655,7 +942,7 @@ public:
         @return True if this token is a create command, false otherwise.
     */
     bool is_create_command() const {
-        return is_create_num() || is_create_led() || is_create_group();
+        return is_create_num() || is_create_const() || is_create_led() || is_create_group();
     }
 
     /*!
@@ -700,7 +987,7 @@ public:
         @return True if this token is a unary operator, false otherwise.
     */
     bool is_unary_operator() const {
-        return is_unary_neg() || is_logi_not();
+        return tokenTypeInfo[type_].numOperands == 1;
     }
 
     /*!
@@ -709,9 +996,7 @@ public:
         @return True if this token is a binary operator, false otherwise.
     */
     bool is_binary_operator() const {
-        return is_equals() || is_l_equals() || is_g_equals() || is_less() || is_greater() ||
-               is_math_add() || is_math_sub() || is_math_mul() || is_math_div() || is_math_mod() || is_math_pow() ||
-               is_logi_and() || is_logi_or() || is_logi_xor();
+        return tokenTypeInfo[type_].numOperands == 2;
     }
 
     /*!
@@ -720,7 +1005,7 @@ public:
         @return True if this token is an operator, false otherwise.
     */
     bool is_operator() const {
-        return is_unary_operator() || is_binary_operator();
+        return tokenTypeInfo[type_].numOperands != 0;
     }
 
     /*!
@@ -729,7 +1014,7 @@ public:
         @return True if this token is a left associative operator, false otherwise.
     */
     bool is_left_associative() const {
-        return is_operator() && !is_math_pow();
+        return is_operator() && tokenTypeInfo[type_].isLeftAssociative;
     }
 
     /*!
@@ -738,14 +1023,239 @@ public:
         @return True if this token is a function, false otherwise.
     */
     bool is_function() const {
-        return is_create_command() || is_run_group() || 
-               is_move_by_command() || is_set_to_command() ||
+        return is_create_command() || is_run_group() || is_spawn() || is_every() ||
+               is_move_by_command() || is_set_to_command() || is_fade_to() ||
                is_print() || is_wait() || is_conditional_command();
     }
 
 private:
+    /*!
+        @brief  Stores a copy of a value in a string of its own.
+                Names are interned instead, sharing the string of any equal
+                name.
+
+        @param  value
+                The value to store.
+    */
+    void copy_value(char const * value) {
+        // Empty values do not need a string at all
+        if (value[0] == '\0') {
+            return;
+        }
+        if (type_ == TokenType::NAME) {
+            poolIdx_ = pool_->intern(value);
+            offset_ = 0;
+            return;
+        }
+        poolIdx_ = pool_->allocate_idx();
+        offset_ = 0;
+        if (poolIdx_ >= 0) {
+            pool_->strcpy(poolIdx_, value);
+        }
+    }
+
+    /*!
+        @brief  Lets go of the string holding the value, if any.
+    */
+    void release_value() {
+        // Deques assign into zeroed memory, which has no pool
+        if (pool_ != nullptr && poolIdx_ >= 0) {
+            pool_->deallocate_idx(poolIdx_);
+            poolIdx_ = -1;
+        }
+    }
+
     TokenType type_;
-    PoolString<> value_;
+    /** The string pool holding the value */
+    Pool * pool_;
+    /** The index of the string holding the value, or -1 if the value is empty */
+    int poolIdx_;
+    /** Where the value starts within the string */
+    unsigned char offset_;
+
+};
+
+/** A command word, and the type of token it becomes */
+struct CommandWord {
+    /** The command word */
+    char word[11];
+    /** The type of token, unknown for command words which are not supported yet */
+    TokenType type;
+};
+
+/** All command words, sorted so that words which start the same are next to
+    each other, and a word comes before the longer words it starts */
+constexpr CommandWord commandWords[] = {
+    {"Else", TokenType::ELSE},
+    {"ElseIf", TokenType::UNKNOWN_TOKEN},
+    {"Every", TokenType::EVERY},
+    {"FadeTo", TokenType::FADE_TO},
+    {"If", TokenType::IF},
+    {"IsConstant", TokenType::CREATE_CONST},
+    {"IsGroup", TokenType::CREATE_GROUP},
+    {"IsLED", TokenType::CREATE_LED},
+    {"IsNumber", TokenType::CREATE_NUM},
+    {"IsServo", TokenType::UNKNOWN_TOKEN},
+    {"MoveBy", TokenType::MOVE_BY},
+    {"MoveByFor", TokenType::MOVE_BY_FOR},
+    {"Print", TokenType::PRINT},
+    {"RunGroup", TokenType::RUN_GROUP},
+    {"SetTo", TokenType::SET_TO},
+    {"SetToFor", TokenType::SET_TO_FOR},
+    {"Spawn", TokenType::SPAWN},
+    {"Wait", TokenType::WAIT},
+};
+
+/** The number of command words */
+constexpr int numCommandWords = sizeof(commandWords) / sizeof(commandWords[0]);
+
+/*!
+    @brief  Checks if one string comes strictly before another.
+
+    @param  a
+            The first string.
+
+    @param  b
+            The second string.
+
+    @return True if a comes before b, false otherwise.
+*/
+constexpr bool str_less(char const * a, char const * b) {
+    return *a != *b ? *a < *b : (*a != '\0' && str_less(a + 1, b + 1));
+}
+
+/*!
+    @brief  Checks if the command words from an index onwards are sorted.
+
+    @param  idx
+            The index to start from.
+
+    @return True if they are sorted, false otherwise.
+*/
+constexpr bool command_words_sorted(int idx) {
+    return idx + 1 >= numCommandWords ||
+           (str_less(commandWords[idx].word, commandWords[idx + 1].word) && command_words_sorted(idx + 1));
+}
+
+static_assert(command_words_sorted(0), "commandWords must be kept sorted for CommandWordMatcher");
+
+/*!
+    @brief  Class that recognises command words one character at a time.
+            The command words are sorted, so the ones which start with the
+            characters fed so far are always next to each other, like the
+            children of a node in a trie. Each character only narrows that
+            range down by binary search, so the cost per character barely
+            grows with the number of command words.
+            The longest command word the characters start with is remembered,
+            so a word can be recognised even if more letters follow it.
+*/
+class CommandWordMatcher {
+
+public:
+    /*!
+        @brief  Constructor for the command word matcher.
+    */
+    CommandWordMatcher() {
+        reset();
+    }
+
+    /*!
+        @brief  Starts recognising a new word.
+    */
+    void reset() {
+        low_ = 0;
+        high_ = numCommandWords;
+        len_ = 0;
+        matchIdx_ = -1;
+    }
+
+    /*!
+        @brief  Takes the next character of the word.
+
+        @param  c
+                The next character.
+
+        @return True if some command word still starts with all the
+                characters fed, false otherwise.
+    */
+    bool feed(char const & c) {
+        // Finds the first and one past the last command word in range
+        // with c at this position
+        int low = low_;
+        int high = high_;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (commandWords[mid].word[len_] < c) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        high = high_;
+        int end = low;
+        while (end < high) {
+            int mid = (end + high) / 2;
+            if (commandWords[mid].word[len_] <= c) {
+                end = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        low_ = low;
+        high_ = end;
+        // Past the end of every command word, so nothing can match any more
+        if (len_ < (int)sizeof(commandWords[0].word) - 1) {
+            ++len_;
+        }
+        else {
+            low_ = high_;
+        }
+        if (low_ < high_ && commandWords[low_].word[len_] == '\0') {
+            matchIdx_ = low_;
+        }
+        return low_ < high_;
+    }
+
+    /*!
+        @brief  Checks if the characters fed start with a command word.
+
+        @return True if there is a command word, false otherwise.
+    */
+    bool has_match() const {
+        return matchIdx_ != -1;
+    }
+
+    /*!
+        @brief  Gets the length of the longest command word the characters
+                fed start with.
+
+        @return The length of the command word, or 0 if there is none.
+    */
+    int match_len() const {
+        return matchIdx_ == -1 ? 0 : ::strlen(commandWords[matchIdx_].word);
+    }
+
+    /*!
+        @brief  Gets the type of token of the longest command word the
+                characters fed start with.
+
+        @return The type of token, or the unknown token type if there is none.
+    */
+    TokenType match_type() const {
+        return matchIdx_ == -1 ? TokenType::UNKNOWN_TOKEN : commandWords[matchIdx_].type;
+    }
+
+private:
+    /** The first command word which starts with the characters fed */
+    int low_;
+    /** One past the last command word which starts with the characters fed */
+    int high_;
+    /** The number of characters fed */
+    int len_;
+    /** The longest command word the characters fed start with, or -1 */
+    int matchIdx_;
 
 };
 
@@ -760,40 +1270,20 @@ private:
             the unknown token type is returned.
 */
 TokenType command_str_to_token_type(char const * str) {
-    Log.verbose(F("%s\n"), PRINT_FUNC);
-    TokenType tokenType = TokenType::UNKNOWN_TOKEN;
+    KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
     if (::strlen(str) == 0) {
-        Log.warning(F("%s: empty string\n"), PRINT_FUNC);
+        KTY_LOG_WARNING(F("%s: empty string\n"), PRINT_FUNC);
         return TokenType::UNKNOWN_TOKEN;
     }
-    static const char lookup[][10] = {
-        "IsNumber",
-        "IsLED",
-        "IsGroup",
-        "RunGroup",
-        "MoveByFor",
-        "MoveBy",
-        "SetToFor",
-        "SetTo",
-        "Print",
-        "Wait",
-        "",
-        "",
-        "",
-        "If",
-        "Else",
-    };
-    static const int numTypes = sizeof(lookup) / sizeof(lookup[0]);
-    for (int i = 0; i < numTypes; ++i) {
-        if (::strcmp(str, lookup[i]) == 0) {
-            Log.verbose(F("%s: %d\n"), PRINT_FUNC, static_cast<TokenType>(i));
-            tokenType = static_cast<TokenType>(i);
-        }
-    }
-    if (tokenType == TokenType::UNKNOWN_TOKEN) {
-        Log.warning(F("%s: unknown command string %s\n"), PRINT_FUNC, str);
+    CommandWordMatcher matcher;
+    int len = 0;
+    for ( ; str[len] != '\0' && matcher.feed(str[len]); ++len);
+    if (str[len] != '\0' || matcher.match_len() != len) {
+        KTY_LOG_WARNING(F("%s: unknown command string %s\n"), PRINT_FUNC, str);
+        return TokenType::UNKNOWN_TOKEN;
     }
-    return tokenType;
+    KTY_LOG_VERBOSE(F("%s: %d\n"), PRINT_FUNC, matcher.match_type());
+    return matcher.match_type();
 }
 
 /*!
@@ -807,42 +1297,8 @@ TokenType command_str_to_token_type(char const * str) {
             the unknown token type is returned.
 */
 TokenType command_str_to_token_type(PoolString<> const & str) {
-    Log.verbose(F("%s\n"), PRINT_FUNC);
+    KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
     return command_str_to_token_type(str.c_str());
-
-    TokenType tokenType = TokenType::UNKNOWN_TOKEN;
-    if (str.strlen() == 0) {
-        Log.warning(F("%s: empty string\n"), PRINT_FUNC);
-        return TokenType::UNKNOWN_TOKEN;
-    }
-    static const char lookup[][10] = {
-        "IsNumber",
-        "IsLED",
-        "IsGroup",
-        "RunGroup",
-        "MoveByFor",
-        "MoveBy",
-        "SetToFor",
-        "SetTo",
-        "Print",
-        "Wait",
-        "",
-        "",
-        "",
-        "If",
-        "Else",
-    };
-    static const int numTypes = sizeof(lookup) / sizeof(lookup[0]);
-    for (int i = 0; i < numTypes; ++i) {
-        if (str == lookup[i]) {
-            Log.verbose(F("%s: %d\n"), PRINT_FUNC, static_cast<TokenType>(i));
-            tokenType = static_cast<TokenType>(i);
-        }
-    }
-    if (tokenType == TokenType::UNKNOWN_TOKEN) {
-        Log.warning(F("%s: unknown command string %s\n"), PRINT_FUNC, str.c_str());
-    }
-    return tokenType;
 }
 
 /*!
@@ -856,7 +1312,7 @@ TokenType command_str_to_token_type(PoolString<> const & str) {
             the unknown token type is returned.
 */
 TokenType punctuation_char_to_token_type(char const & ch) {
-    Log.verbose(F("%s\n"), PRINT_FUNC);
+    KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
     switch (ch) {
     case '(':
         return TokenType::OP_PAREN;
@@ -891,7 +1347,7 @@ TokenType punctuation_char_to_token_type(char const & ch) {
     case '~':
         return TokenType::LOGI_NOT;
     };
-    Log.warning(F("%s: unknown token %c\n"), PRINT_FUNC, ch);
+    KTY_LOG_WARNING(F("%s: unknown token %c\n"), PRINT_FUNC, ch);
     return TokenType::UNKNOWN_TOKEN;
 }
 
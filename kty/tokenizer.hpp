@@ -4,6 +4,8 @@
 #include <kty/containers/deque.hpp>
 #include <kty/containers/string.hpp>
 #include <kty/containers/stringpool.hpp>
+#include <kty/runtime.hpp>
+#include <kty/sizes.hpp>
 #include <kty/string_utils.hpp>
 #include <kty/token.hpp>
 #include <kty/types.hpp>
@@ -13,7 +15,7 @@ namespace kty {
 /*!
     @brief  Class that tokenizes commands.
 */
-template <typename GetAllocFunc = decltype(get_alloc), typename GetPoolFunc = decltype(get_stringpool), typename Token = Token<>, typename PoolString = PoolString<>>
+template <typename Runtime = Runtime<>, typename Token = Token<>, typename PoolString = PoolString<>>
 class Tokenizer {
 
 public:
@@ -21,37 +23,46 @@ public:
     /*!
         @brief  Constructor for tokenizer.
 
-        @param  getAllocFunc
-                A function that returns a allocator pointer when called.
-
-        @param  getPoolFunc
-                A function that returns a pointer to a string pool when called.
+        @param  runtime
+                The runtime to allocate from.
+                If not provided, the globals returned by get_alloc and
+                get_stringpool are used.
     */
-    Tokenizer(GetAllocFunc & getAllocFunc = get_alloc, GetPoolFunc & getPoolFunc = get_stringpool) 
-        : getAllocFunc_(&getAllocFunc), getPoolFunc_(&getPoolFunc), command_(getPoolFunc),
-          validPunctuation_(get_stringpool, "(),=<>+-*/%^&|!~") {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+    explicit Tokenizer(Runtime const & runtime = Runtime()) 
+        : runtime_(runtime), command_(runtime.stringpool()),
+          validPunctuation_(runtime.stringpool(), "(),=<>+-*/%^&|!~"),
+          streamTokens_(runtime.alloc()) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        streamValuesIdx_ = -1;
+        reset_stream();
     }
 
     /*!
         @brief  Constructor for tokenizer that takes in command to tokenize.
 
-        @param  getAllocFunc
-                A function that returns a allocator pointer when called.
-
-        @param  getPoolFunc
-                A function that returns a pointer to a string pool when called.
+        @param  runtime
+                The runtime to allocate from.
 
         @param  command
                 The command to tokenize.
     */
-    Tokenizer(GetAllocFunc & getAllocFunc, GetPoolFunc & getPoolFunc, PoolString const & command) 
-        : getAllocFunc_(&getAllocFunc), getPoolFunc_(&getPoolFunc), command_(getPoolFunc),
-          validPunctuation_(getPoolFunc, "(),=<>+-*/%^&|!~") {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+    Tokenizer(Runtime const & runtime, PoolString const & command) 
+        : runtime_(runtime), command_(runtime.stringpool()),
+          validPunctuation_(runtime.stringpool(), "(),=<>+-*/%^&|!~"),
+          streamTokens_(runtime.alloc()) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        streamValuesIdx_ = -1;
+        reset_stream();
         set_command(command);
     }
 
+    /*!
+        @brief  Destructor for tokenizer.
+    */
+    ~Tokenizer() {
+        release_stream_values();
+    }
+
     /*!
         @brief  Sets the command to be tokenized.
 
@@ -59,12 +70,9 @@ public:
                 The command to tokenize.
     */
     void set_command(PoolString const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        command_ = command;
-        //remove_str_whitespace(command_);
-        remove_str_multiple_whitespace(command_);
-        add_missing_optional_arguments();
-        tokenStartIdx_ = 0;
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        // Only copy the contents, so the command stays in our runtime
+        command_ = command.c_str();
     }
 
     /*!
@@ -73,19 +81,8 @@ public:
         @return The tokenized command.
     */
     Deque<Token> tokenize() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        Deque<Token> tokens(*getAllocFunc_);
-        tokens.clear();
-        Token token(TokenType::UNKNOWN_TOKEN, *getPoolFunc_);
-        do {
-            token = get_next_token();
-            Log.verbose(F("%s: next token is %s\n"), PRINT_FUNC, token.str().c_str());
-            if (!token.is_unknown_token()) {
-                tokens.push_back(token);
-            }
-        } while (!token.is_cmd_end());
-        process_math_tokens(tokens);
-        return tokens;
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return tokenize(command_.c_str());
     }
 
     /*!
@@ -97,9 +94,192 @@ public:
         @return The tokenized command.
     */
     Deque<Token> tokenize(PoolString const & command) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        set_command(command);
-        return tokenize();
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        return tokenize(command.c_str());
+    }
+
+    /*!
+        @brief  Tokenizes the given command in a single pass, the same way as
+                feeding it in streaming mode.
+                Any command being tokenized in streaming mode is thrown away.
+
+        @param  command
+                The command to tokenize.
+
+        @return The tokenized command.
+    */
+    Deque<Token> tokenize(char const * command) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        reset_stream();
+        feed(command);
+        return finish();
+    }
+
+    /*!
+        @brief  Tokenizes the given command, and finds where each of its
+                names ends, so that they can be told apart from the rest of
+                the command, such as strings and comments.
+
+        @param  command
+                The command to tokenize.
+
+        @param  nameEnds
+                Where the index just past each name in the command is added,
+                in the order of the names.
+
+        @return The tokenized command.
+    */
+    Deque<Token> tokenize(char const * command, Deque<int> & nameEnds) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        reset_stream();
+        int i = 0;
+        for ( ; command[i] != '\0'; ++i) {
+            int numTokens = streamTokens_.size();
+            feed(command[i]);
+            // A name is finished by the character after it
+            add_name_end(numTokens, i, nameEnds);
+        }
+        int numTokens = streamTokens_.size();
+        while (streamState_ != StreamState::IN_NOTHING) {
+            end_stream_token();
+        }
+        add_name_end(numTokens, i, nameEnds);
+        return finish();
+    }
+
+    /*!
+        @brief  Tokenizes part of a command in streaming mode, as it arrives.
+                Tokens are put together as soon as the characters which end
+                them have been fed, so that only the last token is left when
+                the command is complete.
+                Whitespace is reduced the same way as by
+                remove_str_multiple_whitespace, anything from a ';' on is left
+                out as a comment, and missing optional arguments are added
+                when the bracket closing the arguments of a function arrives.
+
+        @param  c
+                The next character of the command.
+    */
+    void feed(char const & c) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (streamIsComment_) {
+            return;
+        }
+        switch (streamState_) {
+        case StreamState::IN_STRING:
+            if (c == streamQuote_) {
+                end_stream_token();
+            }
+            // Whitespace in strings is reduced to a single ' '
+            else if (!isspace(c)) {
+                append_stream_char(c);
+            }
+            else if (streamTokenLen_ == 0 || streamToken_[streamTokenLen_ - 1] != ' ') {
+                append_stream_char(' ');
+            }
+            return;
+        case StreamState::IN_COMMAND:
+            if (isalpha(c)) {
+                append_stream_char(c);
+                streamCommandWord_.feed(c);
+                return;
+            }
+            break;
+        case StreamState::IN_NAME:
+            if (islower(c) || c == '_') {
+                append_stream_char(c);
+                return;
+            }
+            break;
+        case StreamState::IN_NUMBER:
+            if (isdigit(c)) {
+                append_stream_char(c);
+                return;
+            }
+            break;
+        case StreamState::IN_NOTHING:
+            break;
+        }
+        // Ending a command word can leave the start of another token behind
+        while (streamState_ != StreamState::IN_NOTHING) {
+            end_stream_token();
+        }
+        if (c == ';') {
+            streamIsComment_ = true;
+        }
+        else if (isspace(c)) {
+            return;
+        }
+        else if (isupper(c)) {
+            // Command words are recognised as their letters arrive
+            start_stream_token(StreamState::IN_COMMAND, c);
+            streamCommandWord_.reset();
+            streamCommandWord_.feed(c);
+        }
+        else if (islower(c) || c == '_') {
+            start_stream_token(StreamState::IN_NAME, c);
+        }
+        else if (isdigit(c)) {
+            start_stream_token(StreamState::IN_NUMBER, c);
+        }
+        else if (c == '"' || c == '\'') {
+            streamQuote_ = c;
+            streamState_ = StreamState::IN_STRING;
+            streamTokenLen_ = 0;
+        }
+        else if (validPunctuation_.find(c) != -1) {
+            feed_punctuation(c);
+        }
+        else {
+            KTY_LOG_WARNING(F("%s: unknown token %c\n"), PRINT_FUNC, c);
+        }
+    }
+
+    /*!
+        @brief  Tokenizes part of a command in streaming mode, as it arrives.
+
+        @param  chunk
+                The next characters of the command.
+    */
+    void feed(char const * chunk) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        for ( ; *chunk != '\0'; ++chunk) {
+            feed(*chunk);
+        }
+    }
+
+    /*!
+        @brief  Ends the command being tokenized in streaming mode,
+                and gets ready for the next one.
+
+        @return The tokenized command.
+    */
+    Deque<Token> finish() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        while (streamState_ != StreamState::IN_NOTHING) {
+            end_stream_token();
+        }
+        Deque<Token> tokens(runtime_.alloc());
+        tokens.swap(streamTokens_);
+        tokens.push_back(Token(TokenType::CMD_END, runtime_.stringpool()));
+        process_math_tokens(tokens);
+        reset_stream();
+        return tokens;
+    }
+
+    /*!
+        @brief  Throws away the command being tokenized in streaming mode.
+    */
+    void reset_stream() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        streamTokens_.clear();
+        release_stream_values();
+        streamState_ = StreamState::IN_NOTHING;
+        streamTokenLen_ = 0;
+        streamQuote_ = '"';
+        streamIsComment_ = false;
+        streamParenDepth_ = 0;
+        streamCallDepth_ = -1;
     }
 
     /*!
@@ -110,7 +290,7 @@ public:
                 The tokenized command.
     */
     void process_math_tokens(Deque<Token> & tokens) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
         // Compresses '<' + '=' into '<=' and '>' + '=' into '>='
         typename Deque<Token>::Iterator iter = tokens.begin();
         while (iter != tokens.end()) {
@@ -118,12 +298,12 @@ public:
             ++next;
             if (next != tokens.end()) {
                 if (iter->is_less() && next->is_equals()) {
-                    Log.verbose(F("%s: compressing into <=\n"), PRINT_FUNC);
+                    KTY_LOG_VERBOSE(F("%s: compressing into <=\n"), PRINT_FUNC);
                     iter->set_type(TokenType::L_EQUALS);
                     next = tokens.erase(next);
                 }
                 else if (iter->is_greater() && next->is_equals()) {
-                    Log.verbose(F("%s: compressing into >=\n"), PRINT_FUNC);
+                    KTY_LOG_VERBOSE(F("%s: compressing into >=\n"), PRINT_FUNC);
                     iter->set_type(TokenType::G_EQUALS);
                     next = tokens.erase(next);
                 }
@@ -139,7 +319,7 @@ public:
                 if (iter == tokens.begin() ||
                     prev->is_operator() ||
                     prev->is_op_paren()) {
-                    Log.verbose(F("%s: changing to unary -\n"), PRINT_FUNC);
+                    KTY_LOG_VERBOSE(F("%s: changing to unary -\n"), PRINT_FUNC);
                     iter->set_type(TokenType::UNARY_NEG);
                 }
             }
@@ -147,236 +327,313 @@ public:
     }
 
     /*!
-        @brief  Gets the next token from command stored in the tokenizer.
+        @brief  Gets the missing arguments, if any, for a function.
+
+        @param  tokenType
+                The type of the function
+
+        @param  numArguments
+                The number of arguments to the function supplied by the user.
 
-        @return The next token from the stored command.
+        @return The remaining missing arguments, if any.
     */
-    Token get_next_token() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        while (tokenStartIdx_ < command_.strlen() && isspace(command_[tokenStartIdx_])) {
-            ++tokenStartIdx_;
-        }
-        // No more tokens
-        if (tokenStartIdx_ >= command_.strlen()) {
-            return Token(TokenType::CMD_END, *getPoolFunc_);
-        }
-        // Next token is command word
-        if (isupper(command_[tokenStartIdx_])) {
-            return get_next_command_token();
-        }
-        // Next token is name
-        else if (islower(command_[tokenStartIdx_]) || command_[tokenStartIdx_] == '_') {
-            return get_next_name_token();
-        }
-        // Next token is number
-        else if (isdigit(command_[tokenStartIdx_])) {
-            return get_next_number_token();
-        }
-        // Next token is string
-        else if (command_[tokenStartIdx_] == '"') {
-            return get_next_string_token('"');
-        }
-        else if (command_[tokenStartIdx_] == '\'') {
-            return get_next_string_token('\'');
-        }
-        // Next token is punctuation
-        else if (validPunctuation_.find(command_[tokenStartIdx_]) != -1) {
-            return get_next_punctuation_token();            
+    PoolString get_additional_arguments(TokenType tokenType, int const & numArguments) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        PoolString arguments(runtime_.stringpool());
+        switch (tokenType) {
+        case TokenType::CREATE_NUM:
+        case TokenType::CREATE_CONST:
+            if (numArguments < 1) {
+                arguments += "0";
+            }
+            break;
+        case TokenType::CREATE_LED:
+            if (numArguments < 1) {
+                arguments += "13";
+            }
+            if (numArguments < 2) {
+                arguments += ",50";
+            }
+            break;
+        case TokenType::RUN_GROUP:
+            if (numArguments < 1) {
+                arguments += "1";
+            }
+            break;
+        case TokenType::FADE_TO:
+            if (numArguments < 1) {
+                arguments += "0";
+            }
+            if (numArguments < 2) {
+                arguments += ",0";
+            }
+            if (numArguments < 3) {
+                arguments += ",0";
+            }
+            break;
+        // Every other function, Spawn and Every included, has no optional arguments
+        default:
+            break;
         }
-        ++tokenStartIdx_;
-        Log.warning(F("%s: unknown token %c\n"), PRINT_FUNC, command_[tokenStartIdx_ - 1]);
-        return Token(TokenType::UNKNOWN_TOKEN, *getPoolFunc_);
+        return arguments;
     }
 
+private:
+    /** The kinds of token which can be partly fed in streaming mode */
+    enum StreamState {
+        IN_NOTHING = 0,
+        IN_COMMAND,
+        IN_NAME,
+        IN_NUMBER,
+        IN_STRING,
+    };
+
     /*!
-        @brief  Gets the next command token from the stored command.
+        @brief  Adds where a name ends, if one of the tokens finished since
+                the given number of tokens is a name.
+
+        @param  numTokens
+                The number of tokens before the last character was fed.
 
-        @return The next command token.
-                If the next token is not a command, an unknown token is returned.
+        @param  end
+                The index just past the last character fed.
+
+        @param  nameEnds
+                Where to add the end of the name.
     */
-    Token get_next_command_token() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        Token token(TokenType::UNKNOWN_TOKEN, *getPoolFunc_);
-        for (int i = 0; i < commandLookupSize_; ++i) {
-            if (command_.find(get_command_lookup()[i], tokenStartIdx_) == tokenStartIdx_) {
-                tokenStartIdx_ += ::strlen(get_command_lookup()[i]);
-                token.set_type(command_str_to_token_type(get_command_lookup()[i]));
-                return token;
+    void add_name_end(int const & numTokens, int const & end, Deque<int> & nameEnds) {
+        typename Deque<Token>::Iterator it = streamTokens_.end();
+        for (int i = streamTokens_.size(); i > numTokens; --i) {
+            --it;
+            if (it->is_name()) {
+                nameEnds.push_back(end);
             }
         }
-        Log.warning(F("%s: not a valid command\n"), PRINT_FUNC);
-        // Not a valid command,
-        // Skip forward until the end of this word
-        for (++tokenStartIdx_; tokenStartIdx_ < command_.strlen() && islower(command_[tokenStartIdx_]); ++tokenStartIdx_);
-        return token;
     }
 
     /*!
-        @brief  Gets the next name token from the stored command.
+        @brief  Starts putting together a token in streaming mode.
+
+        @param  state
+                The kind of token.
 
-        @return The next name token.
-                If the next token is not a name, an unknown token is returned.
+        @param  c
+                The first character of the token.
     */
-    Token get_next_name_token() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        int currIdx = tokenStartIdx_;
-        while (currIdx < command_.strlen() && (islower(command_[currIdx]) || command_[currIdx] == '_')) {
-            ++currIdx;
-        }
-        Token result(TokenType::NAME, command_.substr_ii(tokenStartIdx_, currIdx));
-        tokenStartIdx_ = currIdx;
-        return result;
+    void start_stream_token(StreamState const & state, char const & c) {
+        streamState_ = state;
+        streamTokenLen_ = 0;
+        append_stream_char(c);
     }
 
     /*!
-        @brief  Gets the next number token from the stored command.
+        @brief  Adds a character to the token being put together in streaming
+                mode. Characters past the maximum length of a string are dropped.
 
-        @return The next number token.
-                If the next token is not a number, an unknown token is returned.
+        @param  c
+                The character to add.
     */
-    Token get_next_number_token() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        int currIdx = tokenStartIdx_;
-        while (currIdx < command_.strlen() && isdigit(command_[currIdx])) {
-            ++currIdx;
-        }
-        Token result(TokenType::NUM_VAL, command_.substr_ii(tokenStartIdx_, currIdx));
-        tokenStartIdx_ = currIdx;
-        return result;
+    void append_stream_char(char const & c) {
+        if (streamTokenLen_ < Sizes::string_length - 1) {
+            streamToken_[streamTokenLen_++] = c;
+        }
     }
 
     /*!
-        @brief  Gets the next string token from the stored command.
-
-        @param  open
-                The opening character to the string.
-                The closing character must match the opening character.
-
-        @return The next string token.
-                If the next token is not a string, an unknown token is returned.
+        @brief  Finishes the token being put together in streaming mode.
+                A command word which runs straight into other letters only
+                takes the command it starts with, and the letters after it
+                are fed again.
     */
-    Token get_next_string_token(char const & open) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        int endIdx = command_.find(open, tokenStartIdx_ + 1);
-        // Only take substr of the string, without quotes
-        Token result(TokenType::STRING, command_.substr_ii(tokenStartIdx_ + 1, endIdx));
-        tokenStartIdx_ = endIdx + 1;
-        return result;
+    void end_stream_token() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        StreamState state = streamState_;
+        streamState_ = StreamState::IN_NOTHING;
+        streamToken_[streamTokenLen_] = '\0';
+        switch (state) {
+        case StreamState::IN_COMMAND:
+            end_stream_command();
+            break;
+        case StreamState::IN_NAME:
+            push_stream_token(make_stream_value_token(TokenType::NAME));
+            break;
+        case StreamState::IN_NUMBER:
+            push_stream_token(make_stream_value_token(TokenType::NUM_VAL));
+            break;
+        case StreamState::IN_STRING:
+            push_stream_token(make_stream_value_token(TokenType::STRING));
+            break;
+        case StreamState::IN_NOTHING:
+            break;
+        }
     }
 
     /*!
-        @brief  Gets the next punctuation token from the stored command.
-
-        @return The next punctuation token.
-                If the next token is not punctuation, an unknown token is returned.
+        @brief  Makes a token whose value is the token put together in
+                streaming mode.
+                The values of the tokens of a command are packed one after the
+                other into shared strings, which the tokens refer to instead of
+                each getting a string of their own.
+                Names are interned instead, so that they can be compared by
+                their symbol alone from here on.
+
+        @param  type
+                The type of token.
+
+        @return The token.
     */
-    Token get_next_punctuation_token() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        Token result(punctuation_char_to_token_type(command_[tokenStartIdx_]), *getPoolFunc_);
-        ++tokenStartIdx_;
-        return result;    
+    Token make_stream_value_token(TokenType const & type) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (type == TokenType::NAME) {
+            return Token(type, runtime_.stringpool(), streamToken_);
+        }
+        // The next shared string is started once the current one is full
+        if (streamValuesIdx_ < 0 ||
+            streamValuesLen_ + streamTokenLen_ >= runtime_.stringpool().max_str_len() + 1) {
+            release_stream_values();
+            streamValuesIdx_ = runtime_.stringpool().allocate_idx();
+            streamValuesLen_ = 0;
+            if (streamValuesIdx_ < 0) {
+                return Token(type, runtime_.stringpool(), streamToken_);
+            }
+        }
+        ::memcpy(runtime_.stringpool().c_str(streamValuesIdx_) + streamValuesLen_, streamToken_, streamTokenLen_ + 1);
+        Token token(type, runtime_.stringpool(), streamValuesIdx_, streamValuesLen_);
+        streamValuesLen_ += streamTokenLen_ + 1;
+        return token;
     }
 
     /*!
-        @brief  Gets the missing arguments, if any, for a function.
-
-        @param  tokenType
-                The type of the function
-
-        @param  numArguments
-                The number of arguments to the function supplied by the user.
+        @brief  Lets go of the shared string holding the values of tokens,
+                which stays alive for as long as those tokens need it.
+    */
+    void release_stream_values() {
+        if (streamValuesIdx_ >= 0) {
+            runtime_.stringpool().deallocate_idx(streamValuesIdx_);
+            streamValuesIdx_ = -1;
+        }
+    }
 
-        @return The remaining missing arguments, if any.
+    /*!
+        @brief  Finishes a command word in streaming mode.
     */
-    PoolString get_additional_arguments(TokenType tokenType, int const & numArguments) {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        PoolString arguments(*getPoolFunc_);
-        switch (tokenType) {
-        case TokenType::CREATE_NUM:
-            if (numArguments < 1) {
-                arguments += "0";
-            }
-            break;
-        case TokenType::CREATE_LED:
-            if (numArguments < 1) {
-                arguments += "13";
-            }
-            if (numArguments < 2) {
-                arguments += ",50";
-            }
-            break;
-        case TokenType::RUN_GROUP:
-            if (numArguments < 1) {
-                arguments += "1";
+    void end_stream_command() {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        char word[Sizes::string_length];
+        ::strcpy(word, streamToken_);
+        int restIdx = streamCommandWord_.match_len();
+        if (restIdx > 0) {
+            // Command words which are not supported yet are left out
+            TokenType tokenType = streamCommandWord_.match_type();
+            if (tokenType != TokenType::UNKNOWN_TOKEN) {
+                push_stream_token(Token(tokenType, runtime_.stringpool()));
             }
-            break;
         }
-        return arguments;
+        else {
+            KTY_LOG_WARNING(F("%s: not a valid command\n"), PRINT_FUNC);
+            // Skip forward until the end of this word
+            for (++restIdx; islower(word[restIdx]); ++restIdx);
+        }
+        for (int i = restIdx; word[i] != '\0'; ++i) {
+            feed(word[i]);
+        }
     }
 
     /*!
-        @brief  Adds the missing arguments, if any, for the functions present in the command.
+        @brief  Tokenizes a punctuation character in streaming mode.
+                The missing optional arguments of a function are added just
+                before the bracket which closes its arguments.
+
+        @param  c
+                The punctuation character.
     */
-    void add_missing_optional_arguments() {
-        Log.verbose(F("%s\n"), PRINT_FUNC);
-        for (int i = 0; i < commandLookupSize_; ++i) {
-            int idx = command_.find(get_command_lookup()[i]);
-            if (idx == -1) {
-                continue;
-            }
-            int opParenIdx = command_.find("(", idx + ::strlen(get_command_lookup()[i]));
-            int clParenIdx = command_.find(')', opParenIdx);
-            int numArguments = 0;
-            // At least one argument between them
-            if (clParenIdx > opParenIdx + 1) {
-                numArguments = command_.count(',', opParenIdx, clParenIdx) + 1;
+    void feed_punctuation(char const & c) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (c == ')' && streamCallDepth_ > 0 && streamParenDepth_ == streamCallDepth_) {
+            TokenType tokenType = streamCallType_;
+            int numArguments = streamCallHasArgument_ ? streamCallNumCommas_ + 1 : 0;
+            streamCallDepth_ = -1;
+            if (numArguments < tokenTypeInfo[tokenType].numArguments) {
+                feed(get_additional_arguments(tokenType, numArguments).c_str());
+                while (streamState_ != StreamState::IN_NOTHING) {
+                    end_stream_token();
+                }
             }
-            // Need to fill up arguments
-            TokenType tokenType = command_str_to_token_type(get_command_lookup()[i]);
-            int requiredArguments = Token(tokenType, *getPoolFunc_).num_function_arguments();
-            if (numArguments < requiredArguments) {
-                PoolString additionalArguments(get_additional_arguments(tokenType, numArguments));
-                command_.insert(additionalArguments.c_str(), clParenIdx);
+        }
+        if (c == ',' && streamParenDepth_ == streamCallDepth_) {
+            ++streamCallNumCommas_;
+        }
+        push_stream_token(Token(punctuation_char_to_token_type(c), runtime_.stringpool()));
+        if (c == '(') {
+            ++streamParenDepth_;
+            // The arguments of the last function start here
+            if (streamCallDepth_ == 0) {
+                streamCallDepth_ = streamParenDepth_;
             }
         }
+        else if (c == ')') {
+            --streamParenDepth_;
+        }
     }
 
     /*!
-        @brief  Get a 2D array containing all command words.
+        @brief  Adds a finished token to the command tokenized in streaming mode,
+                keeping track of the arguments given to the last function.
 
-        @return A pointer to a 2D character array containing all 
-                command words.
+        @param  token
+                The finished token.
     */
-    char const (*get_command_lookup(void) const)[10] {
-    //char const *[10] get_command_lookup() const {
-        static const char commandLookup[][10] = {
-            "IsNumber",
-            "IsLED",
-            "IsServo",
-            "IsGroup",
-            "RunGroup",
-            "MoveByFor",
-            "MoveBy",
-            "SetToFor",
-            "SetTo",
-            "Print",
-            "Wait",
-            "If",
-            "ElseIf",
-            "Else",
-        };
-        return commandLookup;
+    void push_stream_token(Token const & token) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        if (streamCallDepth_ == 0 && !token.is_op_paren()) {
+            streamCallDepth_ = -1;
+        }
+        else if (streamCallDepth_ > 0 && streamParenDepth_ >= streamCallDepth_ && !token.is_comma()) {
+            streamCallHasArgument_ = true;
+        }
+        streamTokens_.push_back(token);
+        if (token.is_function()) {
+            streamCallType_ = token.get_type();
+            streamCallDepth_ = 0;
+            streamCallNumCommas_ = 0;
+            streamCallHasArgument_ = false;
+        }
     }
 
-private:
-    GetAllocFunc * getAllocFunc_;
-    GetPoolFunc * getPoolFunc_;
+    Runtime runtime_;
 
     PoolString command_;
-    int tokenStartIdx_ = 0;
-
-    const int commandLookupSize_ = 14;
     PoolString validPunctuation_;
+
+    /** The tokens finished so far in streaming mode */
+    Deque<Token> streamTokens_;
+    /** The kind of token being put together in streaming mode */
+    StreamState streamState_;
+    /** The characters of the token being put together in streaming mode */
+    char streamToken_[Sizes::string_length];
+    /** The number of characters of the token being put together */
+    int streamTokenLen_;
+    /** The character which opened the string being put together */
+    char streamQuote_;
+    /** Whether the rest of the command is a comment */
+    bool streamIsComment_;
+    /** Recognises the command word being put together */
+    CommandWordMatcher streamCommandWord_;
+    /** The shared string holding the values of the latest tokens, or -1 */
+    int streamValuesIdx_;
+    /** The number of characters used in the shared string */
+    int streamValuesLen_;
+    /** The number of brackets open */
+    int streamParenDepth_;
+    /** The last function, whose missing arguments may need adding */
+    TokenType streamCallType_;
+    /** The bracket depth of the arguments of the last function,
+        0 before its '(' arrives, or -1 if there is none */
+    int streamCallDepth_;
+    /** The number of commas between the arguments of the last function */
+    int streamCallNumCommas_;
+    /** Whether the last function has been given any arguments */
+    bool streamCallHasArgument_;
 };
 
 } // namespace kty
@@ -15,3 +15,57 @@
 #include <cstdint>
 
 #endif
+
+/** Log levels, in the same order as the ones used by ArduinoLog. */
+#define KTY_LOG_LEVEL_SILENT  0
+#define KTY_LOG_LEVEL_FATAL   1
+#define KTY_LOG_LEVEL_ERROR   2
+#define KTY_LOG_LEVEL_WARNING 3
+#define KTY_LOG_LEVEL_NOTICE  4
+#define KTY_LOG_LEVEL_TRACE   5
+#define KTY_LOG_LEVEL_VERBOSE 6
+
+/**
+    The minimum log level compiled into the program.
+    Logging calls below this level expand to nothing, so their arguments are
+    never evaluated. Define this before including any kty header to change it.
+*/
+#if !defined(KTY_LOG_LEVEL)
+#define KTY_LOG_LEVEL KTY_LOG_LEVEL_VERBOSE
+#endif
+
+#if KTY_LOG_LEVEL >= KTY_LOG_LEVEL_FATAL
+#define KTY_LOG_FATAL(...) Log.fatal(__VA_ARGS__)
+#else
+#define KTY_LOG_FATAL(...) do {} while (0)
+#endif
+
+#if KTY_LOG_LEVEL >= KTY_LOG_LEVEL_ERROR
+#define KTY_LOG_ERROR(...) Log.error(__VA_ARGS__)
+#else
+#define KTY_LOG_ERROR(...) do {} while (0)
+#endif
+
+#if KTY_LOG_LEVEL >= KTY_LOG_LEVEL_WARNING
+#define KTY_LOG_WARNING(...) Log.warning(__VA_ARGS__)
+#else
+#define KTY_LOG_WARNING(...) do {} while (0)
+#endif
+
+#if KTY_LOG_LEVEL >= KTY_LOG_LEVEL_NOTICE
+#define KTY_LOG_NOTICE(...) Log.notice(__VA_ARGS__)
+#else
+#define KTY_LOG_NOTICE(...) do {} while (0)
+#endif
+
+#if KTY_LOG_LEVEL >= KTY_LOG_LEVEL_TRACE
+#define KTY_LOG_TRACE(...) Log.trace(__VA_ARGS__)
+#else
+#define KTY_LOG_TRACE(...) do {} while (0)
+#endif
+
+#if KTY_LOG_LEVEL >= KTY_LOG_LEVEL_VERBOSE
+#define KTY_LOG_VERBOSE(...) Log.verbose(__VA_ARGS__)
+#else
+#define KTY_LOG_VERBOSE(...) do {} while (0)
+#endif
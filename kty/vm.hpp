@@ -0,0 +1,507 @@
+#pragma once
+
+#include <kty/containers/deque.hpp>
+#include <kty/sizes.hpp>
+#include <kty/string_utils.hpp>
+#include <kty/token.hpp>
+#include <kty/types.hpp>
+
+/*!
+    Whether the VM can dispatch its instructions with computed gotos, jumping
+    straight from the end of one instruction to the code of the next.
+    Needs the labels as values extension of GCC and Clang. AVR builds use a
+    plain switch instead, which is smaller and works with any compiler.
+*/
+#if !defined(KTY_VM_THREADED)
+#if defined(__GNUC__) && !defined(ARDUINO)
+#define KTY_VM_THREADED 1
+#else
+#define KTY_VM_THREADED 0
+#endif
+#endif
+
+namespace kty {
+
+/*!
+    @brief  The instructions of the VM.
+            The last few are superinstructions, which do the work of a common
+            sequence of instructions in a single dispatch.
+*/
+enum Opcode {
+    OP_PUSH_NUM = 0, OP_PUSH_NAME, OP_PUSH_TOKEN,
+    OP_EQUALS, OP_L_EQUALS, OP_G_EQUALS, OP_LESS, OP_GREATER,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_POW,
+    OP_NEG,
+    OP_AND, OP_OR, OP_XOR, OP_NOT,
+    OP_MOD_NUM,         // PUSH_NUM n, MOD
+    OP_MOD_IS_ZERO,     // MOD, PUSH_NUM 0, EQUALS
+    OP_MOD_NUM_IS_ZERO, // PUSH_NUM n, MOD, PUSH_NUM 0, EQUALS
+    OP_HALT,
+};
+
+static_assert(OP_NOT - OP_EQUALS == LOGI_NOT - EQUALS, "Operator opcodes must follow the order of their token types");
+
+/*!
+    @brief  A single instruction of the VM.
+*/
+template <typename Token = Token<>>
+struct Instruction {
+    /** What the instruction does */
+    unsigned char opcode;
+    /** The number pushed by OP_PUSH_NUM */
+    int value;
+    /** The token pushed by OP_PUSH_NAME and OP_PUSH_TOKEN */
+    Token const * token;
+};
+
+/*!
+    @brief  Class that holds a postfix expression compiled to instructions.
+            Numbers are converted once, when compiling, and operators become
+            one instruction each, so running the program never has to go
+            back to the text of the tokens.
+            Operators whose operands are all numbers, such as those left
+            behind by constants, are worked out as they are compiled, and
+            common sequences of instructions, such as the divisibility tests
+            in `If (num % 3 = 0)`, are fused into superinstructions.
+            The program refers to the tokens it was compiled from, which must
+            outlive it.
+*/
+template <typename Token = Token<>>
+class Program {
+
+public:
+    /*!
+        @brief  Constructor for an empty program.
+    */
+    Program() {
+        clear();
+    }
+
+    /*!
+        @brief  Empties the program.
+    */
+    void clear() {
+        size_ = 0;
+        maxDepth_ = 0;
+        code_[0] = Instruction<Token>{OP_HALT, 0, nullptr};
+    }
+
+    /*!
+        @brief  Compiles a postfix expression, replacing the program.
+                Tokens which are neither operands nor operators, such as
+                strings, are pushed as they are.
+
+        @param  tokenQueue
+                The postfix expression to compile.
+
+        @param  isOptimized
+                Whether to work out operators on numbers straight away, and
+                fuse common sequences into superinstructions.
+
+        @return True if successful, false if the expression is too long or
+                an operator is missing operands, in which case the program
+                is empty.
+    */
+    bool compile(Deque<Token> const & tokenQueue, bool const & isOptimized = true) {
+        KTY_LOG_VERBOSE(F("%s\n"), PRINT_FUNC);
+        clear();
+        int depth = 0;
+        for (typename Deque<Token>::ConstIterator it = tokenQueue.begin(); it != tokenQueue.end(); ++it) {
+            Token const & token = *it;
+            if (size_ == Sizes::program_size) {
+                KTY_LOG_WARNING(F("%s: Expression is too long\n"), PRINT_FUNC);
+                clear();
+                return false;
+            }
+            Instruction<Token> & instruction = code_[size_++];
+            instruction = Instruction<Token>{OP_PUSH_TOKEN, 0, &token};
+            if (token.is_operator()) {
+                int numOperands = token.is_binary_operator() ? 2 : 1;
+                if (depth < numOperands) {
+                    KTY_LOG_WARNING(F("%s: Operator is missing operands\n"), PRINT_FUNC);
+                    clear();
+                    return false;
+                }
+                instruction.opcode = OP_EQUALS + (token.get_type() - TokenType::EQUALS);
+                depth -= numOperands - 1;
+                if (isOptimized && !fold()) {
+                    fuse();
+                }
+                continue;
+            }
+            if (token.is_num_val()) {
+                instruction.opcode = OP_PUSH_NUM;
+                instruction.value = str_to_int(token.value_c_str());
+            }
+            else if (token.is_name()) {
+                instruction.opcode = OP_PUSH_NAME;
+            }
+            if (++depth > maxDepth_) {
+                maxDepth_ = depth;
+            }
+        }
+        code_[size_] = Instruction<Token>{OP_HALT, 0, nullptr};
+        return true;
+    }
+
+    /*!
+        @brief  Gets the number of instructions, not counting the final OP_HALT.
+
+        @return The number of instructions.
+    */
+    int size() const {
+        return size_;
+    }
+
+    /*!
+        @brief  Gets the largest number of values on the stack while the
+                program runs.
+
+        @return The largest stack depth.
+    */
+    int max_depth() const {
+        return maxDepth_;
+    }
+
+    /*!
+        @brief  Gets an instruction.
+
+        @param  idx
+                The index of the instruction, up to and including size(),
+                which is always OP_HALT.
+
+        @return The instruction.
+    */
+    Instruction<Token> const & operator[](int const & idx) const {
+        return code_[idx];
+    }
+
+private:
+    /*!
+        @brief  Works out the operator compiled last straight away if all its
+                operands are numbers, leaving its result as a single number.
+
+        @return True if the operator was worked out, false otherwise.
+    */
+    bool fold() {
+        Instruction<Token> const & op = code_[size_ - 1];
+        int numOperands = op.token->is_binary_operator() ? 2 : 1;
+        Instruction<Token> & lhs = code_[size_ - 1 - numOperands];
+        Instruction<Token> const & rhs = code_[size_ - 2];
+        if (lhs.opcode != OP_PUSH_NUM || rhs.opcode != OP_PUSH_NUM) {
+            return false;
+        }
+        // Dividing by 0 is left to fail when it runs, as it would unfolded
+        if ((op.opcode == OP_DIV || op.opcode == OP_MOD) && rhs.value == 0) {
+            return false;
+        }
+        OperatorKernel * kernel = tokenTypeInfo[op.token->get_type()].kernel;
+        lhs.value = kernel(numOperands == 2 ? lhs.value : 0, rhs.value);
+        size_ -= numOperands;
+        return true;
+    }
+
+    /*!
+        @brief  Fuses the last instructions compiled into a superinstruction,
+                for as long as they match a known sequence.
+    */
+    void fuse() {
+        while (size_ >= 2) {
+            Instruction<Token> & prev = code_[size_ - 2];
+            unsigned char opcode = code_[size_ - 1].opcode;
+            // x % n, leaving n % 0 to fail as it would unfused
+            if (opcode == OP_MOD && prev.opcode == OP_PUSH_NUM && prev.value != 0) {
+                prev.opcode = OP_MOD_NUM;
+            }
+            // x = 0 is the same as ~x
+            else if (opcode == OP_EQUALS && prev.opcode == OP_PUSH_NUM && prev.value == 0) {
+                prev.opcode = OP_NOT;
+            }
+            else if (opcode == OP_NOT && prev.opcode == OP_MOD) {
+                prev.opcode = OP_MOD_IS_ZERO;
+            }
+            else if (opcode == OP_NOT && prev.opcode == OP_MOD_NUM) {
+                prev.opcode = OP_MOD_NUM_IS_ZERO;
+            }
+            else {
+                return;
+            }
+            --size_;
+        }
+    }
+
+    /** The instructions, ending with OP_HALT */
+    Instruction<Token> code_[Sizes::program_size + 1];
+    /** The number of instructions, not counting the final OP_HALT */
+    int size_;
+    /** The largest stack depth */
+    int maxDepth_;
+
+};
+
+/*!
+    @brief  Class that runs compiled programs on a stack of integers.
+            On desktop builds the instructions are dispatched with computed
+            gotos by default, which saves the bounds check and the shared
+            indirect jump of a switch, and gives the branch predictor one
+            jump per instruction to learn from.
+*/
+template <typename Token = Token<>>
+class Vm {
+
+public:
+    /*!
+        @brief  A single value on the stack.
+                Tokens pushed as they are keep the token, and have no number.
+    */
+    struct Value {
+        /** The number */
+        int number;
+        /** The token pushed as it is, or nullptr for a number */
+        Token const * token;
+    };
+
+    /*!
+        @brief  Constructor for the VM.
+    */
+    Vm() {
+        isThreaded_ = KTY_VM_THREADED;
+    }
+
+    /*!
+        @brief  Chooses how instructions are dispatched.
+                Only has an effect in builds where KTY_VM_THREADED is set.
+
+        @param  isThreaded
+                True to dispatch with computed gotos, false to use a switch.
+    */
+    void set_threaded(bool const & isThreaded) {
+        isThreaded_ = isThreaded && KTY_VM_THREADED;
+    }
+
+    /*!
+        @brief  Checks how instructions are dispatched.
+
+        @return True if computed gotos are used, false if a switch is used.
+    */
+    bool is_threaded() const {
+        return isThreaded_;
+    }
+
+    /*!
+        @brief  Runs a program.
+
+        @param  program
+                The program to run.
+
+        @param  context
+                Gives the values of names, through get_token_value(token).
+
+        @param  stack
+                The stack to run the program on, with room for at least
+                program.max_depth() values.
+
+        @return The number of values left on the stack.
+    */
+    template <typename Context>
+    int run(Program<Token> const & program, Context & context, Value * stack) const {
+#if KTY_VM_THREADED
+        if (isThreaded_) {
+            return run_threaded(program, context, stack);
+        }
+#endif
+        return run_switch(program, context, stack);
+    }
+
+private:
+    /*!
+        @brief  Runs a program, dispatching with a switch.
+
+        @param  program
+                The program to run.
+
+        @param  context
+                Gives the values of names.
+
+        @param  stack
+                The stack to run the program on.
+
+        @return The number of values left on the stack.
+    */
+    template <typename Context>
+    static int run_switch(Program<Token> const & program, Context & context, Value * stack) {
+        Instruction<Token> const * ip = &program[0];
+        Value * sp = stack;
+        while (true) {
+            switch (ip->opcode) {
+                case OP_PUSH_NUM:        push_num(ip, sp); break;
+                case OP_PUSH_NAME:       push_name(ip, sp, context); break;
+                case OP_PUSH_TOKEN:      push_token(ip, sp); break;
+                case OP_EQUALS:          binary<op_equals>(sp); break;
+                case OP_L_EQUALS:        binary<op_l_equals>(sp); break;
+                case OP_G_EQUALS:        binary<op_g_equals>(sp); break;
+                case OP_LESS:            binary<op_less>(sp); break;
+                case OP_GREATER:         binary<op_greater>(sp); break;
+                case OP_ADD:             binary<op_math_add>(sp); break;
+                case OP_SUB:             binary<op_math_sub>(sp); break;
+                case OP_MUL:             binary<op_math_mul>(sp); break;
+                case OP_DIV:             binary<op_math_div>(sp); break;
+                case OP_MOD:             binary<op_math_mod>(sp); break;
+                case OP_POW:             binary<op_math_pow>(sp); break;
+                case OP_NEG:             unary<op_unary_neg>(sp); break;
+                case OP_AND:             binary<op_logi_and>(sp); break;
+                case OP_OR:              binary<op_logi_or>(sp); break;
+                case OP_XOR:             binary<op_logi_xor>(sp); break;
+                case OP_NOT:             unary<op_logi_not>(sp); break;
+                case OP_MOD_NUM:         mod_num(ip, sp); break;
+                case OP_MOD_IS_ZERO:     mod_is_zero(sp); break;
+                case OP_MOD_NUM_IS_ZERO: mod_num_is_zero(ip, sp); break;
+                default:                 return sp - stack;
+            }
+            ++ip;
+        }
+    }
+
+#if KTY_VM_THREADED
+    /*!
+        @brief  Runs a program, dispatching with computed gotos.
+
+        @param  program
+                The program to run.
+
+        @param  context
+                Gives the values of names.
+
+        @param  stack
+                The stack to run the program on.
+
+        @return The number of values left on the stack.
+    */
+    template <typename Context>
+    static int run_threaded(Program<Token> const & program, Context & context, Value * stack) {
+        // In the order of the opcodes
+        static void * const labels[] = {
+            &&push_num, &&push_name, &&push_token,
+            &&equals, &&l_equals, &&g_equals, &&less, &&greater,
+            &&add, &&sub, &&mul, &&div, &&mod, &&pow,
+            &&neg,
+            &&logi_and, &&logi_or, &&logi_xor, &&logi_not,
+            &&mod_num, &&mod_is_zero, &&mod_num_is_zero,
+            &&halt,
+        };
+        static_assert(sizeof(labels) / sizeof(labels[0]) == OP_HALT + 1, "Every opcode needs a label");
+
+        Instruction<Token> const * ip = &program[0];
+        Value * sp = stack;
+        goto *labels[ip->opcode];
+
+        #define KTY_VM_NEXT() goto *labels[(++ip)->opcode]
+        push_num:        push_num(ip, sp); KTY_VM_NEXT();
+        push_name:       push_name(ip, sp, context); KTY_VM_NEXT();
+        push_token:      push_token(ip, sp); KTY_VM_NEXT();
+        equals:          binary<op_equals>(sp); KTY_VM_NEXT();
+        l_equals:        binary<op_l_equals>(sp); KTY_VM_NEXT();
+        g_equals:        binary<op_g_equals>(sp); KTY_VM_NEXT();
+        less:            binary<op_less>(sp); KTY_VM_NEXT();
+        greater:         binary<op_greater>(sp); KTY_VM_NEXT();
+        add:             binary<op_math_add>(sp); KTY_VM_NEXT();
+        sub:             binary<op_math_sub>(sp); KTY_VM_NEXT();
+        mul:             binary<op_math_mul>(sp); KTY_VM_NEXT();
+        div:             binary<op_math_div>(sp); KTY_VM_NEXT();
+        mod:             binary<op_math_mod>(sp); KTY_VM_NEXT();
+        pow:             binary<op_math_pow>(sp); KTY_VM_NEXT();
+        neg:             unary<op_unary_neg>(sp); KTY_VM_NEXT();
+        logi_and:        binary<op_logi_and>(sp); KTY_VM_NEXT();
+        logi_or:         binary<op_logi_or>(sp); KTY_VM_NEXT();
+        logi_xor:        binary<op_logi_xor>(sp); KTY_VM_NEXT();
+        logi_not:        unary<op_logi_not>(sp); KTY_VM_NEXT();
+        mod_num:         mod_num(ip, sp); KTY_VM_NEXT();
+        mod_is_zero:     mod_is_zero(sp); KTY_VM_NEXT();
+        mod_num_is_zero: mod_num_is_zero(ip, sp); KTY_VM_NEXT();
+        #undef KTY_VM_NEXT
+        halt:
+        return sp - stack;
+    }
+#endif
+
+    /*!
+        @brief  Pushes the number of an instruction.
+    */
+    static void push_num(Instruction<Token> const * ip, Value * & sp) {
+        sp->number = ip->value;
+        sp->token = nullptr;
+        ++sp;
+    }
+
+    /*!
+        @brief  Pushes the value of the name of an instruction.
+    */
+    template <typename Context>
+    static void push_name(Instruction<Token> const * ip, Value * & sp, Context & context) {
+        sp->number = context.get_token_value(*ip->token);
+        sp->token = nullptr;
+        ++sp;
+    }
+
+    /*!
+        @brief  Pushes the token of an instruction as it is.
+    */
+    static void push_token(Instruction<Token> const * ip, Value * & sp) {
+        sp->number = 0;
+        sp->token = ip->token;
+        ++sp;
+    }
+
+    /*!
+        @brief  Replaces the top two values by the result of a binary operator.
+    */
+    template <OperatorKernel * Kernel>
+    static void binary(Value * & sp) {
+        --sp;
+        sp[-1].number = Kernel(sp[-1].number, sp[0].number);
+        sp[-1].token = nullptr;
+    }
+
+    /*!
+        @brief  Replaces the top value by the result of a unary operator.
+    */
+    template <OperatorKernel * Kernel>
+    static void unary(Value * & sp) {
+        sp[-1].number = Kernel(0, sp[-1].number);
+        sp[-1].token = nullptr;
+    }
+
+    /*!
+        @brief  Replaces the top value by its remainder after dividing by the
+                number of an instruction.
+    */
+    static void mod_num(Instruction<Token> const * ip, Value * & sp) {
+        sp[-1].number %= ip->value;
+        sp[-1].token = nullptr;
+    }
+
+    /*!
+        @brief  Replaces the top two values by whether the second divides
+                by the first.
+    */
+    static void mod_is_zero(Value * & sp) {
+        --sp;
+        sp[-1].number = sp[-1].number % sp[0].number == 0;
+        sp[-1].token = nullptr;
+    }
+
+    /*!
+        @brief  Replaces the top value by whether it divides by the number
+                of an instruction.
+    */
+    static void mod_num_is_zero(Instruction<Token> const * ip, Value * & sp) {
+        sp[-1].number = sp[-1].number % ip->value == 0;
+        sp[-1].token = nullptr;
+    }
+
+    /** Whether instructions are dispatched with computed gotos */
+    bool isThreaded_;
+
+};
+
+} // namespace kty
@@ -1,3 +1,7 @@
+// Verbose, trace and notice logging is compiled out of the sketch.
+// Raise this as well when changing the log level passed to begin_logging().
+#define KTY_LOG_LEVEL KTY_LOG_LEVEL_WARNING
+
 #include <kitty.hpp>
 #include <ArduinoLog.h>
 
@@ -7,6 +11,7 @@
 #include <kty/analyzer.hpp>
 #include <kty/interface.hpp>
 #include <kty/interpreter.hpp>
+#include <kty/tokenizer.hpp>
 
 using namespace kty;
 
@@ -18,6 +23,7 @@ GetStringPoolInit<> getStringPoolInit(stringPool);
 Analyzer<>          analyzer;
 Interface<>         interface;
 Interpreter<>       interpreter;
+Tokenizer<>         tokenizer;
 
 AnalysisResult      analysisResult;
 PoolString<>        command;
@@ -30,18 +36,38 @@ void setup() {
     //interface.begin_logging(LOG_LEVEL_TRACE);
     //interface.begin_logging(LOG_LEVEL_SILENT);
 
+    // Hand control back to loop() regularly, so that input is read even
+    // while a group runs forever
+    interpreter.set_command_budget(Sizes::command_budget);
+
     alloc.dump_addresses();
     stringPool.dump_addresses();
-}
 
-void loop() {
     prefix = interpreter.get_prompt_prefix();
     interface.print_prompt(prefix);
-    command = interface.get_next_command();
+}
+
+void loop() {
+    // Ctrl-C stops everything that is running
+    if (interface.read_abort()) {
+        interpreter.abort();
+        tokenizer.reset_stream();
+        Serial.println(F("^C"));
+        prefix = interpreter.get_prompt_prefix();
+        interface.print_prompt(prefix);
+    }
+    // Parked and unfinished commands continue while no command is being typed
+    interpreter.update();
+    // Commands are tokenized while they are being typed
+    if (!interface.get_next_command(command, tokenizer)) {
+        return;
+    }
+    Deque<Token<>> tokens = tokenizer.finish();
     interface.echo_command(command);
     analysisResult = analyzer.analyze(command);
     if (analysisResult != AnalysisResult::ERROR) {
-        interpreter.execute(command);
+        interpreter.execute(command, tokens);
     }
     prefix = interpreter.get_prompt_prefix();
+    interface.print_prompt(prefix);
 }
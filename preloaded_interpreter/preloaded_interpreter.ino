@@ -1,38 +1,13 @@
 /*!
-    Fill in commands here.
+    The script to run at startup, precompiled from script.kitty into an image
+    which is loaded without tokenizing it.
+    Remake it after changing script.kitty with `make preloaded_image`.
 */
-const char COMMAND_BUFFER[] PROGMEM = R"(
-check_div IsGroup (
-    If (num % div = 0) (
-        can_div IsNumber(1)
-    )
-    div MoveBy(1)
-)
+#include "script_image.h"
 
-check_prime IsGroup (
-    can_div IsNumber(0)
-    div IsNumber(2)
-    If (div < num) (
-        check_div RunGroup(num / 2)
-    )
-    If (can_div) (
-        Print(num, ' is not prime')
-    )
-    Else (
-        Print(num, ' is prime')
-    )
-)
-
-loop_nums IsGroup (
-    check_prime RunGroup()
-    num MoveBy(1)
-)
-
-num IsNumber(1)
-num_times IsNumber(10)
-
-loop_nums RunGroup(num_times)
-)";
+// Verbose, trace and notice logging is compiled out of the sketch.
+// Raise this as well when changing the log level passed to begin_logging().
+#define KTY_LOG_LEVEL KTY_LOG_LEVEL_WARNING
 
 #include <avr/pgmspace.h>
 
@@ -43,8 +18,10 @@ loop_nums RunGroup(num_times)
 #include <kty/containers/string.hpp>
 #include <kty/containers/stringpool.hpp>
 #include <kty/analyzer.hpp>
+#include <kty/image.hpp>
 #include <kty/interface.hpp>
 #include <kty/interpreter.hpp>
+#include <kty/tokenizer.hpp>
 
 using namespace kty;
 
@@ -56,44 +33,12 @@ GetStringPoolInit<> getStringPoolInit(stringPool);
 Analyzer<>          analyzer;
 Interface<>         interface;
 Interpreter<>       interpreter;
+Tokenizer<>         tokenizer;
 
 AnalysisResult      analysisResult;
 PoolString<>        command;
 PoolString<>        prefix;
 
-/*! 
-    @brief  Reads characters from the buffer until it has a full command, 
-            then saves it in the variable command.
-            Starts reading from the startIdx. 
-    
-    @param  buffer
-            The character buffer to read from.
-
-    @param  startIdx
-            The first index in the buffer to start reading from.
-    
-    @param  command
-            Where to save the full command.
-
-    @return The index to start reading from for the next command.
-*/
-int get_next_command(char const * buffer, int const & startIdx, PoolString<> & command) {
-    command = "";
-    char c;
-    char str_[2] = " "; // To use operator += on command
-    int i = startIdx;
-    for (i = startIdx; ; ++i) {
-        c = pgm_read_byte_near(buffer + i);
-        if (c == '\n') { // Finished reading one line
-            ++i;
-            break;
-        }
-        str_[0] = c;
-        command += str_;
-    }
-    return i;
-}
-
 void setup() {
     interface.print_welcome();
 
@@ -101,25 +46,55 @@ void setup() {
     //interface.begin_logging(LOG_LEVEL_TRACE);
     //interface.begin_logging(LOG_LEVEL_SILENT);
 
-    int startIdx = 0;
-    while (pgm_read_byte_near(COMMAND_BUFFER + startIdx) != '\0') {
+    // Hand control back to loop() regularly, so that input is read even
+    // while a group runs forever
+    interpreter.set_command_budget(Sizes::command_budget);
+
+    // The declarations of the script are loaded straight away,
+    // and only the commands after them are entered
+    ImageReader image(SCRIPT_IMAGE, sizeof(SCRIPT_IMAGE));
+    bool isLoaded = interpreter.load_image(image);
+    if (!isLoaded) {
+        Serial.println(F("Error: script image is out of date or corrupt, remake it with make preloaded_image"));
+    }
+    char buffer[Sizes::string_length + 1];
+    while (isLoaded && !image.is_end()) {
         prefix = interpreter.get_prompt_prefix();
         interface.print_prompt(prefix);
-        startIdx = get_next_command(COMMAND_BUFFER, startIdx, command);
+        image.read_str(buffer, sizeof(buffer));
+        command = buffer;
         interface.echo_command(command);
+        // Each preloaded command runs once the one before it is done
+        while (interpreter.is_busy()) {
+            interpreter.update();
+        }
         interpreter.execute(command);
-        prefix = interpreter.get_prompt_prefix();
     }
+    prefix = interpreter.get_prompt_prefix();
+    interface.print_prompt(prefix);
 }
 
 void loop() {
-    prefix = interpreter.get_prompt_prefix();
-    interface.print_prompt(prefix);
-    command = interface.get_next_command();
+    // Ctrl-C stops everything that is running
+    if (interface.read_abort()) {
+        interpreter.abort();
+        tokenizer.reset_stream();
+        Serial.println(F("^C"));
+        prefix = interpreter.get_prompt_prefix();
+        interface.print_prompt(prefix);
+    }
+    // Parked and unfinished commands continue while no command is being typed
+    interpreter.update();
+    // Commands are tokenized while they are being typed
+    if (!interface.get_next_command(command, tokenizer)) {
+        return;
+    }
+    Deque<Token<>> tokens = tokenizer.finish();
     interface.echo_command(command);
     analysisResult = analyzer.analyze(command);
     if (analysisResult != AnalysisResult::ERROR) {
-        interpreter.execute(command);
+        interpreter.execute(command, tokens);
     }
     prefix = interpreter.get_prompt_prefix();
+    interface.print_prompt(prefix);
 }
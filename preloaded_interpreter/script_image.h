@@ -0,0 +1,36 @@
+// Made from ./preloaded_interpreter/script.kitty by image_exec, do not edit
+const unsigned char SCRIPT_IMAGE[] PROGMEM = {
+    0x4b, 0x54, 0x59, 0x49, 0x01, 0x05, 0x00, 0x63, 0x68, 0x65, 0x63, 0x6b,
+    0x5f, 0x64, 0x69, 0x76, 0x00, 0x63, 0x68, 0x65, 0x63, 0x6b, 0x5f, 0x70,
+    0x72, 0x69, 0x6d, 0x65, 0x00, 0x6c, 0x6f, 0x6f, 0x70, 0x5f, 0x6e, 0x75,
+    0x6d, 0x73, 0x00, 0x6e, 0x75, 0x6d, 0x00, 0x6e, 0x75, 0x6d, 0x5f, 0x74,
+    0x69, 0x6d, 0x65, 0x73, 0x00, 0x00, 0x00, 0x02, 0x00, 0x03, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0x04, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x00, 0x04, 0x00, 0x20, 0x49, 0x66, 0x20, 0x28, 0x6e, 0x75,
+    0x6d, 0x20, 0x25, 0x20, 0x64, 0x69, 0x76, 0x20, 0x3d, 0x20, 0x30, 0x29,
+    0x20, 0x28, 0x00, 0x20, 0x63, 0x61, 0x6e, 0x5f, 0x64, 0x69, 0x76, 0x20,
+    0x49, 0x73, 0x4e, 0x75, 0x6d, 0x62, 0x65, 0x72, 0x28, 0x31, 0x29, 0x00,
+    0x20, 0x29, 0x00, 0x20, 0x64, 0x69, 0x76, 0x20, 0x4d, 0x6f, 0x76, 0x65,
+    0x42, 0x79, 0x28, 0x31, 0x29, 0x00, 0x01, 0x00, 0x0b, 0x00, 0x20, 0x63,
+    0x61, 0x6e, 0x5f, 0x64, 0x69, 0x76, 0x20, 0x49, 0x73, 0x4e, 0x75, 0x6d,
+    0x62, 0x65, 0x72, 0x28, 0x30, 0x29, 0x00, 0x20, 0x64, 0x69, 0x76, 0x20,
+    0x49, 0x73, 0x4e, 0x75, 0x6d, 0x62, 0x65, 0x72, 0x28, 0x32, 0x29, 0x00,
+    0x20, 0x49, 0x66, 0x20, 0x28, 0x64, 0x69, 0x76, 0x20, 0x3c, 0x20, 0x6e,
+    0x75, 0x6d, 0x29, 0x20, 0x28, 0x00, 0x20, 0x63, 0x68, 0x65, 0x63, 0x6b,
+    0x5f, 0x64, 0x69, 0x76, 0x20, 0x52, 0x75, 0x6e, 0x47, 0x72, 0x6f, 0x75,
+    0x70, 0x28, 0x6e, 0x75, 0x6d, 0x20, 0x2f, 0x20, 0x32, 0x29, 0x00, 0x20,
+    0x29, 0x00, 0x20, 0x49, 0x66, 0x20, 0x28, 0x63, 0x61, 0x6e, 0x5f, 0x64,
+    0x69, 0x76, 0x29, 0x20, 0x28, 0x00, 0x20, 0x50, 0x72, 0x69, 0x6e, 0x74,
+    0x28, 0x6e, 0x75, 0x6d, 0x2c, 0x20, 0x27, 0x20, 0x69, 0x73, 0x20, 0x6e,
+    0x6f, 0x74, 0x20, 0x70, 0x72, 0x69, 0x6d, 0x65, 0x27, 0x29, 0x00, 0x20,
+    0x29, 0x00, 0x20, 0x45, 0x6c, 0x73, 0x65, 0x20, 0x28, 0x00, 0x20, 0x50,
+    0x72, 0x69, 0x6e, 0x74, 0x28, 0x6e, 0x75, 0x6d, 0x2c, 0x20, 0x27, 0x20,
+    0x69, 0x73, 0x20, 0x70, 0x72, 0x69, 0x6d, 0x65, 0x27, 0x29, 0x00, 0x20,
+    0x29, 0x00, 0x02, 0x00, 0x02, 0x00, 0x20, 0x63, 0x68, 0x65, 0x63, 0x6b,
+    0x5f, 0x70, 0x72, 0x69, 0x6d, 0x65, 0x20, 0x52, 0x75, 0x6e, 0x47, 0x72,
+    0x6f, 0x75, 0x70, 0x28, 0x29, 0x00, 0x20, 0x6e, 0x75, 0x6d, 0x20, 0x4d,
+    0x6f, 0x76, 0x65, 0x42, 0x79, 0x28, 0x31, 0x29, 0x00, 0x6c, 0x6f, 0x6f,
+    0x70, 0x5f, 0x6e, 0x75, 0x6d, 0x73, 0x20, 0x52, 0x75, 0x6e, 0x47, 0x72,
+    0x6f, 0x75, 0x70, 0x28, 0x6e, 0x75, 0x6d, 0x5f, 0x74, 0x69, 0x6d, 0x65,
+    0x73, 0x29, 0x00,
+};
@@ -38,6 +38,7 @@ test(allocator_available)
     for (int i = 0; i < 10; ++i) {
         assertTrue(addresses.push_back(allocator.allocate()));
         assertEqual(allocator.available(), 10 - 1 - i, "i = " << i);
+        assertEqual(allocator.num_allocate_calls(), i + 1, "i = " << i);
     }
 
     for (int i = 0; i < 10; ++i) {
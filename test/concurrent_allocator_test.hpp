@@ -0,0 +1,125 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+
+#include <kty/containers/allocator.hpp>
+#include <kty/containers/concurrent_allocator.hpp>
+#include <kty/interpreter.hpp>
+#include <kty/runtime.hpp>
+
+using namespace kty;
+
+test(concurrent_allocator_allocate_deallocate)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test concurrent_allocator_allocate_deallocate starting.");
+    const int numInts = 10;
+    ConcurrentAllocator<numInts, sizeof(int)> intAlloc;
+    int * ints[numInts];
+
+    for (int i = 0; i < numInts; ++i) {
+        ints[i] = (int *)(intAlloc.allocate());
+        assertTrue(ints[i] != nullptr, "i = " << i);
+        assertEqual(intAlloc.available(), numInts - 1 - i, "i = " << i);
+        *(ints[i]) = i;
+    }
+    assertTrue(intAlloc.allocate() == nullptr);
+    assertEqual(intAlloc.num_allocate_calls(), numInts + 1);
+
+    for (int i = 0; i < numInts; ++i) {
+        assertEqual(*(ints[i]), i, "i = " << i);
+    }
+
+    assertEqual(intAlloc.inc_ref_count(ints[0]), 2);
+    assertTrue(intAlloc.deallocate(ints[0]));
+    assertEqual(intAlloc.ref_count(ints[0]), 1);
+    assertEqual(intAlloc.available(), 0);
+
+    for (int i = 0; i < numInts; ++i) {
+        assertTrue(intAlloc.deallocate(ints[i]), "i = " << i);
+        assertFalse(intAlloc.deallocate(ints[i]), "i = " << i);
+    }
+    assertFalse(intAlloc.deallocate(ints[0] - 1));
+    assertEqual(intAlloc.available(), numInts);
+
+    // Freed blocks are handed out again
+    int * reused = (int *)(intAlloc.allocate());
+    assertTrue(intAlloc.owns(reused));
+    assertEqual(*reused, 0);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(concurrent_allocator_threads)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test concurrent_allocator_threads starting.");
+    const int numThreads = 4;
+    const int numBlocksHeld = 8;
+    const int numRounds = 2000;
+    static ConcurrentAllocator<numThreads * numBlocksHeld, sizeof(int)> intAlloc;
+    int numCorrupted[numThreads] = {};
+
+    // Every block must only ever be handed to one thread at a time
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&numCorrupted, t]() {
+            int * held[numBlocksHeld];
+            for (int round = 0; round < numRounds; ++round) {
+                for (int i = 0; i < numBlocksHeld; ++i) {
+                    held[i] = (int *)(intAlloc.allocate());
+                    if (held[i] == nullptr) {
+                        ++numCorrupted[t];
+                        continue;
+                    }
+                    *(held[i]) = t;
+                }
+                for (int i = 0; i < numBlocksHeld; ++i) {
+                    if (held[i] != nullptr) {
+                        numCorrupted[t] += *(held[i]) != t;
+                        intAlloc.deallocate(held[i]);
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread & thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < numThreads; ++t) {
+        assertEqual(numCorrupted[t], 0, "t = " << t);
+    }
+    assertEqual(intAlloc.available(), numThreads * numBlocksHeld);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(concurrent_allocator_thread_local)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test concurrent_allocator_thread_local starting.");
+    Allocator<> * otherAlloc = nullptr;
+    StringPool<> * otherStringPool = nullptr;
+    int otherNumber = 0;
+    std::thread other([&]() {
+        otherAlloc = get_thread_alloc();
+        otherStringPool = get_thread_stringpool(nullptr);
+        Interpreter<> interpreter(Runtime<>(get_thread_alloc, get_thread_stringpool));
+        PoolString<> command(get_thread_stringpool, "num IsNumber(7)");
+        interpreter.execute(command);
+        command = "num";
+        otherNumber = interpreter.get_number_value(command);
+    });
+    other.join();
+
+    assertTrue(get_thread_alloc() == get_thread_alloc());
+    assertTrue(get_thread_alloc() != otherAlloc);
+    assertTrue(get_thread_stringpool(nullptr) != otherStringPool);
+    assertEqual(otherNumber, 7);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+
+#include <kty/containers/concurrent_stringpool.hpp>
+#include <kty/containers/string.hpp>
+
+using namespace kty;
+
+test(concurrent_stringpool_allocate_deallocate)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test concurrent_stringpool_allocate_deallocate starting.");
+    const int numStrings = 5;
+    ConcurrentStringPool<numStrings, 4> stringPool;
+    int indices[numStrings];
+
+    for (int i = 0; i < numStrings; ++i) {
+        indices[i] = stringPool.allocate_idx();
+        assertTrue(stringPool.owns(indices[i]), "i = " << i);
+        assertEqual(stringPool.available(), numStrings - 1 - i, "i = " << i);
+    }
+    assertEqual(stringPool.allocate_idx(), -1);
+
+    stringPool.strcpy(indices[0], "abcdef");
+    assertEqual(stringPool.c_str(indices[0]), "abcd");
+    stringPool.strcpy(indices[1], "ab");
+    stringPool.strcat(indices[1], "cdef");
+    assertEqual(stringPool.c_str(indices[1]), "abcd");
+
+    assertEqual(stringPool.inc_ref_count(indices[0]), 2);
+    assertTrue(stringPool.deallocate_idx(indices[0]));
+    assertEqual(stringPool.ref_count(indices[0]), 1);
+    for (int i = 0; i < numStrings; ++i) {
+        assertTrue(stringPool.deallocate_idx(indices[i]), "i = " << i);
+        assertFalse(stringPool.deallocate_idx(indices[i]), "i = " << i);
+    }
+    assertFalse(stringPool.deallocate_idx(-1));
+    assertEqual(stringPool.available(), numStrings);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(concurrent_stringpool_pool_string)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test concurrent_stringpool_pool_string starting.");
+    typedef ConcurrentStringPool<4, 16> SharedPool;
+    static SharedPool stringPool;
+    {
+        PoolString<SharedPool> string(stringPool, "shared");
+        string += " string";
+        assertEqual(string.c_str(), "shared string");
+        assertEqual(stringPool.available(), 3);
+    }
+    assertEqual(stringPool.available(), 4);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(concurrent_stringpool_threads)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test concurrent_stringpool_threads starting.");
+    const int numThreads = 4;
+    const int numRounds = 2000;
+    static ConcurrentStringPool<numThreads * 2, 8> stringPool;
+    int numCorrupted[numThreads] = {};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&numCorrupted, t]() {
+            char str[2] = {char('a' + t), '\0'};
+            for (int round = 0; round < numRounds; ++round) {
+                int idx = stringPool.allocate_idx();
+                if (idx == -1) {
+                    ++numCorrupted[t];
+                    continue;
+                }
+                stringPool.strcpy(idx, str);
+                numCorrupted[t] += ::strcmp(stringPool.c_str(idx), str) != 0;
+                stringPool.deallocate_idx(idx);
+            }
+        });
+    }
+    for (std::thread & thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < numThreads; ++t) {
+        assertEqual(numCorrupted[t], 0, "t = " << t);
+    }
+    assertEqual(stringPool.available(), numThreads * 2);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
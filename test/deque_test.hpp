@@ -150,3 +150,62 @@ test(deque_erase) {
 
     Test::min_verbosity = prevTestVerbosity;
 }
+
+test(deque_empty_does_not_allocate) {
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test deque_empty_does_not_allocate starting.");
+    Allocator<2, Sizes::alloc_block_size> alloc;
+    Deque<int, decltype(alloc)> deque(alloc);
+    assertEqual(alloc.available(), 2);
+    assertEqual(alloc.num_allocate_calls(), 0);
+    assertTrue(deque.begin() == deque.end());
+    assertFalse(deque.pop_back());
+
+    Deque<int, decltype(alloc)> copy(deque);
+    copy = deque;
+    assertEqual(alloc.available(), 2);
+
+    // Head node and one value node
+    assertTrue(deque.push_back(1));
+    assertEqual(alloc.available(), 0);
+    assertTrue(deque.pop_back());
+    assertEqual(alloc.available(), 1);
+    deque.clear();
+    assertEqual(alloc.available(), 2);
+    assertTrue(deque.begin() == deque.end());
+
+    assertTrue(deque.push_front(2));
+    assertEqual(deque.front(), 2);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(deque_swap) {
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test deque_swap starting.");
+    Allocator<4, Sizes::alloc_block_size> alloc;
+    Deque<int, decltype(alloc)> deque(alloc);
+    Deque<int, decltype(alloc)> other(alloc);
+    assertTrue(deque.push_back(1));
+    assertTrue(deque.push_back(2));
+    assertEqual(alloc.available(), 1);
+
+    // Nothing is copied
+    deque.swap(other);
+    assertEqual(alloc.available(), 1);
+    assertEqual(deque.size(), 0);
+    assertTrue(deque.begin() == deque.end());
+    assertEqual(other.size(), 2);
+    assertEqual(other.front(), 1);
+    assertEqual(other.back(), 2);
+
+    other.swap(deque);
+    assertEqual(deque.size(), 2);
+    assertEqual(other.size(), 0);
+    deque.clear();
+    assertEqual(alloc.available(), 4);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
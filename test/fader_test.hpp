@@ -0,0 +1,74 @@
+#pragma once
+
+#include <kty/containers/string.hpp>
+#include <kty/fader.hpp>
+#include <kty/machine_state.hpp>
+
+using namespace kty;
+
+test(fader_fade_duty)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test fader_fade_duty starting.");
+    // Both curves start and end at the same outputs as SetTo
+    assertEqual(Fader<>::fade_duty(0, 100, 0, 1000, FadeCurve::LINEAR), 0);
+    assertEqual(Fader<>::fade_duty(0, 100, 1000, 1000, FadeCurve::LINEAR), 255);
+    assertEqual(Fader<>::fade_duty(0, 100, 0, 1000, FadeCurve::GAMMA), 0);
+    assertEqual(Fader<>::fade_duty(0, 100, 1000, 1000, FadeCurve::GAMMA), 255);
+    assertEqual(Fader<>::fade_duty(80, 20, 1000, 1000, FadeCurve::GAMMA), 51);
+    // Halfway through
+    assertEqual(Fader<>::fade_duty(0, 100, 500, 1000, FadeCurve::LINEAR), 127);
+    assertEqual(Fader<>::fade_duty(100, 0, 500, 1000, FadeCurve::LINEAR), 128);
+    assertEqual(Fader<>::fade_duty(0, 100, 500, 1000, FadeCurve::GAMMA), 63);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(fader_tick)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test fader_tick starting.");
+    Fader<> fader;
+    MachineState<> state;
+    PoolString<> name("light");
+    int allocAvailable = alloc.available();
+    state.set_device(name, DeviceType::LED, -1, 13, 0);
+    allocAvailable = alloc.available();
+
+    assertTrue(fader.is_empty());
+    assertEqual(fader.time_until_next(0), -1);
+    assertTrue(fader.start(name, 0, 100, 160, FadeCurve::LINEAR, 1000));
+    assertFalse(fader.is_empty());
+    assertEqual(fader.time_until_next(1000), (long)Sizes::fade_tick_ms);
+
+    // Nothing changes in between ticks
+    fader.tick(1000 + Sizes::fade_tick_ms - 1, state);
+    assertEqual(state.get_device_info(name, 2), 0);
+    fader.tick(1080, state);
+    assertEqual(state.get_device_info(name, 2), 50);
+    assertEqual(fader.time_until_next(1080), (long)Sizes::fade_tick_ms);
+    // The end of a fade is not held back by the tick
+    fader.tick(1160, state);
+    assertEqual(state.get_device_info(name, 2), 100);
+    assertTrue(fader.is_empty());
+    assertEqual(alloc.available(), allocAvailable);
+
+    // A new fade replaces the old one
+    assertTrue(fader.start(name, 100, 0, 100, FadeCurve::LINEAR, 2000));
+    assertTrue(fader.start(name, 100, 60, 100, FadeCurve::GAMMA, 2000));
+    fader.tick(2100, state);
+    assertEqual(state.get_device_info(name, 2), 60);
+    assertTrue(fader.is_empty());
+
+    // Stopping leaves the LED where it is
+    assertTrue(fader.start(name, 60, 0, 100, FadeCurve::LINEAR, 3000));
+    fader.stop(name);
+    assertTrue(fader.is_empty());
+    fader.tick(3100, state);
+    assertEqual(state.get_device_info(name, 2), 60);
+    assertEqual(alloc.available(), allocAvailable);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <kty/containers/string.hpp>
+#include <kty/image.hpp>
+#include <kty/image_builder.hpp>
+#include <kty/interpreter.hpp>
+
+using namespace kty;
+
+/*!
+    @brief  Keeps the bytes of an image in memory.
+*/
+struct ImageTestSink {
+    unsigned char bytes[1024];
+    int size = 0;
+
+    void write(unsigned char const & byte) {
+        bytes[size++] = byte;
+    }
+};
+
+test(image_reader_writer)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test image_reader_writer starting.");
+    ImageTestSink sink;
+    ImageWriter<ImageTestSink> writer(sink);
+    writer.write_header();
+    writer.write_u8(200);
+    writer.write_u16(60000);
+    writer.write_i32(-100000);
+    writer.write_str("name");
+    assertEqual(sink.size, 5 + 1 + 2 + 4 + 5);
+
+    char buffer[8];
+    ImageReader reader(sink.bytes, sink.size);
+    assertTrue(reader.read_header());
+    assertEqual(reader.read_u8(), 200);
+    assertEqual(reader.read_u16(), 60000U);
+    assertEqual(reader.read_i32(), -100000L);
+    assertEqual(reader.read_str(buffer, 3), 2);
+    assertEqual(buffer, "na");
+    assertTrue(reader.is_end());
+    assertTrue(reader.is_ok());
+
+    // Reading past the end gives 0
+    assertEqual(reader.read_u16(), 0);
+    assertFalse(reader.is_ok());
+
+    // Images of other versions are not read
+    sink.bytes[4] = imageVersion + 1;
+    ImageReader otherVersion(sink.bytes, sink.size);
+    assertFalse(otherVersion.read_header());
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(image_load)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test image_load starting.");
+    interpreter.reset();
+    ImageTestSink sink;
+    {
+        ImageBuilder<> builder;
+        Deque<PoolString<>> commands;
+        commands.push_back(PoolString<>("step IsConstant(3)"));
+        commands.push_back(PoolString<>(""));
+        commands.push_back(PoolString<>("add IsGroup ("));
+        commands.push_back(PoolString<>("    total   MoveBy(step)"));
+        commands.push_back(PoolString<>(")"));
+        commands.push_back(PoolString<>("; Comments are left out"));
+        commands.push_back(PoolString<>("total IsNumber(step * -2)"));
+        commands.push_back(PoolString<>("light IsLED(9, 40)"));
+        commands.push_back(PoolString<>("add RunGroup(2)"));
+        commands.push_back(PoolString<>("later IsNumber(total)"));
+        for (auto & command : commands) {
+            builder.add(command);
+        }
+        builder.write(sink);
+    }
+
+    // Images cut short load nothing
+    ImageReader cutShort(sink.bytes, sink.size / 2);
+    assertFalse(interpreter.load_image(cutShort));
+    assertFalse(interpreter.constant_exists(PoolString<>("step")));
+    assertFalse(interpreter.group_exists(PoolString<>("add")));
+
+    ImageReader image(sink.bytes, sink.size);
+    assertTrue(interpreter.load_image(image));
+    assertEqual(interpreter.get_constant_value(PoolString<>("step")), 3);
+    assertEqual(interpreter.get_number_value(PoolString<>("total")), -6);
+    assertEqual(interpreter.get_device_info(PoolString<>("light"), 1), 9);
+    assertEqual(interpreter.get_device_info(PoolString<>("light"), 2), 40);
+    Deque<PoolString<>> groupCommands = interpreter.get_group_commands(PoolString<>("add"));
+    assertEqual(groupCommands.size(), 1);
+    assertEqual(groupCommands[0].c_str(), " total MoveBy(3)");
+    assertFalse(interpreter.number_exists(PoolString<>("later")));
+
+    // The commands from the first one which is not a declaration on are
+    // left to execute
+    char buffer[Sizes::string_length + 1];
+    int numCommands = 0;
+    while (!image.is_end()) {
+        image.read_str(buffer, sizeof(buffer));
+        interpreter.execute(PoolString<>(buffer));
+        ++numCommands;
+    }
+    assertEqual(numCommands, 2);
+    assertEqual(interpreter.get_number_value(PoolString<>("total")), 0);
+    assertEqual(interpreter.get_number_value(PoolString<>("later")), 0);
+    interpreter.reset();
+
+    Test::min_verbosity = prevTestVerbosity;
+}
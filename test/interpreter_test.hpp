@@ -7,6 +7,28 @@
 
 using namespace kty;
 
+/** Time seen by interpreters using test_clock, moved forward by the tests */
+unsigned long testTimeMs = 0;
+
+/*!
+    @brief  Clock for the interpreter tests, so that waits are not real time.
+
+    @return The current test time in milliseconds.
+*/
+unsigned long test_clock() {
+    return testTimeMs;
+}
+
+/*!
+    @brief  Clock for the interpreter tests which moves forward by 1ms
+            every time it is read, so that time passes while commands run.
+
+    @return The current test time in milliseconds.
+*/
+unsigned long ticking_test_clock() {
+    return testTimeMs++;
+}
+
 test(interpreter_constructor)
 {
     int prevTestVerbosity = Test::min_verbosity;
@@ -60,6 +82,7 @@ test(interpreter_execute_single_command)
     
     Serial.println("Test interpreter_execute_single_command starting.");
     interpreter.reset();
+    interpreter.set_clock(test_clock);
     PoolString<> name;
     PoolString<> command;
 
@@ -81,6 +104,12 @@ test(interpreter_execute_single_command)
     command = "answer MoveByFor(10, 100)";
     interpreter.execute(command);
     assertTrue(interpreter.number_exists(name));
+    assertEqual(interpreter.get_number_value(name), 27);
+    testTimeMs += 99;
+    interpreter.update();
+    assertEqual(interpreter.get_number_value(name), 27);
+    testTimeMs += 1;
+    interpreter.update();
     assertEqual(interpreter.get_number_value(name), 17);
 
     command = "answer SetTo(100)";
@@ -91,8 +120,15 @@ test(interpreter_execute_single_command)
     command = "answer SetToFor(10, 100)";
     interpreter.execute(command);
     assertTrue(interpreter.number_exists(name));
+    assertEqual(interpreter.get_number_value(name), 10);
+    testTimeMs += 100;
+    interpreter.update();
     assertEqual(interpreter.get_number_value(name), 100);
 
+    command = "answer SetTo((1 ! 0) + (1 ! 1) * 10 + 2^3^2 % 10)";
+    interpreter.execute(command);
+    assertEqual(interpreter.get_number_value(name), 3);
+
     command = "answer";
     interpreter.execute(command);
 
@@ -115,6 +151,8 @@ test(interpreter_execute_single_command)
 
     command = "light MoveByFor(25)";
     interpreter.execute(command);
+    testTimeMs += 25;
+    interpreter.update();
     assertTrue(interpreter.device_exists(name));
     assertEqual(interpreter.get_device_type(name), DeviceType::LED);
     assertEqual(interpreter.get_device_info(name, 0), -1);
@@ -466,6 +504,205 @@ test(interpreter_execute_group)
     Test::min_verbosity = prevTestVerbosity;
 }
 
+test(interpreter_inline_group)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test interpreter_inline_group starting.");
+    interpreter.reset();
+    PoolString<> name("n");
+    Deque<PoolString<>> commands;
+
+    commands.push_back(PoolString<>("n IsNumber(0)"));
+    commands.push_back(PoolString<>("inc IsGroup ("));
+    commands.push_back(PoolString<>("    n MoveBy(1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("twice IsGroup ("));
+    commands.push_back(PoolString<>("    inc RunGroup()"));
+    commands.push_back(PoolString<>("    inc RunGroup(1)"));
+    commands.push_back(PoolString<>(")"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+
+    // The calls to inc are replaced by its command
+    long numCommands = interpreter.num_commands_executed();
+    interpreter.execute(PoolString<>("twice RunGroup()"));
+    assertEqual(interpreter.get_number_value(name), 2);
+    assertEqual(interpreter.num_commands_executed() - numCommands, 3);
+    interpreter.execute(PoolString<>("twice RunGroup(2)"));
+    assertEqual(interpreter.get_number_value(name), 6);
+
+    // Setting a group again is picked up by the groups it was inlined into
+    commands.clear();
+    commands.push_back(PoolString<>("inc IsGroup ("));
+    commands.push_back(PoolString<>("    n MoveBy(10)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("twice RunGroup()"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertEqual(interpreter.get_number_value(name), 26);
+
+    // Groups which run themselves are left to recurse
+    commands.clear();
+    commands.push_back(PoolString<>("count IsGroup ("));
+    commands.push_back(PoolString<>("    n MoveBy(1)"));
+    commands.push_back(PoolString<>("    If (n < 30) ("));
+    commands.push_back(PoolString<>("        count RunGroup()"));
+    commands.push_back(PoolString<>("    )"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("count RunGroup()"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertEqual(interpreter.get_number_value(name), 30);
+    interpreter.reset();
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(interpreter_tail_call)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test interpreter_tail_call starting.");
+    interpreter.reset();
+    PoolString<> name("n");
+    Deque<PoolString<>> commands;
+
+    // Far deeper than there are strings for a scope per call
+    commands.push_back(PoolString<>("n IsNumber(0)"));
+    commands.push_back(PoolString<>("count IsGroup ("));
+    commands.push_back(PoolString<>("    n MoveBy(1)"));
+    commands.push_back(PoolString<>("    If (n < 1000) ("));
+    commands.push_back(PoolString<>("        If (1) ("));
+    commands.push_back(PoolString<>("            count RunGroup()"));
+    commands.push_back(PoolString<>("        )"));
+    commands.push_back(PoolString<>("    )"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("count RunGroup()"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertEqual(interpreter.get_number_value(name), 1000);
+
+    // Else still sees the condition of the If it follows
+    commands.clear();
+    commands.push_back(PoolString<>("n IsNumber(0)"));
+    commands.push_back(PoolString<>("none IsGroup ("));
+    commands.push_back(PoolString<>("    If (0) ("));
+    commands.push_back(PoolString<>("    )"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("If (1) ("));
+    commands.push_back(PoolString<>("    If (1) ("));
+    commands.push_back(PoolString<>("        none RunGroup()"));
+    commands.push_back(PoolString<>("    )"));
+    commands.push_back(PoolString<>("    Else ("));
+    commands.push_back(PoolString<>("        n IsNumber(1)"));
+    commands.push_back(PoolString<>("    )"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("Else ("));
+    commands.push_back(PoolString<>("    n IsNumber(2)"));
+    commands.push_back(PoolString<>(")"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertEqual(interpreter.get_number_value(name), 0);
+    assertEqual(interpreter.get_prompt_prefix().c_str(), "");
+
+    interpreter.reset();
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(interpreter_name_cache)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test interpreter_name_cache starting.");
+    interpreter.reset();
+    PoolString<> name("answer");
+    Deque<PoolString<>> commands;
+
+    // Names are looked up again once numbers or devices are added,
+    // so a number with the name of a device takes over from it
+    commands.push_back(PoolString<>("answer IsNumber(x + light)"));
+    commands.push_back(PoolString<>("light IsLED(9, 40)"));
+    commands.push_back(PoolString<>("answer MoveBy(light)"));
+    commands.push_back(PoolString<>("light SetTo(60)"));
+    commands.push_back(PoolString<>("answer MoveBy(light)"));
+    commands.push_back(PoolString<>("light IsNumber(1)"));
+    commands.push_back(PoolString<>("answer MoveBy(light)"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertEqual(interpreter.get_number_value(name), 101);
+
+    interpreter.reset();
+    interpreter.execute(PoolString<>("answer IsNumber(light)"));
+    assertEqual(interpreter.get_number_value(name), 0);
+    interpreter.reset();
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(interpreter_constant)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test interpreter_constant starting.");
+    interpreter.reset();
+    PoolString<> name("answer");
+    Deque<PoolString<>> commands;
+
+    // Constants are replaced by their values as groups are entered,
+    // and are not kept in the machine state
+    commands.push_back(PoolString<>("step IsConstant(2)"));
+    commands.push_back(PoolString<>("limit IsConstant(step * 5)"));
+    commands.push_back(PoolString<>("low IsConstant(-limit)"));
+    commands.push_back(PoolString<>("answer IsNumber(low)"));
+    commands.push_back(PoolString<>("count IsGroup ("));
+    commands.push_back(PoolString<>("    If (answer < limit - step) ("));
+    commands.push_back(PoolString<>("        answer MoveBy(step) ; by step"));
+    commands.push_back(PoolString<>("        'step'"));
+    commands.push_back(PoolString<>("    )"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("count RunGroup(20)"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertTrue(interpreter.constant_exists(PoolString<>("limit")));
+    assertEqual(interpreter.get_constant_value(PoolString<>("low")), -10);
+    assertFalse(interpreter.number_exists(PoolString<>("step")));
+    assertEqual(interpreter.get_number_value(name), 8);
+    Deque<PoolString<>> groupCommands = interpreter.get_group_commands(PoolString<>("count"));
+    assertEqual(groupCommands[0].c_str(), " If (answer < 10 - 2) (");
+    assertEqual(groupCommands[1].c_str(), " answer MoveBy(2) ; by step");
+    assertEqual(groupCommands[2].c_str(), " 'step'");
+
+    // Constants can be neither changed nor taken over
+    commands.clear();
+    commands.push_back(PoolString<>("step IsConstant(3)"));
+    commands.push_back(PoolString<>("step IsNumber(3)"));
+    commands.push_back(PoolString<>("answer IsConstant(3)"));
+    commands.push_back(PoolString<>("answer MoveBy(step)"));
+    commands.push_back(PoolString<>("step SetTo(3)"));
+    commands.push_back(PoolString<>("step MoveBy(1)"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertEqual(interpreter.get_constant_value(PoolString<>("step")), 2);
+    assertFalse(interpreter.number_exists(PoolString<>("step")));
+    assertFalse(interpreter.constant_exists(name));
+    assertEqual(interpreter.get_number_value(name), 10);
+
+    interpreter.reset();
+    assertFalse(interpreter.constant_exists(PoolString<>("step")));
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
 test(interpreter_fizz_buzz)
 {
     int prevTestVerbosity = Test::min_verbosity;
@@ -608,3 +845,534 @@ test(interpreter_fizz_buzz)
 
     Test::min_verbosity = prevTestVerbosity;
 }
+
+test(interpreter_runtime)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test interpreter_runtime starting.");
+    static Allocator<>  allocA, allocB;
+    static StringPool<> stringPoolA, stringPoolB;
+    Interpreter<> interpreterA(Runtime<>(allocA, stringPoolA));
+    Interpreter<> interpreterB(Runtime<>(allocB, stringPoolB));
+    PoolString<> command;
+    PoolString<> name;
+    int allocAvailable = alloc.available();
+    int stringPoolAvailable = stringPool.available();
+
+    command = "num IsNumber(1)";
+    interpreterA.execute(command);
+    command = "num MoveBy(num + 1)";
+    interpreterA.execute(command);
+    command = "num IsNumber(5)";
+    interpreterB.execute(command);
+    name = "num";
+    assertEqual(interpreterA.get_number_value(name), 3);
+    assertEqual(interpreterB.get_number_value(name), 5);
+    // Everything the interpreters allocate comes from their own runtimes
+    assertEqual(alloc.available(), allocAvailable);
+    assertEqual(stringPool.available(), stringPoolAvailable);
+    assertTrue(allocA.available() < Sizes::alloc_size);
+    assertTrue(stringPoolB.available() < Sizes::stringpool_size);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(interpreter_reset_returns_memory)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test interpreter_reset_returns_memory starting.");
+    static Allocator<>  ownAlloc;
+    static StringPool<> ownStringPool;
+    Interpreter<> ownInterpreter(Runtime<>(ownAlloc, ownStringPool));
+    PoolString<> command;
+    PoolString<> name;
+    int allocAvailable = ownAlloc.available();
+    int stringPoolAvailable = ownStringPool.available();
+
+    command = "num IsNumber(1)";
+    ownInterpreter.execute(command);
+    command = "light IsLED(9)";
+    ownInterpreter.execute(command);
+    command = "blink IsGroup(";
+    ownInterpreter.execute(command);
+    command = "If (num = 1) (";
+    ownInterpreter.execute(command);
+    ownInterpreter.reset();
+
+    // A reset interpreter can be reused as if it were new
+    name = "num";
+    assertFalse(ownInterpreter.number_exists(name));
+    assertEqual(ownInterpreter.get_prompt_prefix().c_str(), "");
+    assertEqual(ownAlloc.available(), allocAvailable);
+    assertEqual(ownStringPool.available(), stringPoolAvailable);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(interpreter_wait)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test interpreter_wait starting.");
+    interpreter.reset();
+    interpreter.set_clock(test_clock);
+    PoolString<> name;
+    Deque<PoolString<>> commands;
+
+    // Two groups with their own timing run side by side
+    commands.push_back(PoolString<>("fast IsNumber(0)"));
+    commands.push_back(PoolString<>("slow IsNumber(0)"));
+    commands.push_back(PoolString<>("tick_fast IsGroup ("));
+    commands.push_back(PoolString<>("    fast MoveBy(1)"));
+    commands.push_back(PoolString<>("    Wait(100)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("tick_slow IsGroup ("));
+    commands.push_back(PoolString<>("    slow MoveBy(1)"));
+    commands.push_back(PoolString<>("    Wait(250)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("tick_fast RunGroup(-1)"));
+    commands.push_back(PoolString<>("tick_slow RunGroup(-1)"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertTrue(interpreter.is_waiting());
+    assertEqual(interpreter.time_until_next_event(), 100);
+    for (int i = 0; i < 10; ++i) {
+        testTimeMs += 50;
+        interpreter.update();
+    }
+    name = "fast";
+    assertEqual(interpreter.get_number_value(name), 6);
+    name = "slow";
+    assertEqual(interpreter.get_number_value(name), 3);
+    interpreter.reset();
+    assertFalse(interpreter.is_waiting());
+
+    // A wait inside a conditional keeps its scope, so the Else is skipped
+    commands.clear();
+    commands.push_back(PoolString<>("answer IsNumber(1)"));
+    commands.push_back(PoolString<>("check IsGroup ("));
+    commands.push_back(PoolString<>("    If (answer) ("));
+    commands.push_back(PoolString<>("        Wait(10)"));
+    commands.push_back(PoolString<>("        answer MoveBy(1)"));
+    commands.push_back(PoolString<>("    )"));
+    commands.push_back(PoolString<>("    Else ("));
+    commands.push_back(PoolString<>("        answer IsNumber(0)"));
+    commands.push_back(PoolString<>("    )"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("check RunGroup()"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    name = "answer";
+    assertEqual(interpreter.get_number_value(name), 1);
+    // Commands typed in the meantime run straight away
+    interpreter.execute(PoolString<>("If (0) ("));
+    interpreter.execute(PoolString<>(")"));
+    testTimeMs += 10;
+    interpreter.update();
+    assertEqual(interpreter.get_number_value(name), 2);
+    assertFalse(interpreter.is_waiting());
+
+    // Parked commands are held back while a group is being entered
+    commands.clear();
+    commands.push_back(PoolString<>("light IsLED(13, 0)"));
+    commands.push_back(PoolString<>("light SetToFor(100, 20)"));
+    commands.push_back(PoolString<>("later IsGroup ("));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    name = "light";
+    assertEqual(interpreter.get_device_info(name, 2), 100);
+    testTimeMs += 20;
+    interpreter.update();
+    assertEqual(interpreter.get_device_info(name, 2), 100);
+    interpreter.execute(PoolString<>(")"));
+    interpreter.update();
+    assertEqual(interpreter.get_device_info(name, 2), 0);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(interpreter_spawn)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test interpreter_spawn starting.");
+    interpreter.reset();
+    interpreter.set_clock(test_clock);
+    PoolString<> name;
+    Deque<PoolString<>> commands;
+
+    // Spawned groups take turns one command at a time
+    commands.push_back(PoolString<>("a IsNumber(0)"));
+    commands.push_back(PoolString<>("b IsNumber(0)"));
+    commands.push_back(PoolString<>("first IsGroup ("));
+    commands.push_back(PoolString<>("    a MoveBy(1)"));
+    commands.push_back(PoolString<>("    a MoveBy(1)"));
+    commands.push_back(PoolString<>("    a MoveBy(1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("second IsGroup ("));
+    commands.push_back(PoolString<>("    b IsNumber(a)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("both IsGroup ("));
+    commands.push_back(PoolString<>("    first Spawn()"));
+    commands.push_back(PoolString<>("    second Spawn()"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("both RunGroup()"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    name = "a";
+    assertEqual(interpreter.get_number_value(name), 3);
+    name = "b";
+    assertEqual(interpreter.get_number_value(name), 2);
+
+    // Each task keeps its own scope while the others run
+    commands.clear();
+    commands.push_back(PoolString<>("answer IsNumber(0)"));
+    commands.push_back(PoolString<>("check IsGroup ("));
+    commands.push_back(PoolString<>("    If (0) ("));
+    commands.push_back(PoolString<>("    )"));
+    commands.push_back(PoolString<>("    Else ("));
+    commands.push_back(PoolString<>("        answer MoveBy(1)"));
+    commands.push_back(PoolString<>("    )"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("checks IsGroup ("));
+    commands.push_back(PoolString<>("    check Spawn()"));
+    commands.push_back(PoolString<>("    check Spawn()"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("checks RunGroup()"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    name = "answer";
+    assertEqual(interpreter.get_number_value(name), 2);
+
+    // Spawning a group which does not exist does nothing
+    interpreter.execute(PoolString<>("non_existant_name Spawn()"));
+    assertFalse(interpreter.is_waiting());
+
+    // A parked task continues while another task keeps running
+    interpreter.reset();
+    interpreter.set_clock(ticking_test_clock);
+    commands.clear();
+    commands.push_back(PoolString<>("n IsNumber(0)"));
+    commands.push_back(PoolString<>("light IsLED(13, 0)"));
+    commands.push_back(PoolString<>("blink IsGroup ("));
+    commands.push_back(PoolString<>("    light SetToFor(100, 20)"));
+    commands.push_back(PoolString<>("    when IsNumber(n)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("count IsGroup ("));
+    commands.push_back(PoolString<>("    n MoveBy(1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("start IsGroup ("));
+    commands.push_back(PoolString<>("    blink Spawn()"));
+    commands.push_back(PoolString<>("    count RunGroup(100)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("start RunGroup()"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertFalse(interpreter.is_waiting());
+    name = "n";
+    assertEqual(interpreter.get_number_value(name), 100);
+    name = "when";
+    assertTrue(interpreter.get_number_value(name) > 0);
+    assertTrue(interpreter.get_number_value(name) < 100);
+    name = "light";
+    assertEqual(interpreter.get_device_info(name, 2), 0);
+    interpreter.set_clock(test_clock);
+
+    // Tasks which run forever keep taking turns, without using up memory
+    interpreter.reset();
+    interpreter.set_command_budget(10);
+    commands.clear();
+    commands.push_back(PoolString<>("a IsNumber(0)"));
+    commands.push_back(PoolString<>("b IsNumber(0)"));
+    commands.push_back(PoolString<>("count_a IsGroup ("));
+    commands.push_back(PoolString<>("    a MoveBy(1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("count_b IsGroup ("));
+    commands.push_back(PoolString<>("    b MoveBy(1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("forever_a IsGroup ("));
+    commands.push_back(PoolString<>("    count_a RunGroup(-1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("forever_b IsGroup ("));
+    commands.push_back(PoolString<>("    count_b RunGroup(-1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("forever_a Spawn()"));
+    commands.push_back(PoolString<>("forever_b Spawn()"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    interpreter.update();
+    int allocAvailable = alloc.available();
+    int stringPoolAvailable = stringPool.available();
+    for (int i = 0; i < 20; ++i) {
+        interpreter.update();
+    }
+    assertEqual(alloc.available(), allocAvailable);
+    assertEqual(stringPool.available(), stringPoolAvailable);
+    name = "a";
+    assertTrue(interpreter.get_number_value(name) > 20);
+    name = "b";
+    assertTrue(interpreter.get_number_value(name) > 20);
+    interpreter.set_command_budget(-1);
+    interpreter.reset();
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(interpreter_every)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test interpreter_every starting.");
+    interpreter.reset();
+    interpreter.set_clock(test_clock);
+    testTimeMs = 1000;
+    PoolString<> name;
+    Deque<PoolString<>> commands;
+
+    // The group runs straight away, and then on every period
+    commands.push_back(PoolString<>("n IsNumber(0)"));
+    commands.push_back(PoolString<>("tick IsGroup ("));
+    commands.push_back(PoolString<>("    n MoveBy(1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("tick Every(100)"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    name = "n";
+    assertEqual(interpreter.get_number_value(name), 1);
+    assertEqual(interpreter.time_until_next_event(), 100);
+
+    // Running late does not move the following deadlines
+    testTimeMs = 1105;
+    interpreter.update();
+    assertEqual(interpreter.get_number_value(name), 2);
+    assertEqual(interpreter.time_until_next_event(), 95);
+    testTimeMs = 1290;
+    interpreter.update();
+    assertEqual(interpreter.get_number_value(name), 3);
+    assertEqual(interpreter.time_until_next_event(), 10);
+
+    // Deadlines missed completely are skipped
+    testTimeMs = 1550;
+    interpreter.update();
+    assertEqual(interpreter.get_number_value(name), 4);
+    assertEqual(interpreter.time_until_next_event(), 50);
+
+    // Changes to the group apply from the run after the one already waiting
+    commands.clear();
+    commands.push_back(PoolString<>("tick IsGroup ("));
+    commands.push_back(PoolString<>("    n MoveBy(10)"));
+    commands.push_back(PoolString<>(")"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    testTimeMs = 1600;
+    interpreter.update();
+    assertEqual(interpreter.get_number_value(name), 5);
+    testTimeMs = 1700;
+    interpreter.update();
+    assertEqual(interpreter.get_number_value(name), 15);
+    interpreter.reset();
+    assertFalse(interpreter.is_waiting());
+    interpreter.execute(PoolString<>("n IsNumber(5)"));
+
+    // A period which is not above 0 does nothing
+    commands.clear();
+    commands.push_back(PoolString<>("tock IsGroup ("));
+    commands.push_back(PoolString<>("    n MoveBy(1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("tock Every(0)"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertEqual(interpreter.get_number_value(name), 5);
+    assertFalse(interpreter.is_waiting());
+
+    // Every slot is taken by a group run with Every until it is aborted
+    for (int i = 0; i < Sizes::repeat_count; ++i) {
+        interpreter.execute(PoolString<>("tock Every(100)"));
+    }
+    assertEqual(interpreter.get_number_value(name), 5 + Sizes::repeat_count);
+    interpreter.execute(PoolString<>("tock Every(100)"));
+    assertEqual(interpreter.get_number_value(name), 5 + Sizes::repeat_count);
+    interpreter.abort();
+    interpreter.execute(PoolString<>("tock Every(100)"));
+    assertEqual(interpreter.get_number_value(name), 6 + Sizes::repeat_count);
+    interpreter.reset();
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(interpreter_fade_to)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test interpreter_fade_to starting.");
+    interpreter.reset();
+    interpreter.set_clock(test_clock);
+    testTimeMs = 0;
+    PoolString<> name("light");
+    Deque<PoolString<>> commands;
+
+    // The rest of the group waits for the fade to finish
+    commands.push_back(PoolString<>("light IsLED(13, 0)"));
+    commands.push_back(PoolString<>("done IsNumber(0)"));
+    commands.push_back(PoolString<>("fade IsGroup ("));
+    commands.push_back(PoolString<>("    light FadeTo(80, 400)"));
+    commands.push_back(PoolString<>("    done IsNumber(1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("fade RunGroup()"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertTrue(interpreter.is_waiting());
+    assertEqual(interpreter.time_until_next_event(), (long)Sizes::fade_tick_ms);
+    testTimeMs = 200;
+    interpreter.update();
+    assertEqual(interpreter.get_device_info(name, 2), 40);
+    testTimeMs = 400;
+    interpreter.update();
+    assertEqual(interpreter.get_device_info(name, 2), 80);
+    name = "done";
+    assertEqual(interpreter.get_number_value(name), 1);
+    assertFalse(interpreter.is_waiting());
+
+    // Setting the LED stops its fade
+    name = "light";
+    interpreter.execute(PoolString<>("light FadeTo(0, 400, 1)"));
+    testTimeMs = 600;
+    interpreter.update();
+    assertTrue(interpreter.get_device_info(name, 2) < 80);
+    assertTrue(interpreter.get_device_info(name, 2) > 0);
+    interpreter.execute(PoolString<>("light SetTo(50)"));
+    testTimeMs = 800;
+    interpreter.update();
+    assertEqual(interpreter.get_device_info(name, 2), 50);
+
+    // Without a duration, the LED is set straight away
+    interpreter.execute(PoolString<>("light FadeTo(30)"));
+    assertEqual(interpreter.get_device_info(name, 2), 30);
+    interpreter.reset();
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(interpreter_command_budget)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test interpreter_command_budget starting.");
+    interpreter.reset();
+    interpreter.set_clock(test_clock);
+    interpreter.set_command_budget(10);
+    PoolString<> name("n");
+    Deque<PoolString<>> commands;
+
+    // Control comes back once the budget is used up
+    commands.push_back(PoolString<>("n IsNumber(0)"));
+    commands.push_back(PoolString<>("count IsGroup ("));
+    commands.push_back(PoolString<>("    n MoveBy(1)"));
+    commands.push_back(PoolString<>(")"));
+    commands.push_back(PoolString<>("count RunGroup(100)"));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertTrue(interpreter.get_number_value(name) < 100);
+    assertTrue(interpreter.is_busy());
+    assertTrue(interpreter.is_waiting());
+    assertEqual(interpreter.time_until_next_event(), 0);
+
+    // New commands run straight away, and the rest continues from update()
+    interpreter.execute(PoolString<>("m IsNumber(7)"));
+    name = "m";
+    assertEqual(interpreter.get_number_value(name), 7);
+    while (interpreter.is_busy()) {
+        interpreter.update();
+    }
+    name = "n";
+    assertEqual(interpreter.get_number_value(name), 100);
+    assertFalse(interpreter.is_waiting());
+
+    // Aborting stops everything running, but keeps what was created
+    commands.clear();
+    commands.push_back(PoolString<>("count RunGroup(-1)"));
+    commands.push_back(PoolString<>("count Every(100)"));
+    commands.push_back(PoolString<>("light IsLED(13, 0)"));
+    commands.push_back(PoolString<>("light FadeTo(100, 1000)"));
+    commands.push_back(PoolString<>("later IsGroup ("));
+    commands.push_back(PoolString<>("    If (1) ("));
+    for (auto & command : commands) {
+        interpreter.execute(command);
+    }
+    assertTrue(interpreter.is_waiting());
+    interpreter.abort();
+    assertFalse(interpreter.is_waiting());
+    assertFalse(interpreter.is_busy());
+    assertEqual(interpreter.get_prompt_prefix().c_str(), "");
+    int value = interpreter.get_number_value(name);
+    assertTrue(value > 100);
+    interpreter.update();
+    assertEqual(interpreter.get_number_value(name), value);
+    name = "count";
+    assertTrue(interpreter.group_exists(name));
+    name = "later";
+    assertFalse(interpreter.group_exists(name));
+    interpreter.set_command_budget(-1);
+    interpreter.reset();
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(interpreter_execute_tokens)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test interpreter_execute_tokens starting.");
+    interpreter.reset();
+    PoolString<> name("n");
+    PoolString<> command;
+    Tokenizer<> streamTokenizer;
+
+    // Tokens from a tokenizer in streaming mode run straight away
+    command = "n IsNumber(5)";
+    streamTokenizer.feed(command.c_str());
+    interpreter.execute(command, streamTokenizer.finish());
+    assertEqual(interpreter.get_number_value(name), 5);
+
+    // Commands which are part of a group are kept as they are
+    command = "add IsGroup (";
+    streamTokenizer.feed(command.c_str());
+    interpreter.execute(command, streamTokenizer.finish());
+    command = "n MoveBy(2)";
+    streamTokenizer.feed(command.c_str());
+    interpreter.execute(command, streamTokenizer.finish());
+    command = ")";
+    streamTokenizer.feed(command.c_str());
+    interpreter.execute(command, streamTokenizer.finish());
+    assertEqual(interpreter.get_number_value(name), 5);
+    command = "add RunGroup(3)";
+    streamTokenizer.feed(command.c_str());
+    interpreter.execute(command, streamTokenizer.finish());
+    assertEqual(interpreter.get_number_value(name), 11);
+
+    // Constants in the tokens are replaced by their values
+    command = "two IsConstant(2)";
+    streamTokenizer.feed(command.c_str());
+    interpreter.execute(command, streamTokenizer.finish());
+    command = "n MoveBy(two * -two)";
+    streamTokenizer.feed(command.c_str());
+    interpreter.execute(command, streamTokenizer.finish());
+    assertEqual(interpreter.get_number_value(name), 7);
+    interpreter.reset();
+
+    Test::min_verbosity = prevTestVerbosity;
+}
@@ -107,3 +107,110 @@ test(machine_state_group)
 
     Test::min_verbosity = prevTestVerbosity;
 }
+
+test(machine_state_inlined_group)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test machine_state_inlined_group starting.");
+    machineState.reset();
+    typedef MachineState<>::symbol_t symbol_t;
+    typedef MachineState<>::GroupCall GroupCall;
+    symbol_t inc(stringPool, "inc");
+    symbol_t twice(stringPool, "twice");
+    Deque<PoolString<>> commands;
+    Deque<GroupCall> calls;
+    Deque<PoolString<>> receivedCommands;
+
+    commands.push_back(PoolString<>("n MoveBy(1)"));
+    assertTrue(machineState.set_group(inc, commands, calls, false));
+    commands.clear();
+    commands.push_back(PoolString<>("inc RunGroup()"));
+    commands.push_back(PoolString<>("n MoveBy(2)"));
+    commands.push_back(PoolString<>("inc RunGroup()"));
+    GroupCall first = {0, inc};
+    GroupCall last = {2, inc};
+    calls.push_back(first);
+    calls.push_back(last);
+    assertTrue(machineState.set_group(twice, commands, calls, false));
+
+    // The calls found when the group was set are replaced
+    receivedCommands = machineState.get_inlined_group_commands(twice, 4);
+    assertEqual(receivedCommands.size(), 3);
+    assertEqual(receivedCommands[0].c_str(), "n MoveBy(1)");
+    assertEqual(receivedCommands[1].c_str(), "n MoveBy(2)");
+    assertEqual(receivedCommands[2].c_str(), "n MoveBy(1)");
+    receivedCommands = machineState.get_inlined_group_commands(twice, 0);
+    assertEqual(receivedCommands[0].c_str(), "inc RunGroup()");
+
+    // Groups which set groups are not inlined, nor are unknown ones
+    calls.clear();
+    assertTrue(machineState.set_group(inc, machineState.get_group_commands(inc), calls, true));
+    receivedCommands = machineState.get_inlined_group_commands(twice, 4);
+    assertEqual(receivedCommands[0].c_str(), "inc RunGroup()");
+    assertTrue(machineState.set_group(inc, machineState.get_group_commands(inc)));
+    receivedCommands = machineState.get_inlined_group_commands(twice, 4);
+    assertEqual(receivedCommands[2].c_str(), "inc RunGroup()");
+    machineState.reset();
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(machine_state_symbol)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test machine_state_symbol starting.");
+    machineState.reset();
+    int available = stringPool.available();
+    MachineState<>::symbol_t name(stringPool, "answer");
+    assertTrue(machineState.set_number(name, 42));
+    // Names are shared with the symbols they were set with
+    assertEqual(stringPool.available(), available - 1);
+    assertTrue(machineState.number_exists(name));
+    assertEqual(machineState.get_number_value(PoolString<>("answer")), 42);
+    assertFalse(machineState.device_exists(name));
+    assertFalse(machineState.set_number(MachineState<>::symbol_t(stringPool), 1));
+
+    machineState.reset();
+    assertFalse(machineState.number_exists(name));
+    assertEqual(stringPool.available(), available - 1);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(machine_state_find_value)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test machine_state_find_value starting.");
+    machineState.reset();
+    MachineState<>::symbol_t answer(stringPool, "answer");
+    MachineState<>::symbol_t light(stringPool, "light");
+    unsigned int version = machineState.names_version();
+    assertTrue(machineState.find_number_value(answer) == nullptr);
+
+    assertTrue(machineState.set_number(answer, 42));
+    assertNotEqual(machineState.names_version(), version);
+    int const * value = machineState.find_number_value(answer);
+    assertTrue(value != nullptr);
+    assertEqual(*value, 42);
+
+    // Values stay where they are while names are added and values change
+    version = machineState.names_version();
+    assertTrue(machineState.set_number(answer, 7));
+    assertEqual(machineState.names_version(), version);
+    assertTrue(machineState.set_device(light, DeviceType::LED, -1, 9, 50));
+    assertNotEqual(machineState.names_version(), version);
+    assertTrue(machineState.find_number_value(answer) == value);
+    assertEqual(*value, 7);
+    assertEqual(*machineState.find_device_info_2(light), 50);
+    assertTrue(machineState.find_device_info_2(answer) == nullptr);
+
+    version = machineState.names_version();
+    machineState.reset();
+    assertNotEqual(machineState.names_version(), version);
+    assertTrue(machineState.find_number_value(answer) == nullptr);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
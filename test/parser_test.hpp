@@ -18,7 +18,7 @@ test(parser_constructors)
     Serial.println("Test parser_constructors starting.");
     Parser<> parser1;
     Parser<> parser2(Deque<Token<>>());
-    Parser<> parser3(get_alloc, get_stringpool, Deque<Token<>>());
+    Parser<> parser3(Runtime<>(get_alloc, get_stringpool), Deque<Token<>>());
 
     Test::min_verbosity = prevTestVerbosity;
 }
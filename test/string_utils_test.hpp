@@ -48,6 +48,7 @@ test(string_utils_int_to_str)
     int prevTestVerbosity = Test::min_verbosity;
 
     Serial.println("Test string_utils_int_to_str starting.");
+    assertEqual(int_to_str(0, stringPool).c_str(), "0");
     assertEqual(int_to_str(1, stringPool).c_str(), "1");
     assertEqual(int_to_str(12, stringPool).c_str(), "12");
     assertEqual(int_to_str(123, stringPool).c_str(), "123");
@@ -98,3 +98,35 @@ test(stringpool_allocate_deallocate_idx)
 
     Test::min_verbosity = prevTestVerbosity;    
 }
+
+test(stringpool_intern)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test stringpool_intern starting.");
+    StringPool<4, 8> stringPool;
+
+    // Equal strings share one index
+    int idx = stringPool.intern("led");
+    assertTrue(stringPool.is_interned(idx));
+    assertEqual(stringPool.intern("led"), idx);
+    assertEqual(stringPool.ref_count(idx), 2);
+    assertEqual(stringPool.find_interned("led"), idx);
+    assertEqual(stringPool.available(), 3);
+
+    // Strings which are not interned are never found
+    int otherIdx = stringPool.allocate_idx();
+    stringPool.strcpy(otherIdx, "pin");
+    assertFalse(stringPool.is_interned(otherIdx));
+    assertEqual(stringPool.find_interned("pin"), -1);
+    assertNotEqual(stringPool.intern("pin"), otherIdx);
+
+    // Letting go of the last reference forgets the string
+    assertTrue(stringPool.deallocate_idx(idx));
+    assertEqual(stringPool.find_interned("led"), idx);
+    assertTrue(stringPool.deallocate_idx(idx));
+    assertFalse(stringPool.is_interned(idx));
+    assertEqual(stringPool.find_interned("led"), -1);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <kty/containers/stringpool.hpp>
+#include <kty/symbol.hpp>
+
+using namespace kty;
+
+test(symbol_intern)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test symbol_intern starting.");
+    int available = stringPool.available();
+    {
+        Symbol<> led(stringPool, "led");
+        Symbol<> sameLed(stringPool, "led");
+        Symbol<> pin(stringPool, "pin");
+        assertEqual(stringPool.available(), available - 2);
+        assertTrue(led == sameLed);
+        assertTrue(led != pin);
+        assertEqual(led.id(), sameLed.id());
+        assertEqual(led.c_str(), "led");
+
+        // Finding does not intern
+        assertTrue(Symbol<>::find(stringPool, "pin") == pin);
+        assertTrue(Symbol<>::find(stringPool, "button").is_empty());
+        assertEqual(stringPool.available(), available - 2);
+
+        // Empty symbols are not equal to anything
+        Symbol<> empty(stringPool, "");
+        assertTrue(empty.is_empty());
+        assertEqual(empty.c_str(), "");
+        assertFalse(empty == Symbol<>(stringPool));
+
+        // Copies share the name
+        Symbol<> copy(pin);
+        pin = led;
+        assertTrue(copy == Symbol<>(stringPool, "pin"));
+        assertTrue(pin == led);
+        assertEqual(stringPool.available(), available - 2);
+    }
+    assertEqual(stringPool.available(), available);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
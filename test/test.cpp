@@ -13,19 +13,28 @@ CppIOStream Serial;
 MockArduinoLog Log;
 
 #include <kty/containers/allocator.hpp>
+#include <kty/containers/concurrent_allocator.hpp>
+#include <kty/containers/concurrent_stringpool.hpp>
 #include <kty/containers/deque.hpp>
 #include <kty/containers/deque_of_deque.hpp>
 #include <kty/containers/string.hpp>
 #include <kty/containers/stringpool.hpp>
 
 #include <kty/analyzer.hpp>
+#include <kty/fader.hpp>
+#include <kty/image.hpp>
+#include <kty/image_builder.hpp>
 #include <kty/interpreter.hpp>
 #include <kty/machine_state.hpp>
 #include <kty/parser.hpp>
+#include <kty/runtime.hpp>
 #include <kty/string_utils.hpp>
+#include <kty/symbol.hpp>
+#include <kty/timer_wheel.hpp>
 #include <kty/token.hpp>
 #include <kty/tokenizer.hpp>
 #include <kty/utils.hpp>
+#include <kty/vm.hpp>
 
 using namespace kty;
 
@@ -41,19 +50,26 @@ Parser<>            parser;
 Tokenizer<>         tokenizer;
 
 #include <test/allocator_test.hpp>
+#include <test/concurrent_allocator_test.hpp>
+#include <test/concurrent_stringpool_test.hpp>
 #include <test/deque_test.hpp>
 #include <test/deque_of_deque_test.hpp>
 #include <test/string_test.hpp>
 #include <test/stringpool_test.hpp>
 
 #include <test/analyzer_test.hpp>
+#include <test/fader_test.hpp>
+#include <test/image_test.hpp>
 #include <test/interpreter_test.hpp>
 #include <test/machine_state_test.hpp>
 #include <test/parser_test.hpp>
 #include <test/string_utils_test.hpp>
+#include <test/symbol_test.hpp>
+#include <test/timer_wheel_test.hpp>
 #include <test/token_test.hpp>
 #include <test/tokenizer_test.hpp>
 #include <test/utils_test.hpp>
+#include <test/vm_test.hpp>
 
 int main(void) {
     Test::min_verbosity = TEST_VERBOSITY_TESTS_SUMMARY;
@@ -67,16 +83,22 @@ int main(void) {
 
     Test::exclude("*");
     Test::include("allocator*");
+    Test::include("concurrent*");
     Test::include("deque*");
     Test::include("string*");
 
     Test::include("analyzer*");
+    Test::include("fader*");
+    Test::include("image*");
     Test::include("interpreter*");
     Test::include("machine_state*");
     Test::include("parser*");
+    Test::include("symbol*");
+    Test::include("timer_wheel*");
     Test::include("token*");
     Test::include("tokenizer*");
     Test::include("utils*");
+    Test::include("vm*");
 
     Serial.println(F("Starting tests"));
     while (Test::remaining() > 0) {
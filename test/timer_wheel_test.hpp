@@ -0,0 +1,86 @@
+#pragma once
+
+#include <kty/containers/deque.hpp>
+#include <kty/containers/string.hpp>
+#include <kty/timer_wheel.hpp>
+
+using namespace kty;
+
+test(timer_wheel_constructor)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test timer_wheel_constructor starting.");
+    TimerWheel<> timers;
+    assertTrue(timers.is_empty());
+    assertEqual(timers.time_until_next(0), -1);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(timer_wheel_pop_due)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test timer_wheel_pop_due starting.");
+    TimerWheel<> timers;
+    Deque<PoolString<>> block;
+    Deque<PoolString<>> due;
+    int allocAvailable = alloc.available();
+
+    block.push_back(PoolString<>("first"));
+    block.push_back(PoolString<>("second"));
+    assertTrue(timers.schedule(1000, block));
+    block.clear();
+    block.push_back(PoolString<>("third"));
+    assertTrue(timers.schedule(500, block));
+    // Further than one turn of the wheel away
+    assertTrue(timers.schedule(1000 + Sizes::timer_wheel_size * Sizes::timer_tick_ms, block));
+    assertEqual(timers.size(), 4);
+    assertEqual(timers.time_until_next(0), 500);
+
+    assertFalse(timers.pop_due(499, due));
+    assertTrue(timers.pop_due(500, due));
+    assertEqual(due.size(), 1);
+    assertEqual(due[0].c_str(), "third");
+    due.clear();
+    assertFalse(timers.pop_due(999, due));
+    assertTrue(timers.pop_due(1000, due));
+    assertEqual(due.size(), 2);
+    assertEqual(due[0].c_str(), "first");
+    assertEqual(due[1].c_str(), "second");
+    due.clear();
+    assertFalse(timers.pop_due(1001, due));
+    assertEqual(timers.time_until_next(1001), Sizes::timer_wheel_size * Sizes::timer_tick_ms - 1);
+
+    // A late call still finds everything that is due
+    assertTrue(timers.pop_due(100000, due));
+    assertEqual(due.size(), 1);
+    assertTrue(timers.is_empty());
+    due.clear();
+    block.clear();
+    assertEqual(alloc.available(), allocAvailable);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(timer_wheel_wrap_around)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    
+    Serial.println("Test timer_wheel_wrap_around starting.");
+    TimerWheel<> timers;
+    Deque<PoolString<>> block;
+    Deque<PoolString<>> due;
+    unsigned long now = (unsigned long)-50;
+
+    block.push_back(PoolString<>("after_overflow"));
+    assertFalse(timers.pop_due(now, due));
+    assertTrue(timers.schedule(now + 100, block));
+    assertEqual(timers.time_until_next(now), 100);
+    assertFalse(timers.pop_due(now + 99, due));
+    assertTrue(timers.pop_due(now + 100, due));
+    assertEqual(due[0].c_str(), "after_overflow");
+
+    Test::min_verbosity = prevTestVerbosity;
+}
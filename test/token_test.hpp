@@ -100,6 +100,10 @@ test(token_type_as_c_str)
     assertEqual(token.type_as_c_str(), "CREATE_GROUP");
     token.set_type(TokenType::RUN_GROUP);
     assertEqual(token.type_as_c_str(), "RUN_GROUP");
+    token.set_type(TokenType::SPAWN);
+    assertEqual(token.type_as_c_str(), "SPAWN");
+    token.set_type(TokenType::EVERY);
+    assertEqual(token.type_as_c_str(), "EVERY");
     token.set_type(TokenType::MOVE_BY_FOR);
     assertEqual(token.type_as_c_str(), "MOVE_BY_FOR");
     token.set_type(TokenType::MOVE_BY);
@@ -108,6 +112,8 @@ test(token_type_as_c_str)
     assertEqual(token.type_as_c_str(), "SET_TO_FOR");
     token.set_type(TokenType::SET_TO);
     assertEqual(token.type_as_c_str(), "SET_TO");
+    token.set_type(TokenType::FADE_TO);
+    assertEqual(token.type_as_c_str(), "FADE_TO");
     token.set_type(TokenType::PRINT);
     assertEqual(token.type_as_c_str(), "PRINT");
     token.set_type(TokenType::WAIT);
@@ -183,6 +189,10 @@ test(token_precedence_level)
     assertEqual(token.precedence_level(), 0, token.str().c_str());
     token.set_type(TokenType::RUN_GROUP);
     assertEqual(token.precedence_level(), 0, token.str().c_str());
+    token.set_type(TokenType::SPAWN);
+    assertEqual(token.precedence_level(), 0, token.str().c_str());
+    token.set_type(TokenType::EVERY);
+    assertEqual(token.precedence_level(), 0, token.str().c_str());
     token.set_type(TokenType::MOVE_BY_FOR);
     assertEqual(token.precedence_level(), 0, token.str().c_str());
     token.set_type(TokenType::MOVE_BY);
@@ -191,6 +201,8 @@ test(token_precedence_level)
     assertEqual(token.precedence_level(), 0, token.str().c_str());
     token.set_type(TokenType::SET_TO);
     assertEqual(token.precedence_level(), 0, token.str().c_str());
+    token.set_type(TokenType::FADE_TO);
+    assertEqual(token.precedence_level(), 0, token.str().c_str());
     token.set_type(TokenType::PRINT);
     assertEqual(token.precedence_level(), 0, token.str().c_str());
     token.set_type(TokenType::WAIT);
@@ -266,6 +278,10 @@ test(token_num_function_arguments)
     assertEqual(token.num_function_arguments(), 0, token.str().c_str());
     token.set_type(TokenType::RUN_GROUP);
     assertEqual(token.num_function_arguments(), 1, token.str().c_str());
+    token.set_type(TokenType::SPAWN);
+    assertEqual(token.num_function_arguments(), 0, token.str().c_str());
+    token.set_type(TokenType::EVERY);
+    assertEqual(token.num_function_arguments(), 1, token.str().c_str());
     token.set_type(TokenType::MOVE_BY_FOR);
     assertEqual(token.num_function_arguments(), 2, token.str().c_str());
     token.set_type(TokenType::MOVE_BY);
@@ -274,6 +290,8 @@ test(token_num_function_arguments)
     assertEqual(token.num_function_arguments(), 2, token.str().c_str());
     token.set_type(TokenType::SET_TO);
     assertEqual(token.num_function_arguments(), 1, token.str().c_str());
+    token.set_type(TokenType::FADE_TO);
+    assertEqual(token.num_function_arguments(), 3, token.str().c_str());
     token.set_type(TokenType::PRINT);
     assertEqual(token.num_function_arguments(), 0, token.str().c_str());
     token.set_type(TokenType::WAIT);
@@ -548,6 +566,37 @@ test(token_precedence_comparisons)
     Test::min_verbosity = prevTestVerbosity;
 }
 
+test(token_operator_kernel)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test token_operator_kernel starting.");
+    Token<> token;
+
+    // Every operator has a kernel, and nothing else does
+    for (int type = TokenType::CREATE_NUM; type <= TokenType::UNKNOWN_TOKEN; ++type) {
+        token.set_type((TokenType)type);
+        assertEqual(token.operator_kernel() != nullptr, token.is_operator(), token.str().c_str());
+    }
+
+    token.set_type(TokenType::MATH_SUB);
+    assertEqual(token.operator_kernel()(7, 3), 4);
+    token.set_type(TokenType::MATH_POW);
+    assertEqual(token.operator_kernel()(-2, 3), -8);
+    assertEqual(token.operator_kernel()(2, -1), 1);
+    token.set_type(TokenType::LOGI_XOR);
+    assertEqual(token.operator_kernel()(1, 0), 1);
+    assertEqual(token.operator_kernel()(2, 3), 0);
+    assertEqual(token.operator_kernel()(0, 0), 0);
+    // Unary operators take their operand on the right
+    token.set_type(TokenType::UNARY_NEG);
+    assertEqual(token.operator_kernel()(0, 5), -5);
+    token.set_type(TokenType::LOGI_NOT);
+    assertEqual(token.operator_kernel()(0, 5), 0);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
 test(token_type_checkers)
 {
     int prevTestVerbosity = Test::min_verbosity;
@@ -570,6 +619,12 @@ test(token_type_checkers)
     token.set_type(TokenType::RUN_GROUP);
     assertTrue(token.is_run_group(), token.str().c_str());
     assertTrue(token.is_function(), token.str().c_str());
+    token.set_type(TokenType::SPAWN);
+    assertTrue(token.is_spawn(), token.str().c_str());
+    assertTrue(token.is_function(), token.str().c_str());
+    token.set_type(TokenType::EVERY);
+    assertTrue(token.is_every(), token.str().c_str());
+    assertTrue(token.is_function(), token.str().c_str());
     token.set_type(TokenType::MOVE_BY_FOR);
     assertTrue(token.is_move_by_for(), token.str().c_str());
     assertTrue(token.is_move_by_command(), token.str().c_str());
@@ -586,6 +641,9 @@ test(token_type_checkers)
     assertTrue(token.is_set_to(), token.str().c_str());
     assertTrue(token.is_set_to_command(), token.str().c_str());
     assertTrue(token.is_function(), token.str().c_str());
+    token.set_type(TokenType::FADE_TO);
+    assertTrue(token.is_fade_to(), token.str().c_str());
+    assertTrue(token.is_function(), token.str().c_str());
     token.set_type(TokenType::PRINT);
     assertTrue(token.is_print(), token.str().c_str());
     assertTrue(token.is_function(), token.str().c_str());
@@ -719,6 +777,12 @@ test(token_command_str_to_token_type)
     str = "RunGroup";
     assertEqual(command_str_to_token_type(str), TokenType::RUN_GROUP, str.c_str());
     assertEqual(command_str_to_token_type("RunGroup"), TokenType::RUN_GROUP);
+    str = "Spawn";
+    assertEqual(command_str_to_token_type(str), TokenType::SPAWN, str.c_str());
+    assertEqual(command_str_to_token_type("Spawn"), TokenType::SPAWN);
+    str = "Every";
+    assertEqual(command_str_to_token_type(str), TokenType::EVERY, str.c_str());
+    assertEqual(command_str_to_token_type("Every"), TokenType::EVERY);
     str = "MoveByFor";
     assertEqual(command_str_to_token_type(str), TokenType::MOVE_BY_FOR, str.c_str());
     assertEqual(command_str_to_token_type("MoveByFor"), TokenType::MOVE_BY_FOR);
@@ -731,6 +795,9 @@ test(token_command_str_to_token_type)
     str = "SetTo";
     assertEqual(command_str_to_token_type(str), TokenType::SET_TO, str.c_str());
     assertEqual(command_str_to_token_type("SetTo"), TokenType::SET_TO);
+    str = "FadeTo";
+    assertEqual(command_str_to_token_type(str), TokenType::FADE_TO, str.c_str());
+    assertEqual(command_str_to_token_type("FadeTo"), TokenType::FADE_TO);
     str = "Print";
     assertEqual(command_str_to_token_type(str), TokenType::PRINT, str.c_str());
     assertEqual(command_str_to_token_type("Print"), TokenType::PRINT);
@@ -749,6 +816,52 @@ test(token_command_str_to_token_type)
     str = "Invalid";
     assertEqual(command_str_to_token_type(str), TokenType::UNKNOWN_TOKEN, str.c_str());
     assertEqual(command_str_to_token_type("Invalid"), TokenType::UNKNOWN_TOKEN);
+    assertEqual(command_str_to_token_type("Move"), TokenType::UNKNOWN_TOKEN);
+    assertEqual(command_str_to_token_type("MoveByForever"), TokenType::UNKNOWN_TOKEN);
+    assertEqual(command_str_to_token_type("IsServo"), TokenType::UNKNOWN_TOKEN);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(token_command_word_matcher)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test token_command_word_matcher starting.");
+    CommandWordMatcher matcher;
+
+    // Every command word is recognised
+    for (int i = 0; i < numCommandWords; ++i) {
+        matcher.reset();
+        for (char const * c = commandWords[i].word; *c != '\0'; ++c) {
+            assertTrue(matcher.feed(*c), commandWords[i].word);
+        }
+        assertEqual(matcher.match_len(), (long)::strlen(commandWords[i].word), commandWords[i].word);
+        assertEqual(matcher.match_type(), commandWords[i].type, commandWords[i].word);
+    }
+
+    // The longest command word is taken, even with more letters after it
+    matcher.reset();
+    for (char const * c = "MoveByFour"; *c != '\0'; ++c) {
+        matcher.feed(*c);
+    }
+    assertEqual(matcher.match_len(), 6);
+    assertEqual(matcher.match_type(), TokenType::MOVE_BY);
+
+    // Nothing matches once no command word starts with the characters
+    matcher.reset();
+    assertTrue(matcher.feed('I'));
+    assertFalse(matcher.has_match());
+    assertFalse(matcher.feed('x'));
+    assertFalse(matcher.has_match());
+    assertEqual(matcher.match_type(), TokenType::UNKNOWN_TOKEN);
+
+    // Words longer than every command word are safe
+    matcher.reset();
+    for (char const * c = "SetToForSetToForSetToFor"; *c != '\0'; ++c) {
+        matcher.feed(*c);
+    }
+    assertEqual(matcher.match_type(), TokenType::SET_TO_FOR);
 
     Test::min_verbosity = prevTestVerbosity;
 }
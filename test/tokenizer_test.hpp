@@ -71,6 +71,10 @@ test(tokenizer_get_additional_arguments)
     
     assertEqual(tokenizer.get_additional_arguments(TokenType::RUN_GROUP, 0).c_str(), "1");
     assertEqual(tokenizer.get_additional_arguments(TokenType::RUN_GROUP, 1).c_str(), "");
+
+    assertEqual(tokenizer.get_additional_arguments(TokenType::FADE_TO, 1).c_str(), ",0,0");
+    assertEqual(tokenizer.get_additional_arguments(TokenType::FADE_TO, 2).c_str(), ",0");
+    assertEqual(tokenizer.get_additional_arguments(TokenType::FADE_TO, 3).c_str(), "");
     
     Test::min_verbosity = prevTestVerbosity;
 }
@@ -82,7 +86,7 @@ test(tokenizer_constructors)
     Serial.println("Test tokenizer_constructors starting.");
     Tokenizer<> tokenizer1;
     Tokenizer<> tokenizer2(PoolString<>());
-    Tokenizer<> tokenizer3(get_alloc, get_stringpool, PoolString<>());
+    Tokenizer<> tokenizer3(Runtime<>(get_alloc, get_stringpool), PoolString<>());
 
     Test::min_verbosity = prevTestVerbosity;
 }
@@ -226,6 +230,35 @@ test(tokenizer_tokenize_missing_function_arguments)
     generatedTokens = tokenizer.tokenize(command);
     tokenizer_check_tokens_match(generatedTokens, expectedTokens, (testName + "(tokenize) [" + command + "]").c_str());
 
+    command = "blink Spawn()";
+    expectedTokens.clear();
+    expectedTokens.push_back(Token<>(TokenType::NAME, "blink"));
+    expectedTokens.push_back(Token<>(TokenType::SPAWN));
+    expectedTokens.push_back(Token<>(TokenType::OP_PAREN));
+    expectedTokens.push_back(Token<>(TokenType::CL_PAREN));
+    expectedTokens.push_back(Token<>(TokenType::CMD_END));
+    tokenizer.set_command(command);
+    generatedTokens = tokenizer.tokenize();
+    tokenizer_check_tokens_match(generatedTokens, expectedTokens, (testName + "(set_command) [" + command + "]").c_str());
+    generatedTokens.clear();
+    generatedTokens = tokenizer.tokenize(command);
+    tokenizer_check_tokens_match(generatedTokens, expectedTokens, (testName + "(tokenize) [" + command + "]").c_str());
+
+    command = "blink Every(500)";
+    expectedTokens.clear();
+    expectedTokens.push_back(Token<>(TokenType::NAME, "blink"));
+    expectedTokens.push_back(Token<>(TokenType::EVERY));
+    expectedTokens.push_back(Token<>(TokenType::OP_PAREN));
+    expectedTokens.push_back(Token<>(TokenType::NUM_VAL, "500"));
+    expectedTokens.push_back(Token<>(TokenType::CL_PAREN));
+    expectedTokens.push_back(Token<>(TokenType::CMD_END));
+    tokenizer.set_command(command);
+    generatedTokens = tokenizer.tokenize();
+    tokenizer_check_tokens_match(generatedTokens, expectedTokens, (testName + "(set_command) [" + command + "]").c_str());
+    generatedTokens.clear();
+    generatedTokens = tokenizer.tokenize(command);
+    tokenizer_check_tokens_match(generatedTokens, expectedTokens, (testName + "(tokenize) [" + command + "]").c_str());
+
     command = "blink RunGroup(-1)";
     expectedTokens.clear();
     expectedTokens.push_back(Token<>(TokenType::NAME, "blink"));
@@ -537,6 +570,105 @@ test(tokenizer_tokenize_math_expression)
     Test::min_verbosity = prevTestVerbosity;
 }
 
+test(tokenizer_stream)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+    PoolString<> testName(stringPool, "tokenizer_stream");    
+
+    Serial.println("Test tokenizer_stream starting.");
+    Deque<Token<>> expectedTokens;
+    Deque<Token<>> generatedTokens;
+    PoolString<> command(stringPool);
+    char const * commands[] = {
+        "answer IsNumber()",
+        "light IsLED(15)",
+        "light IsLED(15, 30)",
+        "blink RunGroup()",
+        "light FadeTo(50)",
+        "x IsNumber(-(3 + 4) * 2 >= 1)",
+        "If (x <= 2) (",
+        "Print('hello   world')",
+        "lightIsLED(13)",
+        "Wait(10)Print(x)",
+        "Blah x",
+    };
+
+    // Fed one character at a time, the tokens are the same as for the whole command
+    for (char const * str : commands) {
+        command = str;
+        expectedTokens = tokenizer.tokenize(command);
+        for (char const * c = str; *c != '\0'; ++c) {
+            tokenizer.feed(*c);
+        }
+        generatedTokens = tokenizer.finish();
+        tokenizer_check_tokens_match(generatedTokens, expectedTokens, (testName + "(feed) [" + command + "]").c_str());
+    }
+
+    // Chunks can split tokens anywhere
+    command = "light IsLED(13, 50)";
+    expectedTokens = tokenizer.tokenize(command);
+    tokenizer.feed("lig");
+    tokenizer.feed("ht Is");
+    tokenizer.feed("LED(1");
+    tokenizer.feed("3, 50)");
+    generatedTokens = tokenizer.finish();
+    tokenizer_check_tokens_match(generatedTokens, expectedTokens, (testName + "(chunks) [" + command + "]").c_str());
+
+    // Comments are left out
+    command = "x IsNumber(1) ";
+    expectedTokens = tokenizer.tokenize(command);
+    tokenizer.feed("x IsNumber(1) ; (comment");
+    generatedTokens = tokenizer.finish();
+    tokenizer_check_tokens_match(generatedTokens, expectedTokens, (testName + "(comment) [" + command + "]").c_str());
+
+    // A thrown away command leaves nothing behind
+    tokenizer.feed("x IsNum");
+    tokenizer.reset_stream();
+    generatedTokens = tokenizer.finish();
+    assertEqual(generatedTokens.size(), 1);
+    assertTrue(generatedTokens.front().is_cmd_end());
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(tokenizer_shared_values)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test tokenizer_shared_values starting.");
+    PoolString<> command(stringPool, "Print(count + 42 * limit, 'done')");
+    int available = stringPool.available();
+    {
+        // Names are interned, and all the other values of a command share
+        // one string
+        Deque<Token<>> tokens = tokenizer.tokenize(command);
+        assertEqual(stringPool.available(), available - 3);
+        Deque<Token<>> moreTokens = tokenizer.tokenize(command);
+        assertEqual(stringPool.available(), available - 4);
+        moreTokens.clear();
+        assertEqual(stringPool.available(), available - 3);
+        Deque<Token<>>::Iterator it = tokens.begin();
+        ++it;
+        ++it;
+        assertEqual(it->value_c_str(), "count");
+        assertTrue(it->get_symbol() == Symbol<>(stringPool, "count"));
+        ++it;
+        ++it;
+        assertEqual(it->value_c_str(), "42");
+
+        // Copies share it as well, and copies of values stand on their own
+        Token<> copy(*it);
+        PoolString<> value(copy.get_value());
+        assertEqual(stringPool.available(), available - 4);
+        tokens.clear();
+        assertEqual(copy.value_c_str(), "42");
+        assertEqual(value.c_str(), "42");
+    }
+    assertEqual(stringPool.available(), available);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
 void tokenizer_check_tokens_match(Deque<Token<>> & generatedTokens, 
                                   Deque<Token<>> & expectedTokens, 
                                   char const * comment) {
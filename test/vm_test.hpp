@@ -0,0 +1,198 @@
+#pragma once
+
+#include <kty/containers/deque.hpp>
+#include <kty/token.hpp>
+#include <kty/vm.hpp>
+
+using namespace kty;
+
+/*!
+    @brief  Gives every name the same value, 7 unless changed.
+*/
+struct VmTestContext {
+    int nameValue = 7;
+
+    int get_token_value(Token<> const & token) {
+        return token.is_name() ? nameValue : 0;
+    }
+};
+
+test(vm_run)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test vm_run starting.");
+    VmTestContext context;
+    Vm<>::Value stack[Sizes::program_size];
+
+    // 2 - x * 3 ^ 2, with x = 7, followed by a string and -(1 < 2)
+    Deque<Token<>> postfix;
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "2"));
+    postfix.push_back(Token<>(TokenType::NAME, "x"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "3"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "2"));
+    postfix.push_back(Token<>(TokenType::MATH_POW));
+    postfix.push_back(Token<>(TokenType::MATH_MUL));
+    postfix.push_back(Token<>(TokenType::MATH_SUB));
+    postfix.push_back(Token<>(TokenType::STRING, "text"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "1"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "2"));
+    postfix.push_back(Token<>(TokenType::LESS));
+    postfix.push_back(Token<>(TokenType::UNARY_NEG));
+
+    Program<> program;
+    assertTrue(program.compile(postfix, false));
+    assertEqual(program.size(), 12);
+    assertEqual(program.max_depth(), 4);
+    assertEqual(program[0].opcode, (int)OP_PUSH_NUM);
+    assertEqual(program[1].opcode, (int)OP_PUSH_NAME);
+    assertEqual(program[4].opcode, (int)OP_POW);
+    assertEqual(program[7].opcode, (int)OP_PUSH_TOKEN);
+    assertEqual(program[11].opcode, (int)OP_NEG);
+    assertEqual(program[12].opcode, (int)OP_HALT);
+
+    // Both ways of dispatching give the same results
+    for (int threaded = 0; threaded < 2; ++threaded) {
+        Vm<> vm;
+        vm.set_threaded(threaded);
+        assertEqual(vm.is_threaded(), threaded && KTY_VM_THREADED);
+        assertEqual(vm.run(program, context, stack), 3);
+        assertEqual(stack[0].number, -61);
+        assertTrue(stack[0].token == nullptr);
+        assertEqual(stack[1].token->value_c_str(), "text");
+        assertEqual(stack[2].number, -1);
+    }
+
+    // Operators without enough operands are not compiled
+    postfix.clear();
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "1"));
+    postfix.push_back(Token<>(TokenType::MATH_ADD));
+    assertFalse(program.compile(postfix));
+    assertEqual(program.size(), 0);
+    assertEqual(Vm<>().run(program, context, stack), 0);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(vm_superinstructions)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test vm_superinstructions starting.");
+    VmTestContext context;
+    Vm<>::Value stack[Sizes::program_size];
+
+    // x % 3 = 0 & x % x = 0 | ~(x % 4)
+    Deque<Token<>> postfix;
+    postfix.push_back(Token<>(TokenType::NAME, "x"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "3"));
+    postfix.push_back(Token<>(TokenType::MATH_MOD));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "0"));
+    postfix.push_back(Token<>(TokenType::EQUALS));
+    postfix.push_back(Token<>(TokenType::NAME, "x"));
+    postfix.push_back(Token<>(TokenType::NAME, "x"));
+    postfix.push_back(Token<>(TokenType::MATH_MOD));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "0"));
+    postfix.push_back(Token<>(TokenType::EQUALS));
+    postfix.push_back(Token<>(TokenType::LOGI_AND));
+    postfix.push_back(Token<>(TokenType::NAME, "x"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "4"));
+    postfix.push_back(Token<>(TokenType::MATH_MOD));
+    postfix.push_back(Token<>(TokenType::LOGI_NOT));
+    postfix.push_back(Token<>(TokenType::LOGI_OR));
+
+    Program<> plain;
+    Program<> fused;
+    assertTrue(plain.compile(postfix, false));
+    assertTrue(fused.compile(postfix));
+    assertEqual(plain.size(), 16);
+    assertEqual(fused.size(), 9);
+    assertEqual(fused[1].opcode, (int)OP_MOD_NUM_IS_ZERO);
+    assertEqual(fused[1].value, 3);
+    assertEqual(fused[4].opcode, (int)OP_MOD_IS_ZERO);
+    assertEqual(fused[7].opcode, (int)OP_MOD_NUM_IS_ZERO);
+    assertEqual(fused[7].value, 4);
+
+    // Fusing never changes the result
+    Vm<> vm;
+    for (context.nameValue = -13; context.nameValue <= 13; ++context.nameValue) {
+        if (context.nameValue == 0) {
+            continue;
+        }
+        assertEqual(vm.run(plain, context, stack), 1);
+        int expected = stack[0].number;
+        assertEqual(vm.run(fused, context, stack), 1);
+        assertEqual(stack[0].number, expected);
+    }
+
+    // Dividing by a literal 0 is left as it is
+    postfix.clear();
+    postfix.push_back(Token<>(TokenType::NAME, "x"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "0"));
+    postfix.push_back(Token<>(TokenType::MATH_MOD));
+    assertTrue(fused.compile(postfix));
+    assertEqual(fused.size(), 3);
+    assertEqual(fused[2].opcode, (int)OP_MOD);
+
+    Test::min_verbosity = prevTestVerbosity;
+}
+
+test(vm_constant_folding)
+{
+    int prevTestVerbosity = Test::min_verbosity;
+
+    Serial.println("Test vm_constant_folding starting.");
+    VmTestContext context;
+    Vm<>::Value stack[Sizes::program_size];
+
+    // x % (2 + 1) = -(1 - 1) | 2 ^ 3 > 7
+    Deque<Token<>> postfix;
+    postfix.push_back(Token<>(TokenType::NAME, "x"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "2"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "1"));
+    postfix.push_back(Token<>(TokenType::MATH_ADD));
+    postfix.push_back(Token<>(TokenType::MATH_MOD));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "1"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "1"));
+    postfix.push_back(Token<>(TokenType::MATH_SUB));
+    postfix.push_back(Token<>(TokenType::UNARY_NEG));
+    postfix.push_back(Token<>(TokenType::EQUALS));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "2"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "3"));
+    postfix.push_back(Token<>(TokenType::MATH_POW));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "7"));
+    postfix.push_back(Token<>(TokenType::GREATER));
+    postfix.push_back(Token<>(TokenType::LOGI_OR));
+
+    // The numbers are worked out, leaving x % 3 = 0 to be fused
+    Program<> plain;
+    Program<> folded;
+    assertTrue(plain.compile(postfix, false));
+    assertTrue(folded.compile(postfix));
+    assertEqual(plain.size(), 16);
+    assertEqual(folded.size(), 4);
+    assertEqual(folded[1].opcode, (int)OP_MOD_NUM_IS_ZERO);
+    assertEqual(folded[1].value, 3);
+    assertEqual(folded[2].opcode, (int)OP_PUSH_NUM);
+    assertEqual(folded[2].value, 1);
+
+    // Folding never changes the result
+    Vm<> vm;
+    for (context.nameValue = -4; context.nameValue <= 4; ++context.nameValue) {
+        assertEqual(vm.run(plain, context, stack), 1);
+        int expected = stack[0].number;
+        assertEqual(vm.run(folded, context, stack), 1);
+        assertEqual(stack[0].number, expected);
+    }
+
+    // Dividing a number by 0 is left to run
+    postfix.clear();
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "1"));
+    postfix.push_back(Token<>(TokenType::NUM_VAL, "0"));
+    postfix.push_back(Token<>(TokenType::MATH_DIV));
+    assertTrue(folded.compile(postfix));
+    assertEqual(folded.size(), 3);
+    assertEqual(folded[2].opcode, (int)OP_DIV);
+
+    Test::min_verbosity = prevTestVerbosity;
+}